@@ -0,0 +1,165 @@
+// Loopback throughput benchmark.  Starts a server on an ephemeral
+// port and drives it with a number of client sessions, each keeping a
+// fixed number of streams in flight.  Build once with ENABLE_IO_URING
+// and once without to compare the io_uring and epoll backends.
+//
+// Usage: bench [connections] [requests per connection] [concurrent
+// streams] [server threads] [response size] [sharded]
+//
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <list>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <nghttp2/asio_http2_client.h>
+#include <nghttp2/asio_http2_server.h>
+
+using namespace nghttp2::asio_http2;
+
+namespace {
+
+struct options {
+  std::size_t connections = 64;
+  std::size_t requests = 1000;
+  std::size_t streams = 10;
+  std::size_t threads = 1;
+  std::size_t response_size = 1024;
+  bool sharded = false;
+};
+
+const char *backend() {
+#if defined(BOOST_ASIO_HAS_IO_URING_AS_DEFAULT)
+  return "io_uring";
+#elif defined(BOOST_ASIO_HAS_EPOLL)
+  return "epoll";
+#else
+  return "select/kqueue";
+#endif
+}
+
+// One client session running |opts.requests| requests, keeping
+// |opts.streams| of them in flight.
+struct connection {
+  connection(boost::asio::io_context &ioc, const std::string &port,
+             const options &opts, std::atomic<std::size_t> &completed,
+             std::atomic<std::size_t> &failed)
+      : sess(ioc, "127.0.0.1", port),
+        uri("http://127.0.0.1:" + port + "/"),
+        opts(opts),
+        completed(completed),
+        failed(failed) {
+    sess.on_connect([this](const boost::asio::ip::tcp::endpoint &) {
+      for (std::size_t i = 0; i < std::min(this->opts.streams, this->opts.requests);
+           ++i) {
+        submit();
+      }
+    });
+    sess.on_error([this](const boost::system::error_code &ec) {
+      std::cerr << "error: " << ec.message() << std::endl;
+      ++this->failed;
+    });
+  }
+
+  void submit() {
+    boost::system::error_code ec;
+    ++submitted;
+    auto req = sess.submit(ec, "GET", uri);
+    if (ec) {
+      ++failed;
+      sess.shutdown();
+      return;
+    }
+    req->on_close([this](uint32_t error_code) {
+      ++done;
+      if (error_code == NGHTTP2_NO_ERROR) {
+        ++completed;
+      } else {
+        ++failed;
+      }
+      if (submitted < opts.requests) {
+        submit();
+      } else if (done == opts.requests) {
+        sess.shutdown();
+      }
+    });
+  }
+
+  client::session sess;
+  std::string uri;
+  const options &opts;
+  std::atomic<std::size_t> &completed;
+  std::atomic<std::size_t> &failed;
+  std::size_t submitted = 0;
+  std::size_t done = 0;
+};
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  auto opts = options{};
+  if (argc > 1) opts.connections = std::stoul(argv[1]);
+  if (argc > 2) opts.requests = std::stoul(argv[2]);
+  if (argc > 3) opts.streams = std::stoul(argv[3]);
+  if (argc > 4) opts.threads = std::stoul(argv[4]);
+  if (argc > 5) opts.response_size = std::stoul(argv[5]);
+  if (argc > 6) opts.sharded = std::string(argv[6]) == "sharded";
+
+  const auto body = std::string(opts.response_size, 'x');
+
+  boost::system::error_code ec;
+  server::http2 server;
+  server.num_threads(opts.threads);
+  server.sharded(opts.sharded);
+  server.handle("/", [&body](const server::request &, const server::response &res) {
+    res.write_head(200);
+    res.end(body);
+  });
+
+  if (server.listen_and_serve(ec, "127.0.0.1", "0", true)) {
+    std::cerr << "error: " << ec.message() << std::endl;
+    return 1;
+  }
+
+  const auto port = std::to_string(server.ports().front());
+
+  std::atomic<std::size_t> completed{0};
+  std::atomic<std::size_t> failed{0};
+
+  // One client thread per server thread, connections spread evenly.
+  auto client_threads = std::vector<std::thread>{};
+  const auto start = std::chrono::steady_clock::now();
+  for (std::size_t t = 0; t < opts.threads; ++t) {
+    client_threads.emplace_back([t, &port, &opts, &completed, &failed] {
+      boost::asio::io_context ioc;
+      auto connections = std::list<connection>{};
+      for (auto c = t; c < opts.connections; c += opts.threads) {
+        connections.emplace_back(ioc, port, opts, completed, failed);
+      }
+      ioc.run();
+    });
+  }
+  for (auto &thread : client_threads) {
+    thread.join();
+  }
+  const auto elapsed = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start);
+
+  server.stop();
+  server.join();
+
+  std::cout << "backend:     " << backend() << "\n"
+            << "connections: " << opts.connections << "\n"
+            << "streams:     " << opts.streams << "\n"
+            << "threads:     " << opts.threads
+            << (opts.sharded ? " (sharded)" : "") << "\n"
+            << "completed:   " << completed << "\n"
+            << "failed:      " << failed << "\n"
+            << "elapsed:     " << elapsed.count() << " s\n"
+            << "req/s:       " << completed / elapsed.count() << std::endl;
+
+  return failed != 0;
+}
@@ -0,0 +1,150 @@
+/*
+ * nghttp2 - HTTP/2 C Library
+ *
+ * Copyright (c) 2015 Tatsuhiro Tsujikawa
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "asio_bdp_estimator.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "template.h"
+
+namespace nghttp2 {
+
+namespace asio_http2 {
+
+std::atomic<std::size_t> bdp_estimator::budget_{1_g};
+std::atomic<std::size_t> bdp_estimator::committed_{0};
+
+namespace {
+constexpr auto min_interval = std::chrono::milliseconds(100);
+constexpr auto max_interval = std::chrono::seconds(10);
+} // namespace
+
+bdp_estimator::bdp_estimator(uint32_t min_window, uint32_t max_window)
+    : min_window_(min_window),
+      max_window_(std::clamp(max_window, min_window,
+                             static_cast<uint32_t>(NGHTTP2_MAX_WINDOW_SIZE))),
+      window_(min_window),
+      estimate_(min_window / 2.),
+      bandwidth_(0),
+      accumulated_(0),
+      interval_(clock::duration::zero()),
+      opaque_{'b', 'd', 'p', 'e', 's', 't', 0, 0},
+      ping_outstanding_(false) {
+  committed_ += window_;
+}
+
+bdp_estimator::~bdp_estimator() { committed_ -= window_; }
+
+void bdp_estimator::budget(std::size_t n) { budget_ = n; }
+
+bool bdp_estimator::received(std::size_t len) {
+  accumulated_ += len;
+
+  if (ping_outstanding_) {
+    return false;
+  }
+
+  auto now = clock::now();
+  if (now < next_ping_) {
+    return false;
+  }
+
+  ping_outstanding_ = true;
+  ping_start_ = now;
+  accumulated_ = len;
+  // Tell the ACKs of successive PINGs apart.
+  ++opaque_[7];
+
+  return true;
+}
+
+const uint8_t *bdp_estimator::ping_data() const { return opaque_.data(); }
+
+bool bdp_estimator::acked(const uint8_t *opaque_data) {
+  if (!ping_outstanding_ ||
+      std::memcmp(opaque_data, opaque_.data(), opaque_.size()) != 0) {
+    return false;
+  }
+
+  ping_outstanding_ = false;
+
+  auto now = clock::now();
+  auto dt = std::chrono::duration<double>(now - ping_start_).count();
+  auto grew = false;
+  if (dt > 0) {
+    auto bw = accumulated_ / dt;
+    if (accumulated_ > estimate_ * 2 / 3 && bw > bandwidth_) {
+      estimate_ = std::max(static_cast<double>(accumulated_), estimate_ * 2);
+      bandwidth_ = bw;
+      grew = true;
+    }
+  }
+  accumulated_ = 0;
+
+  interval_ = grew ? clock::duration::zero()
+                   : std::clamp<clock::duration>(interval_ * 2, min_interval,
+                                                 max_interval);
+  next_ping_ = now + interval_;
+
+  auto target = static_cast<uint32_t>(std::clamp(
+      estimate_ * 2, static_cast<double>(min_window_),
+      static_cast<double>(max_window_)));
+
+  auto others = committed_.load() - window_;
+  auto budget = budget_.load();
+  if (others + window_ > budget) {
+    target = std::max(min_window_, window_ / 2);
+  } else if (target > window_ && others + target > budget) {
+    target = static_cast<uint32_t>(
+        std::max<std::size_t>(window_, budget - others));
+  }
+
+  if (target == window_) {
+    return false;
+  }
+
+  committed_ += target;
+  committed_ -= window_;
+  window_ = target;
+
+  return true;
+}
+
+uint32_t bdp_estimator::window() const { return window_; }
+
+int bdp_estimator::apply(nghttp2_session *session) const {
+  nghttp2_settings_entry ent{NGHTTP2_SETTINGS_INITIAL_WINDOW_SIZE, window_};
+  auto rv = nghttp2_submit_settings(session, NGHTTP2_FLAG_NONE, &ent, 1);
+  if (rv != 0) {
+    return rv;
+  }
+
+  return nghttp2_session_set_local_window_size(
+      session, NGHTTP2_FLAG_NONE, 0, static_cast<int32_t>(window_));
+}
+
+} // namespace asio_http2
+
+} // namespace nghttp2
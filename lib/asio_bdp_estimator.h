@@ -0,0 +1,110 @@
+/*
+ * nghttp2 - HTTP/2 C Library
+ *
+ * Copyright (c) 2015 Tatsuhiro Tsujikawa
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef ASIO_BDP_ESTIMATOR_H
+#define ASIO_BDP_ESTIMATOR_H
+
+#include "nghttp2_config.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include <boost/noncopyable.hpp>
+
+#include <nghttp2/nghttp2.h>
+
+namespace nghttp2 {
+
+namespace asio_http2 {
+
+/// Sizes the flow control windows of one session after the
+/// bandwidth-delay product of its connection, the way gRPC does.
+/// When DATA arrives, a PING is sent and the payload received until
+/// its ACK is a sample of the BDP.  The estimate doubles whenever a
+/// sample reaches 2/3 of it at a higher bandwidth than seen before,
+/// and the windows are set to twice the estimate, between the bounds
+/// given.  Samples which do not raise the estimate space the next
+/// PINGs further apart, up to 10 seconds.
+///
+/// The windows of all the sessions of the process together are kept
+/// under budget(); past it, windows stop growing and are halved at
+/// their next sample.  Not thread safe, except for budget().
+class bdp_estimator : private boost::noncopyable {
+public:
+  bdp_estimator(uint32_t min_window, uint32_t max_window);
+  ~bdp_estimator();
+
+  /// Sets the bound of the windows of all the sessions together.
+  static void budget(std::size_t n);
+
+  /// Accounts for |len| bytes of DATA payload received.  Returns true
+  /// if a PING carrying ping_data() should be sent now.
+  bool received(std::size_t len);
+
+  /// Returns the 8 bytes of opaque data of our PINGs.
+  const uint8_t *ping_data() const;
+
+  /// Ends the sample if |opaque_data| is that of our PING.  Returns
+  /// true if window() changed, in which case it should be applied
+  /// with apply().
+  bool acked(const uint8_t *opaque_data);
+
+  uint32_t window() const;
+
+  /// Sets the stream and connection windows of |session| to window().
+  /// Returns 0, or a negative nghttp2 error code, in which case the
+  /// estimator should be destroyed to release its share of the budget.
+  int apply(nghttp2_session *session) const;
+
+private:
+  using clock = std::chrono::steady_clock;
+
+  static std::atomic<std::size_t> budget_;
+  /// Sum of window() over all the estimators.
+  static std::atomic<std::size_t> committed_;
+
+  uint32_t min_window_;
+  uint32_t max_window_;
+  uint32_t window_;
+  /// Estimated BDP, in bytes.
+  double estimate_;
+  /// Highest bandwidth sampled, in bytes per second.
+  double bandwidth_;
+  /// Bytes received since the PING was sent.
+  std::size_t accumulated_;
+  clock::time_point ping_start_;
+  /// No PING is sent before that.
+  clock::time_point next_ping_;
+  clock::duration interval_;
+  std::array<uint8_t, 8> opaque_;
+  bool ping_outstanding_;
+};
+
+} // namespace asio_http2
+
+} // namespace nghttp2
+
+#endif // ASIO_BDP_ESTIMATOR_H
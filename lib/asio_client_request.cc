@@ -34,7 +34,7 @@ namespace nghttp2 {
 namespace asio_http2 {
 namespace client {
 
-request::request() : impl_(std::make_unique<request_impl>()) {}
+request::request(request_impl &impl) : impl_(&impl) {}
 
 request::~request() {}
 
@@ -58,8 +58,24 @@ const std::string &request::method() const { return impl_->method(); }
 
 const header_map &request::header() const { return impl_->header(); }
 
+header_view request::fields() const { return impl_->fields().view(); }
+
 void request::resume() const { impl_->resume(); }
 
+response_reader request::reader() const {
+  return response_reader(impl_->reader());
+}
+
+void request::async_write(std::string data, write_cb cb) const {
+  impl_->write(std::make_unique<buffer_body>(std::move(data)), std::move(cb));
+}
+
+void request::async_write(buffer_chain data, write_cb cb) const {
+  impl_->write(data.release(), std::move(cb));
+}
+
+void request::async_finish(write_cb cb) const { impl_->finish(std::move(cb)); }
+
 request_impl &request::impl() const { return *impl_; }
 
 } // namespace client
@@ -24,8 +24,13 @@
  */
 #include "asio_client_request_impl.h"
 
+#include <utility>
+
+#include <boost/asio/post.hpp>
+
 #include "asio_client_stream.h"
 #include "asio_client_session_impl.h"
+#include "asio_client_response_reader_impl.h"
 #include "template.h"
 
 namespace nghttp2 {
@@ -47,6 +52,10 @@ void request_impl::cancel(uint32_t error_code) {
 void request_impl::on_response(response_cb cb) { response_cb_ = std::move(cb); }
 
 void request_impl::call_on_response(response &res) {
+  if (reader_) {
+    reader_->call_on_response(res.impl());
+  }
+
   if (response_cb_) {
     response_cb_(res);
   }
@@ -63,6 +72,20 @@ void request_impl::call_on_push(request &push_req) {
 void request_impl::on_close(close_cb cb) { close_cb_ = std::move(cb); }
 
 void request_impl::call_on_close(uint32_t error_code) {
+  if (reader_) {
+    reader_->call_on_close(error_code);
+  }
+
+  if (write_cb_) {
+    post_write(std::exchange(write_cb_, nullptr),
+               boost::asio::error::operation_aborted);
+  }
+
+  if (finish_cb_) {
+    post_write(std::exchange(finish_cb_, nullptr),
+               boost::asio::error::operation_aborted);
+  }
+
   if (close_cb_) {
     close_cb_(error_code);
   }
@@ -73,6 +96,15 @@ void request_impl::on_read(generator_cb cb) { generator_cb_ = std::move(cb); }
 generator_cb::result_type request_impl::call_on_read(uint8_t *buf,
                                                      std::size_t len,
                                                      uint32_t *data_flags) {
+  if (body_) {
+    auto rv = body_->read(len, data_flags);
+    if (finish_cb_ && (*data_flags & NGHTTP2_DATA_FLAG_EOF)) {
+      // The stream may close as soon as the end of the body is sent.
+      post_write(std::exchange(finish_cb_, nullptr), {}, true);
+    }
+    return rv;
+  }
+
   if (generator_cb_) {
     return generator_cb_(buf, len, data_flags);
   }
@@ -82,16 +114,128 @@ generator_cb::result_type request_impl::call_on_read(uint8_t *buf,
   return 0;
 }
 
+void request_impl::body(std::unique_ptr<buffer_body> body) {
+  body_ = std::move(body);
+}
+
+int request_impl::call_on_send(write_buffer &wb, nghttp2_frame *frame,
+                               const uint8_t *framehd, std::size_t length) {
+  if (!body_) {
+    return NGHTTP2_ERR_CALLBACK_FAILURE;
+  }
+
+  auto rv = body_->send(wb, frame, framehd, length);
+  if (rv == 0) {
+    complete_write();
+  }
+
+  return rv;
+}
+
 void request_impl::resume() {
   auto sess = strm_->session();
   sess->resume(*strm_);
 }
 
-void request_impl::header(header_map h) { header_ = std::move(h); }
+const std::shared_ptr<response_reader_impl> &request_impl::reader() {
+  if (!reader_) {
+    reader_ = std::make_shared<response_reader_impl>(strm_);
+    strm_->response().impl().reader(reader_.get());
+  }
+
+  return reader_;
+}
+
+void request_impl::write(std::unique_ptr<buffer_body> data, write_cb cb) {
+  if (write_cb_ || finish_cb_) {
+    post_write(std::move(cb), boost::asio::error::already_started);
+    return;
+  }
+
+  if (strm_->session()->stopped()) {
+    post_write(std::move(cb), boost::asio::error::connection_aborted);
+    return;
+  }
+
+  if (!body_ || !body_->is_open()) {
+    post_write(std::move(cb), boost::asio::error::operation_not_supported);
+    return;
+  }
+
+  write_cb_ = std::move(cb);
+
+  body_->splice(*data);
+  resume();
+
+  complete_write();
+}
+
+void request_impl::finish(write_cb cb) {
+  if (write_cb_ || finish_cb_) {
+    post_write(std::move(cb), boost::asio::error::already_started);
+    return;
+  }
+
+  if (strm_->session()->stopped()) {
+    post_write(std::move(cb), boost::asio::error::connection_aborted);
+    return;
+  }
+
+  if (!body_ || !body_->is_open()) {
+    post_write(std::move(cb), boost::asio::error::operation_not_supported);
+    return;
+  }
+
+  finish_cb_ = std::move(cb);
+
+  body_->open(false);
+  resume();
+}
+
+void request_impl::abort() {
+  if (reader_) {
+    reader_->abort(boost::asio::error::connection_aborted);
+  }
+
+  if (write_cb_) {
+    post_write(std::exchange(write_cb_, nullptr),
+               boost::asio::error::connection_aborted);
+  }
+
+  if (finish_cb_) {
+    post_write(std::exchange(finish_cb_, nullptr),
+               boost::asio::error::connection_aborted);
+  }
+}
+
+void request_impl::complete_write() {
+  if (!write_cb_ || body_->left() > 0) {
+    return;
+  }
+
+  post_write(std::exchange(write_cb_, nullptr), {});
+}
+
+void request_impl::post_write(write_cb cb, const boost::system::error_code &ec,
+                              bool last) {
+  boost::asio::post(strm_->session()->executor(),
+                    [cb = std::move(cb), ec, last, token = strm_->token()]() {
+                      // The stream may be closed since.
+                      if (!ec && !last && token.expired()) {
+                        cb(boost::asio::error::operation_aborted);
+                        return;
+                      }
+                      cb(ec);
+                    });
+}
+
+void request_impl::header(header_map h) { fields_.assign(std::move(h)); }
+
+const header_map &request_impl::header() const { return fields_.map(); }
 
-header_map &request_impl::header() { return header_; }
+header_fields &request_impl::fields() { return fields_; }
 
-const header_map &request_impl::header() const { return header_; }
+const header_fields &request_impl::fields() const { return fields_; }
 
 void request_impl::stream(class stream *strm) { strm_ = strm; }
 
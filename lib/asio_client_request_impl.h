@@ -29,11 +29,15 @@
 
 #include <nghttp2/asio_http2_client.h>
 
+#include "asio_header_fields.h"
+#include "asio_write_buffer.h"
+
 namespace nghttp2 {
 namespace asio_http2 {
 namespace client {
 
 class response;
+class response_reader_impl;
 class stream;
 
 class request_impl {
@@ -60,12 +64,33 @@ public:
   generator_cb::result_type call_on_read(uint8_t *buf, std::size_t len,
                                          uint32_t *data_flags);
 
+  // Sets the request body sent without copying, used instead of the
+  // callback set by on_read().
+  void body(std::unique_ptr<buffer_body> body);
+  int call_on_send(write_buffer &wb, nghttp2_frame *frame,
+                   const uint8_t *framehd, std::size_t length);
+
   void resume();
 
+  // Returns the reader of the response, created on first use.
+  const std::shared_ptr<response_reader_impl> &reader();
+
+  // Appends |data| to the request body, which must be open, and
+  // passes to |cb| when nghttp2 took all of it.
+  void write(std::unique_ptr<buffer_body> data, write_cb cb);
+  // Ends the open request body, and passes to |cb| when nghttp2 took
+  // the end of it.
+  void finish(write_cb cb);
+
+  // Fails the pending write or finish, as the connection is lost.
+  void abort();
+
   void header(header_map h);
-  header_map &header();
   const header_map &header() const;
 
+  header_fields &fields();
+  const header_fields &fields() const;
+
   void stream(class stream *strm);
 
   void uri(uri_ref uri);
@@ -79,11 +104,25 @@ public:
   void update_header_buffer_size(size_t len);
 
 private:
-  header_map header_;
+  // Completes the pending write once nghttp2 took all of its data.
+  void complete_write();
+  // Posts |cb| with |ec| to the io_context of the session.  Unless
+  // |ec| is an error or |last|, |cb| gets
+  // boost::asio::error::operation_aborted instead if the stream is
+  // closed by the time it runs.
+  void post_write(write_cb cb, const boost::system::error_code &ec,
+                  bool last = false);
+
+  header_fields fields_;
   response_cb response_cb_;
   request_cb push_request_cb_;
   close_cb close_cb_;
   generator_cb generator_cb_;
+  std::unique_ptr<buffer_body> body_;
+  std::shared_ptr<response_reader_impl> reader_;
+  // Pending write() and finish().
+  write_cb write_cb_;
+  write_cb finish_cb_;
   class stream *strm_;
   uri_ref uri_;
   std::string method_;
@@ -34,7 +34,7 @@ namespace nghttp2 {
 namespace asio_http2 {
 namespace client {
 
-response::response() : impl_(std::make_unique<response_impl>()) {}
+response::response(response_impl &impl) : impl_(&impl) {}
 
 response::~response() {}
 
@@ -46,6 +46,8 @@ int64_t response::content_length() const { return impl_->content_length(); }
 
 const header_map &response::header() const { return impl_->header(); }
 
+header_view response::fields() const { return impl_->fields().view(); }
+
 response_impl &response::impl() const { return *impl_; }
 
 } // namespace client
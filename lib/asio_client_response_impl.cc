@@ -24,6 +24,8 @@
  */
 #include "asio_client_response_impl.h"
 
+#include "asio_client_response_reader_impl.h"
+
 #include "template.h"
 
 namespace nghttp2 {
@@ -31,16 +33,25 @@ namespace asio_http2 {
 namespace client {
 
 response_impl::response_impl()
-    : content_length_(-1), header_buffer_size_(0), status_code_(0) {}
+    : reader_(nullptr),
+      content_length_(-1),
+      header_buffer_size_(0),
+      status_code_(0) {}
 
 void response_impl::on_data(data_cb cb) { data_cb_ = std::move(cb); }
 
 void response_impl::call_on_data(const uint8_t *data, std::size_t len) {
+  if (reader_) {
+    reader_->call_on_data(data, len);
+  }
+
   if (data_cb_) {
     data_cb_(data, len);
   }
 }
 
+void response_impl::reader(response_reader_impl *reader) { reader_ = reader; }
+
 void response_impl::status_code(int sc) { status_code_ = sc; }
 
 int response_impl::status_code() const { return status_code_; }
@@ -49,9 +60,11 @@ void response_impl::content_length(int64_t n) { content_length_ = n; }
 
 int64_t response_impl::content_length() const { return content_length_; }
 
-header_map &response_impl::header() { return header_; }
+const header_map &response_impl::header() const { return fields_.map(); }
+
+header_fields &response_impl::fields() { return fields_; }
 
-const header_map &response_impl::header() const { return header_; }
+const header_fields &response_impl::fields() const { return fields_; }
 
 size_t response_impl::header_buffer_size() const { return header_buffer_size_; }
 
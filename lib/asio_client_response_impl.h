@@ -29,10 +29,14 @@
 
 #include <nghttp2/asio_http2_client.h>
 
+#include "asio_header_fields.h"
+
 namespace nghttp2 {
 namespace asio_http2 {
 namespace client {
 
+class response_reader_impl;
+
 class response_impl {
 public:
   response_impl();
@@ -44,22 +48,30 @@ public:
 
   void call_on_data(const uint8_t *data, std::size_t len);
 
+  // Sets the reader the response body is passed to, as well as to the
+  // on_data callback.
+  void reader(response_reader_impl *reader);
+
   void status_code(int sc);
   int status_code() const;
 
   void content_length(int64_t n);
   int64_t content_length() const;
 
-  header_map &header();
   const header_map &header() const;
 
+  header_fields &fields();
+  const header_fields &fields() const;
+
   size_t header_buffer_size() const;
   void update_header_buffer_size(size_t len);
 
 private:
   data_cb data_cb_;
+  // Owned by the request.
+  response_reader_impl *reader_;
 
-  header_map header_;
+  header_fields fields_;
 
   int64_t content_length_;
   size_t header_buffer_size_;
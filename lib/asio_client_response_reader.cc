@@ -0,0 +1,66 @@
+/*
+ * nghttp2 - HTTP/2 C Library
+ *
+ * Copyright (c) 2015 Tatsuhiro Tsujikawa
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "nghttp2_config.h"
+
+#include <nghttp2/asio_http2_client.h>
+
+#include "asio_client_response_reader_impl.h"
+
+#include "template.h"
+
+namespace nghttp2 {
+namespace asio_http2 {
+namespace client {
+
+response_reader::response_reader(std::shared_ptr<response_reader_impl> impl)
+    : impl_(std::move(impl)) {}
+
+int response_reader::status_code() const { return impl_->status_code(); }
+
+int64_t response_reader::content_length() const {
+  return impl_->content_length();
+}
+
+const header_map &response_reader::header() const { return impl_->header(); }
+
+void response_reader::async_read_header(write_cb cb) const {
+  impl_->read_header(std::move(cb));
+}
+
+void response_reader::async_read_some(read_cb cb) const {
+  impl_->read_some(std::move(cb));
+}
+
+void response_reader::async_read_all(std::size_t limit, read_cb cb) const {
+  impl_->read_all(limit, std::move(cb));
+}
+
+void response_reader::cancel(uint32_t error_code) const {
+  impl_->cancel(error_code);
+}
+
+} // namespace client
+} // namespace asio_http2
+} // namespace nghttp2
@@ -0,0 +1,205 @@
+/*
+ * nghttp2 - HTTP/2 C Library
+ *
+ * Copyright (c) 2015 Tatsuhiro Tsujikawa
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "asio_client_response_reader_impl.h"
+
+#include <utility>
+
+#include <boost/asio/post.hpp>
+
+#include "asio_client_stream.h"
+#include "asio_client_session_impl.h"
+#include "asio_common.h"
+
+namespace nghttp2 {
+namespace asio_http2 {
+namespace client {
+
+response_reader_impl::response_reader_impl(stream *strm)
+    : strm_(strm),
+      io_context_(strm->session()->executor()),
+      read_limit_(0),
+      content_length_(-1),
+      status_code_(0),
+      has_header_(false),
+      eof_(false),
+      read_all_(false),
+      cancelled_(false) {}
+
+void response_reader_impl::call_on_response(const response_impl &res) {
+  status_code_ = res.status_code();
+  content_length_ = res.content_length();
+  header_ = res.header();
+  has_header_ = true;
+
+  complete();
+}
+
+void response_reader_impl::call_on_data(const uint8_t *data, std::size_t len) {
+  if (len == 0) {
+    eof_ = true;
+  } else {
+    body_.append(reinterpret_cast<const char *>(data), len);
+  }
+
+  complete();
+}
+
+void response_reader_impl::call_on_close(uint32_t error_code) {
+  if (!strm_) {
+    return;
+  }
+
+  strm_ = nullptr;
+
+  if (!eof_) {
+    if (cancelled_) {
+      error_ = boost::asio::error::operation_aborted;
+    } else if (error_code != NGHTTP2_NO_ERROR) {
+      error_ = make_error_code(static_cast<nghttp2_error_code>(error_code));
+    } else {
+      error_ = boost::asio::error::connection_reset;
+    }
+  }
+
+  complete();
+}
+
+void response_reader_impl::abort(const boost::system::error_code &ec) {
+  if (!strm_) {
+    return;
+  }
+
+  strm_ = nullptr;
+
+  if (!eof_) {
+    error_ = ec;
+  }
+
+  complete();
+}
+
+void response_reader_impl::read_header(write_cb cb) {
+  if (header_cb_) {
+    post(std::move(cb), boost::asio::error::already_started);
+    return;
+  }
+
+  header_cb_ = std::move(cb);
+
+  complete();
+}
+
+void response_reader_impl::read_some(read_cb cb) {
+  if (read_cb_) {
+    post(std::move(cb), boost::asio::error::already_started);
+    return;
+  }
+
+  read_cb_ = std::move(cb);
+  read_all_ = false;
+
+  complete();
+}
+
+void response_reader_impl::read_all(std::size_t limit, read_cb cb) {
+  if (read_cb_) {
+    post(std::move(cb), boost::asio::error::already_started);
+    return;
+  }
+
+  read_cb_ = std::move(cb);
+  read_limit_ = limit;
+  read_all_ = true;
+
+  complete();
+}
+
+void response_reader_impl::complete() {
+  if (header_cb_ && (has_header_ || error_)) {
+    post(std::exchange(header_cb_, nullptr),
+         has_header_ ? boost::system::error_code{} : error_);
+  }
+
+  if (!read_cb_) {
+    return;
+  }
+
+  if (read_all_ && body_.size() > read_limit_) {
+    body_.clear();
+    read_all_ = false;
+    post(std::exchange(read_cb_, nullptr), boost::asio::error::message_size);
+    return;
+  }
+
+  if (!body_.empty() && !read_all_) {
+    post(std::exchange(read_cb_, nullptr), {}, std::exchange(body_, {}));
+    return;
+  }
+
+  if (eof_) {
+    read_all_ = false;
+    // An empty string marks the end of the body, as with data_cb.
+    post(std::exchange(read_cb_, nullptr), {}, std::exchange(body_, {}));
+    return;
+  }
+
+  if (error_) {
+    post(std::exchange(read_cb_, nullptr), error_);
+  }
+}
+
+void response_reader_impl::post(write_cb cb,
+                                const boost::system::error_code &ec) {
+  boost::asio::post(io_context_, [cb = std::move(cb), ec]() { cb(ec); });
+}
+
+void response_reader_impl::post(read_cb cb, const boost::system::error_code &ec,
+                                std::string data) {
+  boost::asio::post(io_context_,
+                    [cb = std::move(cb), ec, data = std::move(data)]() mutable {
+                      cb(ec, std::move(data));
+                    });
+}
+
+void response_reader_impl::cancel(uint32_t error_code) {
+  if (!strm_) {
+    return;
+  }
+
+  cancelled_ = true;
+  strm_->request().impl().cancel(error_code);
+}
+
+int response_reader_impl::status_code() const { return status_code_; }
+
+int64_t response_reader_impl::content_length() const {
+  return content_length_;
+}
+
+const header_map &response_reader_impl::header() const { return header_; }
+
+} // namespace client
+} // namespace asio_http2
+} // namespace nghttp2
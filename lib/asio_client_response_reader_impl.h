@@ -0,0 +1,107 @@
+/*
+ * nghttp2 - HTTP/2 C Library
+ *
+ * Copyright (c) 2015 Tatsuhiro Tsujikawa
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef ASIO_CLIENT_RESPONSE_READER_IMPL_H
+#define ASIO_CLIENT_RESPONSE_READER_IMPL_H
+
+#include "nghttp2_config.h"
+
+#include <string>
+
+#include <nghttp2/asio_http2_client.h>
+
+namespace nghttp2 {
+namespace asio_http2 {
+namespace client {
+
+class response_impl;
+class stream;
+
+// State of a response_reader, shared with the stream it reads from
+// until the stream is closed.  The response header fields and body are
+// kept here, so that they can be read after the stream is gone.
+// Completions are posted to the io_context of the session.
+class response_reader_impl {
+public:
+  explicit response_reader_impl(stream *strm);
+
+  response_reader_impl(const response_reader_impl &) = delete;
+  response_reader_impl &operator=(const response_reader_impl &) = delete;
+
+  // Called by the stream when the final response header fields are
+  // received.
+  void call_on_response(const response_impl &res);
+  // Called by the stream with a chunk of response body, or with |len|
+  // 0 at the end of the body.
+  void call_on_data(const uint8_t *data, std::size_t len);
+  // Called by the stream when it is closed with |error_code|.
+  void call_on_close(uint32_t error_code);
+  // Called when the connection is lost before the stream is closed.
+  void abort(const boost::system::error_code &ec);
+
+  void read_header(write_cb cb);
+  void read_some(read_cb cb);
+  void read_all(std::size_t limit, read_cb cb);
+
+  void cancel(uint32_t error_code);
+
+  int status_code() const;
+  int64_t content_length() const;
+  const header_map &header() const;
+
+private:
+  // Completes the pending read_header() or read, if it can.
+  void complete();
+  void post(write_cb cb, const boost::system::error_code &ec);
+  void post(read_cb cb, const boost::system::error_code &ec,
+            std::string data = "");
+
+  // nullptr once the stream is closed.
+  stream *strm_;
+  boost::asio::io_context &io_context_;
+  header_map header_;
+  // Body received and not read yet.
+  std::string body_;
+  write_cb header_cb_;
+  read_cb read_cb_;
+  // Upper bound of the body passed to read_all().
+  std::size_t read_limit_;
+  // Error which ended the stream before the end of the body.
+  boost::system::error_code error_;
+  int64_t content_length_;
+  int status_code_;
+  bool has_header_;
+  // true once the end of the body is received.
+  bool eof_;
+  // true if read_cb_ is waiting for the whole body.
+  bool read_all_;
+  // true if cancel() was called.
+  bool cancelled_;
+};
+
+} // namespace client
+} // namespace asio_http2
+} // namespace nghttp2
+
+#endif // ASIO_CLIENT_RESPONSE_READER_IMPL_H
@@ -135,8 +135,17 @@ const request *session::submit(boost::system::error_code &ec,
                                const std::string &method,
                                const std::string &uri, std::string data,
                                header_map h, priority_spec prio) const {
-  return impl_->submit(ec, method, uri, string_generator(std::move(data)),
-                       std::move(h), std::move(prio));
+  return impl_->submit(ec, method, uri, generator_cb(), std::move(h),
+                       std::move(prio),
+                       std::make_unique<buffer_body>(std::move(data)));
+}
+
+const request *session::submit(boost::system::error_code &ec,
+                               const std::string &method,
+                               const std::string &uri, buffer_chain body,
+                               header_map h, priority_spec prio) const {
+  return impl_->submit(ec, method, uri, generator_cb(), std::move(h),
+                       std::move(prio), body.release());
 }
 
 const request *session::submit(boost::system::error_code &ec,
@@ -147,10 +156,26 @@ const request *session::submit(boost::system::error_code &ec,
                        std::move(prio));
 }
 
+const request *session::submit_streaming(boost::system::error_code &ec,
+                                         const std::string &method,
+                                         const std::string &uri, header_map h,
+                                         priority_spec prio) const {
+  return impl_->submit_streaming(ec, method, uri, std::move(h),
+                                 std::move(prio));
+}
+
+void session::async_wait_connected(error_cb cb) const {
+  impl_->wait_connected(std::move(cb));
+}
+
 void session::read_timeout(std::chrono::microseconds t) {
   impl_->read_timeout(t);
 }
 
+void session::max_auto_window_size(uint32_t n) {
+  impl_->max_auto_window_size(n);
+}
+
 priority_spec::priority_spec(const int32_t stream_id, const int32_t weight,
                              const bool exclusive)
     : valid_(true) {
@@ -33,6 +33,7 @@
 #include "http2.h"
 
 #include <iostream>
+#include <boost/asio/post.hpp>
 #include <boost/url/parse.hpp>
 
 namespace nghttp2 {
@@ -42,27 +43,24 @@ namespace client {
 session_impl::session_impl(
     boost::asio::io_context &io_context,
     std::chrono::microseconds connect_timeout)
-    : wblen_(0),
-      io_context_(io_context),
+    : io_context_(io_context),
       resolver_(io_context),
       deadline_(io_context),
       connect_timeout_(connect_timeout),
       read_timeout_(std::chrono::seconds(60)),
+      max_auto_window_size_(0),
       ping_(io_context),
       session_(nullptr),
-      data_pending_(nullptr),
-      data_pendinglen_(0),
       writing_(false),
       inside_callback_(false),
       stopped_(false) {}
 
 session_impl::~session_impl() {
   // finish up all active stream
-  for (auto &p : streams_) {
-    auto &strm = p.second;
-    auto &req = strm->request().impl();
-    req.call_on_close(NGHTTP2_INTERNAL_ERROR);
-  }
+  streams_.clear([this](stream *strm) {
+    strm->request().impl().call_on_close(NGHTTP2_INTERNAL_ERROR);
+    stream_slab_.destroy(strm);
+  });
 
   nghttp2_session_del(session_);
 }
@@ -84,7 +82,15 @@ void session_impl::start_resolve(const std::string &host,
                             self->start_connect(std::move(endpoints));
                           });
 
-  deadline_.async_wait(std::bind(&session_impl::handle_deadline, self));
+  wait_deadline();
+}
+
+void session_impl::wait_deadline() {
+  deadline_.async_wait([weak = weak_from_this()] {
+    if (auto self = weak.lock()) {
+      self->handle_deadline();
+    }
+  });
 }
 
 void session_impl::handle_deadline() {
@@ -92,15 +98,13 @@ void session_impl::handle_deadline() {
     return;
   }
 
-  if (deadline_.expiry() <= std::chrono::system_clock::now()) {
-    call_error_cb(boost::asio::error::timed_out);
-    stop();
-    deadline_.expires_after(std::chrono::seconds{std::numeric_limits<int32_t>::max()});
+  if (!deadline_.expired()) {
+    wait_deadline();
     return;
   }
 
-  deadline_.async_wait(
-      std::bind(&session_impl::handle_deadline, this->shared_from_this()));
+  call_error_cb(boost::asio::error::timed_out);
+  stop();
 }
 
 void handle_ping2(const boost::system::error_code &ec, int) {}
@@ -136,6 +140,8 @@ void session_impl::connected(const tcp::endpoint& endpoint) {
 
   start_ping();
 
+  call_connect_waiters({});
+
   auto &connect_cb = on_connect();
   if (connect_cb) {
     connect_cb(endpoint);
@@ -143,6 +149,7 @@ void session_impl::connected(const tcp::endpoint& endpoint) {
 }
 
 void session_impl::not_connected(const boost::system::error_code &ec) {
+  call_connect_waiters(ec);
   call_error_cb(ec);
   stop();
 }
@@ -155,7 +162,32 @@ const connect_cb &session_impl::on_connect() const { return connect_cb_; }
 
 const error_cb &session_impl::on_error() const { return error_cb_; }
 
+void session_impl::wait_connected(error_cb cb) {
+  if (stopped_) {
+    boost::asio::post(io_context_, [cb = std::move(cb)]() {
+      cb(boost::asio::error::not_connected);
+    });
+    return;
+  }
+
+  if (session_) {
+    boost::asio::post(io_context_, [cb = std::move(cb)]() { cb({}); });
+    return;
+  }
+
+  connect_waiters_.push_back(std::move(cb));
+}
+
+void session_impl::call_connect_waiters(const boost::system::error_code &ec) {
+  for (auto &cb : connect_waiters_) {
+    boost::asio::post(io_context_, [cb = std::move(cb), ec]() { cb(ec); });
+  }
+  connect_waiters_.clear();
+}
+
 void session_impl::call_error_cb(const boost::system::error_code &ec) {
+  call_connect_waiters(ec);
+
   if (stopped_) {
     return;
   }
@@ -216,10 +248,8 @@ int on_header_callback(nghttp2_session *session, const nghttp2_frame *frame,
         res.content_length(util::parse_uint(value, valuelen));
       }
 
-      res.header().emplace(
-          std::string(name, name + namelen),
-          header_value{std::string(value, value + valuelen),
-                       (flags & NGHTTP2_NV_FLAG_NO_INDEX) != 0});
+      res.fields().add(name, namelen, value, valuelen,
+                       (flags & NGHTTP2_NV_FLAG_NO_INDEX) != 0);
     }
     break;
   }
@@ -258,10 +288,8 @@ int on_header_callback(nghttp2_session *session, const nghttp2_frame *frame,
       }
       req.update_header_buffer_size(namelen + valuelen);
 
-      req.header().emplace(
-          std::string(name, name + namelen),
-          header_value{std::string(value, value + valuelen),
-                       (flags & NGHTTP2_NV_FLAG_NO_INDEX) != 0});
+      req.fields().add(name, namelen, value, valuelen,
+                       (flags & NGHTTP2_NV_FLAG_NO_INDEX) != 0);
     }
 
     break;
@@ -325,6 +353,12 @@ int on_frame_recv_callback(nghttp2_session *session, const nghttp2_frame *frame,
 
     break;
   }
+  case NGHTTP2_PING:
+    if (frame->hd.flags & NGHTTP2_FLAG_ACK) {
+      sess->ping_acked(frame->ping.opaque_data);
+    }
+
+    break;
   }
   return 0;
 }
@@ -334,6 +368,9 @@ int on_data_chunk_recv_callback(nghttp2_session *session, uint8_t flags,
                                 size_t len, void *user_data) {
   auto sess = static_cast<session_impl *>(user_data);
   auto strm = sess->find_stream(stream_id);
+
+  sess->data_received(len);
+
   if (!strm) {
     return 0;
   }
@@ -356,6 +393,16 @@ int on_stream_close_callback(nghttp2_session *session, int32_t stream_id,
 
   return 0;
 }
+
+int send_data_callback(nghttp2_session *session, nghttp2_frame *frame,
+                       const uint8_t *framehd, size_t length,
+                       nghttp2_data_source *source, void *user_data) {
+  auto sess = static_cast<session_impl *>(user_data);
+  auto strm = static_cast<stream *>(source->ptr);
+
+  return strm->request().impl().call_on_send(sess->output(), frame, framehd,
+                                             length);
+}
 } // namespace
 
 bool session_impl::setup_session() {
@@ -373,13 +420,23 @@ bool session_impl::setup_session() {
       callbacks, on_data_chunk_recv_callback);
   nghttp2_session_callbacks_set_on_stream_close_callback(
       callbacks, on_stream_close_callback);
+  nghttp2_session_callbacks_set_send_data_callback(callbacks,
+                                                   send_data_callback);
 
-  auto rv = nghttp2_session_client_new(&session_, callbacks, this);
+  auto rv = nghttp2_session_client_new3(&session_, callbacks, this, nullptr,
+                                        arena_.mem());
   if (rv != 0) {
     call_error_cb(make_error_code(static_cast<nghttp2_error>(rv)));
     return false;
   }
 
+  if (max_auto_window_size_ > 0) {
+    nghttp2_settings_entry ent{NGHTTP2_SETTINGS_MAX_CONCURRENT_STREAMS, 100};
+    nghttp2_submit_settings(session_, NGHTTP2_FLAG_NONE, &ent, 1);
+    bdp_.emplace(NGHTTP2_INITIAL_WINDOW_SIZE, max_auto_window_size_);
+    return true;
+  }
+
   const uint32_t window_size = 256_m;
 
   std::array<nghttp2_settings_entry, 2> iv{
@@ -435,43 +492,37 @@ void session_impl::resume(stream &strm) {
 }
 
 stream *session_impl::find_stream(int32_t stream_id) {
-  auto it = streams_.find(stream_id);
-  if (it == std::end(streams_)) {
-    return nullptr;
-  }
-  return (*it).second.get();
+  return streams_.find(stream_id);
 }
 
-std::unique_ptr<stream> session_impl::pop_stream(int32_t stream_id) {
-  auto it = streams_.find(stream_id);
-  if (it == std::end(streams_)) {
+slab<stream>::pointer session_impl::pop_stream(int32_t stream_id) {
+  auto strm = streams_.erase(stream_id);
+  if (!strm) {
     return nullptr;
   }
-  auto strm = std::move((*it).second);
-  streams_.erase(it);
   if (streams_.empty()) {
     start_ping();
   }
-  return strm;
+  return slab<stream>::pointer(strm, {&stream_slab_});
 }
 
 stream *session_impl::create_push_stream(int32_t stream_id) {
   auto strm = create_stream();
   strm->stream_id(stream_id);
-  auto p = streams_.emplace(stream_id, std::move(strm));
-  assert(p.second);
+  streams_.insert(stream_id, strm.get());
   ping_.cancel();
-  return (*p.first).second.get();
+  return strm.release();
 }
 
-std::unique_ptr<stream> session_impl::create_stream() {
-  return std::make_unique<stream>(this);
+slab<stream>::pointer session_impl::create_stream() {
+  return stream_slab_.make(this);
 }
 
 const request *session_impl::submit(boost::system::error_code &ec,
                                     const std::string &method,
                                     const std::string &uri, generator_cb cb,
-                                    header_map h, priority_spec prio) {
+                                    header_map h, priority_spec prio,
+                                    std::unique_ptr<buffer_body> body) {
   ec.clear();
 
   if (stopped_) {
@@ -538,8 +589,12 @@ const request *session_impl::submit(boost::system::error_code &ec,
   nghttp2_data_provider *prdptr = nullptr;
   nghttp2_data_provider prd;
 
-  if (cb) {
-    strm->request().impl().on_read(std::move(cb));
+  if (cb || body) {
+    if (body) {
+      strm->request().impl().body(std::move(body));
+    } else {
+      strm->request().impl().on_read(std::move(cb));
+    }
     prd.source.ptr = strm.get();
     prd.read_callback = [](nghttp2_session *session, int32_t stream_id,
                            uint8_t *buf, size_t length, uint32_t *data_flags,
@@ -562,10 +617,20 @@ const request *session_impl::submit(boost::system::error_code &ec,
 
   strm->stream_id(stream_id);
 
-  auto p = streams_.emplace(stream_id, std::move(strm));
-  assert(p.second);
+  streams_.insert(stream_id, strm.get());
   ping_.cancel();
-  return &(*p.first).second->request();
+  return &strm.release()->request();
+}
+
+const request *session_impl::submit_streaming(boost::system::error_code &ec,
+                                              const std::string &method,
+                                              const std::string &uri,
+                                              header_map h,
+                                              priority_spec prio) {
+  auto body = std::make_unique<buffer_body>();
+  body->open(true);
+  return submit(ec, method, uri, generator_cb(), std::move(h), std::move(prio),
+                std::move(body));
 }
 
 void session_impl::shutdown() {
@@ -662,45 +727,18 @@ void session_impl::do_write() {
     return;
   }
 
-  if (data_pending_) {
-    std::copy_n(data_pending_, data_pendinglen_, std::begin(wb_) + wblen_);
-
-    wblen_ += data_pendinglen_;
-
-    data_pending_ = nullptr;
-    data_pendinglen_ = 0;
-  }
-
   {
     callback_guard cg(*this);
 
-    for (;;) {
-      const uint8_t *data;
-      auto n = nghttp2_session_mem_send(session_, &data);
-      if (n < 0) {
-        call_error_cb(make_error_code(static_cast<nghttp2_error>(n)));
-        stop();
-        return;
-      }
-
-      if (n == 0) {
-        break;
-      }
-
-      if (wblen_ + n > wb_.size()) {
-        data_pending_ = data;
-        data_pendinglen_ = n;
-
-        break;
-      }
-
-      std::copy_n(data, n, std::begin(wb_) + wblen_);
-
-      wblen_ += n;
+    auto rv = fill_write_buffer(wb_, session_);
+    if (rv != 0) {
+      call_error_cb(make_error_code(static_cast<nghttp2_error>(rv)));
+      stop();
+      return;
     }
   }
 
-  if (wblen_ == 0) {
+  if (wb_.empty()) {
     if (should_stop()) {
       stop();
     }
@@ -716,13 +754,14 @@ void session_impl::do_write() {
   auto self = this->shared_from_this();
 
   write_socket([self](const boost::system::error_code &ec, std::size_t n) {
+    self->wb_.clear();
+
     if (ec) {
       self->call_error_cb(ec);
       self->stop();
       return;
     }
 
-    self->wblen_ = 0;
     self->writing_ = false;
 
     self->do_write();
@@ -738,14 +777,50 @@ void session_impl::stop() {
   deadline_.cancel();
   ping_.cancel();
   stopped_ = true;
+
+  call_connect_waiters(boost::asio::error::not_connected);
+
+  // Nothing is received anymore; fail the operations waiting for it.
+  streams_.for_each(
+      [](stream *strm) { strm->request().impl().abort(); });
 }
 
 bool session_impl::stopped() const { return stopped_; }
 
+write_buffer &session_impl::output() { return wb_; }
+
 void session_impl::read_timeout(std::chrono::microseconds t) {
   read_timeout_ = t;
 }
 
+void session_impl::max_auto_window_size(uint32_t n) {
+  max_auto_window_size_ = n;
+}
+
+void session_impl::data_received(std::size_t len) {
+  if (!bdp_ || !bdp_->received(len)) {
+    return;
+  }
+
+  nghttp2_submit_ping(session_, NGHTTP2_FLAG_NONE, bdp_->ping_data());
+  signal_write();
+}
+
+void session_impl::ping_acked(const uint8_t *opaque_data) {
+  if (!bdp_ || !bdp_->acked(opaque_data)) {
+    return;
+  }
+
+  if (bdp_->apply(session_) != 0) {
+    // Stop tuning the windows, which gives back the share of the
+    // budget the new window was committed with.
+    bdp_.reset();
+    return;
+  }
+
+  signal_write();
+}
+
 } // namespace client
 } // namespace asio_http2
 } // namespace nghttp2
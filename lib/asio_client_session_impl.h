@@ -27,11 +27,20 @@
 
 #include "nghttp2_config.h"
 
+#include <optional>
+#include <vector>
+
 #include <boost/array.hpp>
 #include <boost/asio/system_timer.hpp>
 
 #include <nghttp2/asio_http2_client.h>
 
+#include "asio_bdp_estimator.h"
+#include "asio_session_arena.h"
+#include "asio_slab.h"
+#include "asio_stream_table.h"
+#include "asio_timer_wheel.h"
+#include "asio_write_buffer.h"
 #include "template.h"
 
 namespace nghttp2 {
@@ -59,19 +68,30 @@ public:
   const connect_cb &on_connect() const;
   const error_cb &on_error() const;
 
+  // Calls |cb| once the session is connected, or with the error which
+  // prevented it.  |cb| is posted to the io_context.
+  void wait_connected(error_cb cb);
+
   int write_trailer(stream &strm, header_map h);
 
   void cancel(stream &strm, uint32_t error_code);
   void resume(stream &strm);
 
-  std::unique_ptr<stream> create_stream();
-  std::unique_ptr<stream> pop_stream(int32_t stream_id);
+  slab<stream>::pointer create_stream();
+  slab<stream>::pointer pop_stream(int32_t stream_id);
   stream *create_push_stream(int32_t stream_id);
   stream *find_stream(int32_t stream_id);
 
   const request *submit(boost::system::error_code &ec,
                         const std::string &method, const std::string &uri,
-                        generator_cb cb, header_map h, priority_spec spec);
+                        generator_cb cb, header_map h, priority_spec spec,
+                        std::unique_ptr<buffer_body> body = nullptr);
+  // Submits a request whose body is written later through
+  // request_impl::write() and finish().
+  const request *submit_streaming(boost::system::error_code &ec,
+                                  const std::string &method,
+                                  const std::string &uri, header_map h,
+                                  priority_spec prio);
 
   virtual void start_connect(tcp::resolver::results_type endpoints) = 0;
   virtual tcp::socket &socket() = 0;
@@ -96,19 +116,32 @@ public:
   void do_write();
 
   void read_timeout(std::chrono::microseconds t);
+  void max_auto_window_size(uint32_t n);
+
+  // Accounts for |len| bytes of response body received, for window
+  // auto tuning.
+  void data_received(std::size_t len);
+
+  // Handles the ACK of a PING we sent.
+  void ping_acked(const uint8_t *opaque_data);
 
   void stop();
   bool stopped() const;
 
+  write_buffer &output();
+
 protected:
   boost::array<uint8_t, 8_k> rb_;
-  boost::array<uint8_t, 64_k> wb_;
-  std::size_t wblen_;
+  // Output of the write in progress.
+  write_buffer wb_;
 
 private:
   bool should_stop() const;
   bool setup_session();
   void call_error_cb(const boost::system::error_code &ec);
+  // Posts |ec| to the callbacks passed to wait_connected().
+  void call_connect_waiters(const boost::system::error_code &ec);
+  void wait_deadline();
   void handle_deadline();
   void start_ping();
   void handle_ping(const boost::system::error_code &ec);
@@ -116,21 +149,28 @@ private:
   boost::asio::io_context &io_context_;
   tcp::resolver resolver_;
 
-  std::map<int32_t, std::unique_ptr<stream>> streams_;
+  // Storage of the streams, kept for the next ones once they close.
+  slab<stream> stream_slab_;
+  stream_table<stream> streams_;
 
   connect_cb connect_cb_;
   error_cb error_cb_;
+  // Callbacks passed to wait_connected() before the session connected.
+  std::vector<error_cb> connect_waiters_;
 
-  boost::asio::system_timer deadline_;
+  timer_wheel::timer deadline_;
   std::chrono::microseconds connect_timeout_;
   std::chrono::microseconds read_timeout_;
+  // 0 for fixed windows.
+  uint32_t max_auto_window_size_;
 
   boost::asio::system_timer ping_;
 
+  // Memory of session_.
+  session_arena arena_;
   nghttp2_session *session_;
-
-  const uint8_t *data_pending_;
-  std::size_t data_pendinglen_;
+  // Set if windows are auto tuned.
+  std::optional<bdp_estimator> bdp_;
 
   bool writing_;
   bool inside_callback_;
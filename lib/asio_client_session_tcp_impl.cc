@@ -77,7 +77,7 @@ void session_tcp_impl::read_socket(
 
 void session_tcp_impl::write_socket(
     std::function<void(const boost::system::error_code &ec, std::size_t n)> h) {
-  boost::asio::async_write(socket_, boost::asio::buffer(wb_, wblen_), h);
+  boost::asio::async_write(socket_, wb_.buffers(), h);
 }
 
 void session_tcp_impl::shutdown_socket() {
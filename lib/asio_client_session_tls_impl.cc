@@ -95,7 +95,9 @@ void session_tls_impl::read_socket(
 
 void session_tls_impl::write_socket(
     std::function<void(const boost::system::error_code &ec, std::size_t n)> h) {
-  boost::asio::async_write(socket_, boost::asio::buffer(wb_, wblen_), h);
+  // ssl::stream encrypts one buffer per SSL_write; avoid a TLS record
+  // per segment.
+  boost::asio::async_write(socket_, wb_.linearize(), h);
 }
 
 void session_tls_impl::shutdown_socket() {
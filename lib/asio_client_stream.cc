@@ -24,16 +24,18 @@
  */
 #include "asio_client_stream.h"
 
-#include "asio_client_request_impl.h"
-#include "asio_client_response_impl.h"
 #include "asio_client_session_impl.h"
 
 namespace nghttp2 {
 namespace asio_http2 {
 namespace client {
 
-stream::stream(session_impl *sess) : sess_(sess), stream_id_(0) {
-  request_.impl().stream(this);
+stream::stream(session_impl *sess)
+    : request_(request_impl_),
+      response_(response_impl_),
+      sess_(sess),
+      stream_id_(0) {
+  request_impl_.stream(this);
 }
 
 void stream::stream_id(int32_t stream_id) { stream_id_ = stream_id; }
@@ -54,6 +56,13 @@ bool stream::expect_final_response() const {
   return response_.status_code() / 100 == 1;
 }
 
+std::weak_ptr<const void> stream::token() {
+  if (!token_) {
+    token_ = std::make_shared<int>(0);
+  }
+  return token_;
+}
+
 } // namespace client
 } // namespace asio_http2
 } // namespace nghttp2
@@ -29,14 +29,18 @@
 
 #include <nghttp2/asio_http2_client.h>
 
+#include <memory>
+
+#include "asio_client_request_impl.h"
+#include "asio_client_response_impl.h"
+
 namespace nghttp2 {
 namespace asio_http2 {
 namespace client {
 
-class request;
-class response;
 class session_impl;
 
+// A stream, with its request and response in the same allocation.
 class stream {
 public:
   stream(session_impl *sess);
@@ -54,10 +58,19 @@ public:
 
   bool expect_final_response() const;
 
+  // Returns a token which expires when this stream is destroyed, for
+  // the completions posted to the io_context to tell whether the
+  // stream is still there when they run.
+  std::weak_ptr<const void> token();
+
 private:
+  request_impl request_impl_;
+  response_impl response_impl_;
   nghttp2::asio_http2::client::request request_;
   nghttp2::asio_http2::client::response response_;
   session_impl *sess_;
+  // Created on first use.
+  std::shared_ptr<const void> token_;
   uint32_t stream_id_;
 };
 
@@ -32,6 +32,7 @@
 #include "util.h"
 #include "template.h"
 #include "http2.h"
+#include "asio_bdp_estimator.h"
 
 #include <boost/url/parse.hpp>
 
@@ -167,6 +168,8 @@ std::string percent_decode(const std::string &s) {
 
 std::string http_date(int64_t t) { return util::http_date(t); }
 
+void auto_window_budget(std::size_t n) { bdp_estimator::budget(n); }
+
 boost::system::error_code host_service_from_uri(boost::system::error_code &ec,
                                                 std::string &scheme,
                                                 std::string &host,
@@ -198,8 +201,10 @@ boost::system::error_code host_service_from_uri(boost::system::error_code &ec,
 }
 
 bool tls_h2_negotiated(ssl_socket &socket) {
-  auto ssl = socket.native_handle();
+  return tls_h2_negotiated(socket.native_handle());
+}
 
+bool tls_h2_negotiated(SSL *ssl) {
   const unsigned char *next_proto = nullptr;
   unsigned int next_proto_len = 0;
 
@@ -67,6 +67,9 @@ using ssl_socket = boost::asio::ssl::stream<tcp::socket>;
 
 bool tls_h2_negotiated(ssl_socket &socket);
 
+// Same as above, for a TLS connection driven directly through |ssl|.
+bool tls_h2_negotiated(SSL *ssl);
+
 } // namespace asio_http2
 
 } // namespace nghttp2
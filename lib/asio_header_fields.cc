@@ -0,0 +1,144 @@
+/*
+ * nghttp2 - HTTP/2 C Library
+ *
+ * Copyright (c) 2015 Tatsuhiro Tsujikawa
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "asio_header_fields.h"
+
+#include <algorithm>
+
+namespace nghttp2 {
+
+namespace asio_http2 {
+
+namespace {
+std::string_view as_view(const StringRef &s) {
+  return {s.c_str(), s.size()};
+}
+
+std::string_view as_view(nghttp2_rcbuf *buf) {
+  auto v = nghttp2_rcbuf_get_buf(buf);
+  return {reinterpret_cast<const char *>(v.base), v.len};
+}
+} // namespace
+
+header_fields::header_fields() : balloc_(1_k, 1_k), mapped_(0) {
+  index_.fill(-1);
+}
+
+header_fields::~header_fields() { clear(); }
+
+void header_fields::add(const uint8_t *name, size_t namelen,
+                        const uint8_t *value, size_t valuelen,
+                        bool sensitive) {
+  add_ref(as_view(make_string_ref(balloc_, StringRef{name, namelen})),
+          as_view(make_string_ref(balloc_, StringRef{value, valuelen})),
+          sensitive);
+}
+
+void header_fields::add(nghttp2_rcbuf *name, nghttp2_rcbuf *value,
+                        bool sensitive) {
+  refs_.reserve(refs_.size() + 2);
+  nghttp2_rcbuf_incref(name);
+  refs_.push_back(name);
+  nghttp2_rcbuf_incref(value);
+  refs_.push_back(value);
+
+  add_ref(as_view(name), as_view(value), sensitive);
+}
+
+void header_fields::add_ref(std::string_view name, std::string_view value,
+                            bool sensitive) {
+  auto token = http2::lookup_token(
+      reinterpret_cast<const uint8_t *>(name.data()), name.size());
+  if (token != -1 && index_[token] == -1 &&
+      fields_.size() <= static_cast<size_t>(INT16_MAX)) {
+    index_[token] = static_cast<int16_t>(fields_.size());
+  }
+
+  fields_.push_back(header_field{name, value, sensitive});
+}
+
+void header_fields::assign(header_map h) {
+  clear();
+
+  map_ = std::make_unique<header_map>(std::move(h));
+  for (auto &kv : *map_) {
+    add_ref(kv.first, kv.second.value, kv.second.sensitive);
+  }
+  mapped_ = fields_.size();
+}
+
+header_view header_fields::view() const {
+  return header_view(fields_.data(), fields_.size(), index_.data());
+}
+
+const header_map &header_fields::map() const {
+  if (!map_) {
+    map_ = std::make_unique<header_map>();
+  }
+
+  // Trailer fields may have arrived since the map was built.
+  for (; mapped_ < fields_.size(); ++mapped_) {
+    auto &f = fields_[mapped_];
+    map_->emplace(std::string(f.name),
+                  header_value{std::string(f.value), f.sensitive});
+  }
+
+  return *map_;
+}
+
+void header_fields::clear() {
+  fields_.clear();
+  index_.fill(-1);
+  map_.reset();
+  mapped_ = 0;
+  balloc_.reset();
+
+  for (auto buf : refs_) {
+    nghttp2_rcbuf_decref(buf);
+  }
+  refs_.clear();
+}
+
+const header_field *header_view::find(std::string_view name) const {
+  auto token = http2::lookup_token(
+      reinterpret_cast<const uint8_t *>(name.data()), name.size());
+  if (token != -1) {
+    auto i = index_[token];
+    return i == -1 ? nullptr : fields_ + i;
+  }
+
+  auto it = std::find_if(begin(), end(), [&name](const header_field &f) {
+    return f.name == name;
+  });
+  return it == end() ? nullptr : it;
+}
+
+std::string_view header_view::value(std::string_view name) const {
+  auto f = find(name);
+  return f ? f->value : std::string_view{};
+}
+
+} // namespace asio_http2
+
+} // namespace nghttp2
@@ -0,0 +1,93 @@
+/*
+ * nghttp2 - HTTP/2 C Library
+ *
+ * Copyright (c) 2015 Tatsuhiro Tsujikawa
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef ASIO_HEADER_FIELDS_H
+#define ASIO_HEADER_FIELDS_H
+
+#include "nghttp2_config.h"
+
+#include <memory>
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+
+#include <nghttp2/asio_http2.h>
+
+#include "allocator.h"
+#include "http2.h"
+
+namespace nghttp2 {
+
+namespace asio_http2 {
+
+/// Header fields received on one stream.  Names and values are copied
+/// into a BlockAllocator, and the position of the first field of each
+/// token known to http2::lookup_token is recorded, so that looking
+/// those up does not scan the fields.  The header_map the public API
+/// used to expose is built from the fields the first time it is asked
+/// for.  Alternatively, fields may reference the buffers nghttp2
+/// decoded them into, which are then kept until clear().
+class header_fields : private boost::noncopyable {
+public:
+  header_fields();
+  ~header_fields();
+
+  /// Appends a copy of the given field.
+  void add(const uint8_t *name, size_t namelen, const uint8_t *value,
+           size_t valuelen, bool sensitive);
+
+  /// Appends a field referencing |name| and |value|, which are kept
+  /// alive instead of copied.
+  void add(nghttp2_rcbuf *name, nghttp2_rcbuf *value, bool sensitive);
+
+  /// Replaces the fields with those of |h|, which are not copied
+  /// again.
+  void assign(header_map h);
+
+  /// Returns a view of the fields.  Adding fields invalidates it.
+  header_view view() const;
+
+  /// Returns the fields as header_map.
+  const header_map &map() const;
+
+  void clear();
+
+private:
+  void add_ref(std::string_view name, std::string_view value, bool sensitive);
+
+  BlockAllocator balloc_;
+  std::vector<header_field> fields_;
+  http2::HeaderIndex index_;
+  /// Buffers referenced by the fields, released by clear().
+  std::vector<nghttp2_rcbuf *> refs_;
+  mutable std::unique_ptr<header_map> map_;
+  /// Number of fields already in map_.
+  mutable size_t mapped_;
+};
+
+} // namespace asio_http2
+
+} // namespace nghttp2
+
+#endif // ASIO_HEADER_FIELDS_H
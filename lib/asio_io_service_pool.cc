@@ -33,16 +33,135 @@
 // Distributed under the Boost Software License, Version 1.0. (See accompanying
 // file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
 //
+#include "nghttp2_config.h"
+
 #include "asio_io_service_pool.h"
 
+#include <charconv>
+#include <fstream>
+#include <sstream>
+#include <string_view>
+
+#include <boost/asio/error.hpp>
+
+#ifdef HAVE_SYS_SENDFILE_H
+#  include <signal.h>
+#endif // HAVE_SYS_SENDFILE_H
+
+#ifdef HAVE_PTHREAD_SETAFFINITY_NP
+#  include <pthread.h>
+#  include <sched.h>
+#  include <unistd.h>
+#  include <sys/syscall.h>
+#endif // HAVE_PTHREAD_SETAFFINITY_NP
+
 namespace nghttp2 {
 
 namespace asio_http2 {
 
-io_context_pool::io_context_pool(std::size_t pool_size) : ioc{static_cast<int>(pool_size)}, concurrency{pool_size} {
+namespace {
+#ifdef HAVE_PTHREAD_SETAFFINITY_NP
+// Parses all of |s| as a CPU number into |cpu|.  Returns false if |s|
+// is not a number, or not one which fits in a cpu_set_t.
+bool parse_cpu(std::string_view s, int &cpu) {
+  auto [end, ec] = std::from_chars(s.data(), s.data() + s.size(), cpu);
+  return ec == std::errc{} && end == s.data() + s.size() && cpu >= 0 &&
+         cpu < CPU_SETSIZE;
+}
+
+// Reads the CPUs of NUMA node |node| from sysfs.  The file holds a
+// list of ranges, such as "0-3,8-11".  Sets |ec| to invalid_argument
+// if there is no such node, or if the list cannot be parsed.
+std::vector<int> numa_node_cpus(boost::system::error_code &ec, int node) {
+  ec.clear();
+
+  auto cpus = std::vector<int>{};
+  std::string list;
+  if (node >= 0) {
+    std::ifstream f("/sys/devices/system/node/node" + std::to_string(node) +
+                    "/cpulist");
+    std::getline(f, list);
+  }
+
+  std::istringstream ss(list);
+  std::string range;
+  while (std::getline(ss, range, ',')) {
+    auto s = std::string_view{range};
+    auto dash = s.find('-');
+    int first, last;
+    if (!parse_cpu(s.substr(0, dash), first) ||
+        !parse_cpu(dash == std::string_view::npos ? s : s.substr(dash + 1),
+                   last)) {
+      cpus.clear();
+      break;
+    }
+    for (auto cpu = first; cpu <= last; ++cpu) {
+      cpus.push_back(cpu);
+    }
+  }
+
+  if (cpus.empty()) {
+    ec = make_error_code(boost::system::errc::invalid_argument);
+  }
+
+  return cpus;
+}
+
+// Binds the calling thread to |cpus|, and if |node| is not -1, makes
+// it prefer memory from that NUMA node.  Placement is best effort:
+// the thread still runs if the kernel refuses.
+void place_thread(const std::vector<int> &cpus, int node) {
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (auto cpu : cpus) {
+    CPU_SET(cpu, &set);
+  }
+  pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+
+#  ifdef SYS_set_mempolicy
+  if (node != -1) {
+    // MPOL_PREFERRED from <linux/mempolicy.h>, which is not always
+    // installed.
+    constexpr int mpol_preferred = 1;
+    unsigned long mask[1024 / (8 * sizeof(unsigned long))]{};
+    constexpr auto bits = 8 * sizeof(unsigned long);
+    if (static_cast<std::size_t>(node) < sizeof(mask) * 8) {
+      mask[node / bits] |= 1UL << (node % bits);
+      syscall(SYS_set_mempolicy, mpol_preferred, mask, sizeof(mask) * 8);
+    }
+  }
+#  endif // SYS_set_mempolicy
+}
+#endif // HAVE_PTHREAD_SETAFFINITY_NP
+
+#ifdef HAVE_SYS_SENDFILE_H
+// Blocks SIGPIPE in the calling thread.  sendfile(2), unlike the
+// writes of asio, cannot pass MSG_NOSIGNAL, and would otherwise kill
+// the process when the peer has closed the connection; it fails with
+// EPIPE instead.
+void block_sigpipe() {
+  sigset_t set;
+  sigemptyset(&set);
+  sigaddset(&set, SIGPIPE);
+  pthread_sigmask(SIG_BLOCK, &set, nullptr);
+}
+#endif // HAVE_SYS_SENDFILE_H
+} // namespace
+
+io_context_pool::io_context_pool(std::size_t pool_size, bool sharded) : concurrency{pool_size} {
   if (pool_size == 0) {
     throw std::runtime_error("io_context_pool size is 0");
   }
+
+  if (sharded) {
+    // Each shard is only ever run by one thread.
+    iocs.reserve(pool_size);
+    for (std::size_t i = 0; i < pool_size; ++i) {
+      iocs.push_back(std::make_unique<boost::asio::io_context>(1));
+    }
+  } else {
+    iocs.push_back(std::make_unique<boost::asio::io_context>(static_cast<int>(pool_size)));
+  }
 }
 
 io_context_pool::~io_context_pool() {
@@ -51,10 +170,59 @@ io_context_pool::~io_context_pool() {
 }
 
 
+boost::system::error_code
+io_context_pool::affinity(boost::system::error_code &ec,
+                          const std::vector<int> &ids, bool numa) {
+  ec.clear();
+  placements.clear();
+
+#ifdef HAVE_PTHREAD_SETAFFINITY_NP
+  for (auto id : ids) {
+    if (numa) {
+      auto cpus = numa_node_cpus(ec, id);
+      if (ec) {
+        break;
+      }
+      placements.push_back({std::move(cpus), id});
+      continue;
+    }
+
+    if (id < 0 || id >= CPU_SETSIZE) {
+      ec = make_error_code(boost::system::errc::invalid_argument);
+      break;
+    }
+    placements.push_back({{id}, -1});
+  }
+#else  // !HAVE_PTHREAD_SETAFFINITY_NP
+  if (!ids.empty()) {
+    ec = boost::asio::error::operation_not_supported;
+  }
+#endif // !HAVE_PTHREAD_SETAFFINITY_NP
+
+  if (ec) {
+    placements.clear();
+  }
+
+  return ec;
+}
+
 void io_context_pool::run(bool asynchronous) {
   // Create a pool of threads to run handlers posted to the io_context
   threads.reserve(concurrency);
-  for (std::size_t i = 0; i < concurrency; ++i) threads.emplace_back([this] {ioc.run();});
+  for (std::size_t i = 0; i < concurrency; ++i) {
+    threads.emplace_back([this, i] {
+#ifdef HAVE_SYS_SENDFILE_H
+      block_sigpipe();
+#endif // HAVE_SYS_SENDFILE_H
+#ifdef HAVE_PTHREAD_SETAFFINITY_NP
+      if (!placements.empty()) {
+        const auto &p = placements[i % placements.size()];
+        place_thread(p.cpus, p.node);
+      }
+#endif // HAVE_PTHREAD_SETAFFINITY_NP
+      executor(i).run();
+    });
+  }
 
   if (!asynchronous) {
     join();
@@ -67,12 +235,20 @@ void io_context_pool::join() {
 }
 
 void io_context_pool::stop() {
-  // Signal the io_context to stop processing.
-  ioc.stop();
+  // Signal the io_context objects to stop processing.
+  for (auto &ioc : iocs) ioc->stop();
 }
 
 boost::asio::io_context &io_context_pool::executor() {
-  return ioc;
+  return *iocs.front();
+}
+
+boost::asio::io_context &io_context_pool::executor(std::size_t n) {
+  return *iocs[n % iocs.size()];
+}
+
+std::size_t io_context_pool::size() const {
+  return iocs.size();
 }
 
 } // namespace asio_http2
@@ -37,11 +37,13 @@
 #ifndef ASIO_io_context_POOL_H
 #define ASIO_io_context_POOL_H
 
+#include <memory>
 #include <thread>
 #include <vector>
 
 #include <boost/noncopyable.hpp>
 #include <boost/asio/io_context.hpp>
+#include <boost/system/error_code.hpp>
 
 #include <nghttp2/asio_http2.h>
 
@@ -50,12 +52,24 @@ namespace nghttp2 {
 namespace asio_http2 {
 
 /// A pool of io_context objects.
+///
+/// By default all threads share a single io_context.  If |sharded|
+/// is true, each thread runs its own io_context instead, so that
+/// handlers for a given shard never migrate across threads and the
+/// threads do not contend on a common scheduler queue.
 class io_context_pool : boost::noncopyable {
 public:
   /// Construct the io_context pool.
-  explicit io_context_pool(std::size_t pool_size);
+  explicit io_context_pool(std::size_t pool_size, bool sharded = false);
   ~io_context_pool();
 
+  /// Pins thread i of the pool to |ids|[i % |ids|.size()].  If
+  /// |numa| is false, the ids are CPU numbers; otherwise they are NUMA
+  /// node numbers and the thread may run on any CPU of that node, and
+  /// prefers allocating memory from it.  Must be called before run().
+  boost::system::error_code affinity(boost::system::error_code &ec,
+                                     const std::vector<int> &ids, bool numa);
+
   /// Run all io_context objects in the pool.
   void run(bool asynchronous = false);
 
@@ -65,16 +79,34 @@ public:
   /// Join on all io_context threads in the pool.
   void join();
 
-  /// Get the io_context to use.
+  /// Get the io_context to use.  In sharded mode this is the first
+  /// shard.
   boost::asio::io_context &executor();
 
+  /// Get the io_context of shard |n|.  Without sharding there is only
+  /// one io_context, which is returned for every |n|.
+  boost::asio::io_context &executor(std::size_t n);
+
+  /// Returns the number of io_context objects in the pool.
+  std::size_t size() const;
+
 private:
-  /// The io_context to use
-  boost::asio::io_context ioc;
+  /// The io_context objects to use.  It holds one element unless
+  /// sharded.
+  std::vector<std::unique_ptr<boost::asio::io_context>> iocs;
 
   /// Threads to share handlers posted to the io_context
   std::vector<std::thread> threads;
 
+  /// Placement of each thread as a list of CPU numbers, and the NUMA
+  /// node to prefer for memory allocation or -1.  Empty if threads are
+  /// not pinned.
+  struct placement {
+    std::vector<int> cpus;
+    int node;
+  };
+  std::vector<placement> placements;
+
   /// The desired number of threads on which the io_context run is spawned
   std::size_t concurrency{0};
 };
@@ -0,0 +1,160 @@
+/*
+ * nghttp2 - HTTP/2 C Library
+ *
+ * Copyright (c) 2015 Tatsuhiro Tsujikawa
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "asio_ktls_stream.h"
+
+namespace nghttp2 {
+namespace asio_http2 {
+
+ktls_stream::~ktls_stream() {
+  if (ssl_) {
+    SSL_free(ssl_);
+  }
+}
+
+bool ktls_stream::reset() {
+  if (!ssl_) {
+    return false;
+  }
+
+  auto ctx = SSL_get_SSL_CTX(ssl_);
+  SSL_free(ssl_);
+  ssl_ = SSL_new(ctx);
+  ktls_send_ = false;
+  ktls_recv_ = false;
+  init();
+
+  return ssl_ != nullptr;
+}
+
+void ktls_stream::init() {
+  if (!ssl_) {
+    return;
+  }
+
+  // Same modes as boost::asio::ssl::stream: a write is retried with
+  // the remaining part of the buffer, which may have moved.
+  SSL_set_mode(ssl_, SSL_MODE_ENABLE_PARTIAL_WRITE |
+                         SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+  SSL_clear_mode(ssl_, SSL_MODE_AUTO_RETRY);
+
+#ifdef SSL_OP_ENABLE_KTLS
+  SSL_set_options(ssl_, SSL_OP_ENABLE_KTLS);
+#endif // SSL_OP_ENABLE_KTLS
+}
+
+boost::system::error_code ktls_stream::start_handshake(
+    boost::system::error_code &ec,
+    boost::asio::ssl::stream_base::handshake_type type) {
+  ec.clear();
+
+  if (!ssl_) {
+    ec = boost::system::error_code(ERR_get_error(),
+                                   boost::asio::error::get_ssl_category());
+    return ec;
+  }
+
+  // OpenSSL does the socket I/O; it must never block the thread.
+  if (socket_.native_non_blocking(true, ec)) {
+    return ec;
+  }
+
+  if (SSL_set_fd(ssl_, socket_.native_handle()) != 1) {
+    ec = boost::system::error_code(ERR_get_error(),
+                                   boost::asio::error::get_ssl_category());
+    return ec;
+  }
+
+  if (type == boost::asio::ssl::stream_base::server) {
+    SSL_set_accept_state(ssl_);
+  } else {
+    SSL_set_connect_state(ssl_);
+  }
+
+  return ec;
+}
+
+void ktls_stream::handshake_done() {
+#if defined(SSL_OP_ENABLE_KTLS) && !defined(OPENSSL_NO_KTLS)
+  ktls_recv_ = BIO_get_ktls_recv(SSL_get_rbio(ssl_)) == 1;
+  // SSL_read() in userspace may write records of its own, such as
+  // alerts or KeyUpdate responses, through the BIO, which would mix
+  // with plaintext written to the socket directly.  Writes bypass
+  // OpenSSL only if the kernel handles both directions.
+  ktls_send_ = ktls_recv_ && BIO_get_ktls_send(SSL_get_wbio(ssl_)) == 1;
+#endif // SSL_OP_ENABLE_KTLS && !OPENSSL_NO_KTLS
+}
+
+std::size_t ktls_stream::read_some(boost::asio::mutable_buffer buf,
+                                   boost::system::error_code &ec) {
+  ec.clear();
+
+  if (buf.size() == 0) {
+    return 0;
+  }
+
+  std::size_t n = 0;
+
+  ERR_clear_error();
+  errno = 0;
+  auto rv = SSL_read_ex(ssl_, buf.data(), buf.size(), &n);
+  if (rv > 0) {
+    return n;
+  }
+
+  auto err = SSL_get_error(ssl_, rv);
+  if (err == SSL_ERROR_WANT_READ || err == SSL_ERROR_WANT_WRITE) {
+    ec = boost::asio::error::would_block;
+  } else {
+    ec = error(err);
+  }
+
+  return 0;
+}
+
+boost::system::error_code ktls_stream::error(int err) const {
+  switch (err) {
+  case SSL_ERROR_ZERO_RETURN:
+    return boost::asio::error::eof;
+  case SSL_ERROR_SYSCALL:
+    if (auto e = ERR_get_error(); e != 0) {
+      return boost::system::error_code(static_cast<int>(e),
+                                       boost::asio::error::get_ssl_category());
+    }
+    if (errno != 0) {
+      return boost::system::error_code(errno,
+                                       boost::system::system_category());
+    }
+    return boost::asio::ssl::error::stream_truncated;
+  default:
+    if (auto e = ERR_get_error(); e != 0) {
+      return boost::system::error_code(static_cast<int>(e),
+                                       boost::asio::error::get_ssl_category());
+    }
+    return boost::asio::ssl::error::stream_truncated;
+  }
+}
+
+} // namespace asio_http2
+} // namespace nghttp2
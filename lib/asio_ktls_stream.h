@@ -0,0 +1,240 @@
+/*
+ * nghttp2 - HTTP/2 C Library
+ *
+ * Copyright (c) 2015 Tatsuhiro Tsujikawa
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef ASIO_KTLS_STREAM_H
+#define ASIO_KTLS_STREAM_H
+
+#include "nghttp2_config.h"
+
+#include <cerrno>
+
+#include <boost/noncopyable.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/ssl.hpp>
+
+namespace nghttp2 {
+
+namespace asio_http2 {
+
+/// A TLS stream which lets OpenSSL do its own socket I/O through a
+/// socket BIO, instead of going through the memory BIO of
+/// boost::asio::ssl::stream.  This is what allows OpenSSL to move the
+/// record layer into the kernel (kTLS) once the handshake is done.
+/// After that, plaintext written to next_layer() is encrypted by the
+/// kernel, so that gathered writes and sendfile(2) work over TLS.  If
+/// OpenSSL or the kernel cannot enable kTLS, the stream keeps
+/// encrypting in userspace.
+///
+/// The operations complete through the executor of the socket, and
+/// only one read and one write may be outstanding at a time.
+class ktls_stream : private boost::noncopyable {
+public:
+  using executor_type = boost::asio::ip::tcp::socket::executor_type;
+  using next_layer_type = boost::asio::ip::tcp::socket;
+  using lowest_layer_type = next_layer_type::lowest_layer_type;
+
+  template <typename Executor>
+  ktls_stream(const Executor &ex, boost::asio::ssl::context &tls_ctx)
+      : socket_(ex),
+        ssl_(SSL_new(tls_ctx.native_handle())),
+        ktls_send_(false),
+        ktls_recv_(false) {
+    init();
+  }
+
+  ~ktls_stream();
+
+  executor_type get_executor() { return socket_.get_executor(); }
+  next_layer_type &next_layer() { return socket_; }
+  lowest_layer_type &lowest_layer() { return socket_.lowest_layer(); }
+  SSL *native_handle() { return ssl_; }
+
+  /// Replaces the SSL object by a new one of the same SSL_CTX, so that
+  /// the stream can be used for another connection once the socket is
+  /// closed.  Returns false on failure.
+  bool reset();
+
+  /// Returns true if records sent, or received, on this stream are
+  /// handled by the kernel.  Only meaningful after the handshake.
+  /// ktls_send() is only true if ktls_recv() is too, since plaintext
+  /// written to next_layer() must not race with records OpenSSL
+  /// writes while reading.
+  bool ktls_send() const { return ktls_send_; }
+  bool ktls_recv() const { return ktls_recv_; }
+
+  template <typename Handler>
+  void async_handshake(boost::asio::ssl::stream_base::handshake_type type,
+                       Handler &&handler) {
+    boost::system::error_code ec;
+    if (start_handshake(ec, type)) {
+      complete(std::forward<Handler>(handler), ec);
+      return;
+    }
+
+    run([this](std::size_t &) { return SSL_do_handshake(ssl_); },
+        [this, handler = std::forward<Handler>(handler)](
+            const boost::system::error_code &ec, std::size_t) mutable {
+          if (!ec) {
+            handshake_done();
+          }
+          handler(ec);
+        });
+  }
+
+  template <typename MutableBufferSequence, typename Handler>
+  void async_read_some(const MutableBufferSequence &buffers,
+                       Handler &&handler) {
+    auto buf = first_buffer<boost::asio::mutable_buffer>(buffers);
+    if (buf.size() == 0) {
+      complete(std::forward<Handler>(handler), boost::system::error_code{},
+               std::size_t{0});
+      return;
+    }
+
+    run(
+        [this, buf](std::size_t &n) {
+          return SSL_read_ex(ssl_, buf.data(), buf.size(), &n);
+        },
+        std::forward<Handler>(handler));
+  }
+
+  template <typename ConstBufferSequence, typename Handler>
+  void async_write_some(const ConstBufferSequence &buffers,
+                        Handler &&handler) {
+    auto buf = first_buffer<boost::asio::const_buffer>(buffers);
+    if (buf.size() == 0) {
+      complete(std::forward<Handler>(handler), boost::system::error_code{},
+               std::size_t{0});
+      return;
+    }
+
+    run(
+        [this, buf](std::size_t &n) {
+          return SSL_write_ex(ssl_, buf.data(), buf.size(), &n);
+        },
+        std::forward<Handler>(handler));
+  }
+
+  /// Reads without waiting.  |ec| is set to would_block if nothing can
+  /// be read right now.
+  template <typename MutableBufferSequence>
+  std::size_t read_some(const MutableBufferSequence &buffers,
+                        boost::system::error_code &ec) {
+    auto buf = first_buffer<boost::asio::mutable_buffer>(buffers);
+    return read_some(buf, ec);
+  }
+
+  std::size_t read_some(boost::asio::mutable_buffer buf,
+                        boost::system::error_code &ec);
+
+private:
+  void init();
+
+  /// Prepares ssl_ for a handshake of |type| on the connected socket.
+  boost::system::error_code
+  start_handshake(boost::system::error_code &ec,
+                  boost::asio::ssl::stream_base::handshake_type type);
+
+  /// Records whether OpenSSL turned kTLS on.
+  void handshake_done();
+
+  /// Maps the SSL_get_error() result |err| to an error code.
+  boost::system::error_code error(int err) const;
+
+  template <typename Buffer, typename BufferSequence>
+  static Buffer first_buffer(const BufferSequence &buffers) {
+    for (auto it = boost::asio::buffer_sequence_begin(buffers);
+         it != boost::asio::buffer_sequence_end(buffers); ++it) {
+      Buffer buf(*it);
+      if (buf.size() != 0) {
+        return buf;
+      }
+    }
+    return Buffer();
+  }
+
+  /// Invokes |handler| with |args| from the executor, never from
+  /// within the initiating function.
+  template <typename Handler, typename... Args>
+  void complete(Handler &&handler, Args... args) {
+    boost::asio::post(socket_.get_executor(),
+                      [handler = std::forward<Handler>(handler),
+                       args...]() mutable { handler(args...); });
+  }
+
+  /// Calls |op|, an OpenSSL function returning a positive value on
+  /// success, until it succeeds or fails, waiting for the socket
+  /// whenever OpenSSL needs to read or write.  |handler| gets the error
+  /// code and the number of bytes stored by |op|.
+  template <typename Op, typename Handler>
+  void run(Op op, Handler &&handler, bool waited = false) {
+    std::size_t n = 0;
+
+    ERR_clear_error();
+    errno = 0;
+    auto rv = op(n);
+
+    boost::system::error_code ec;
+
+    if (rv <= 0) {
+      auto err = SSL_get_error(ssl_, rv);
+      if (err == SSL_ERROR_WANT_READ || err == SSL_ERROR_WANT_WRITE) {
+        socket_.async_wait(
+            err == SSL_ERROR_WANT_READ ? next_layer_type::wait_read
+                                       : next_layer_type::wait_write,
+            [this, op = std::move(op), handler = std::forward<Handler>(handler)](
+                const boost::system::error_code &ec) mutable {
+              if (ec) {
+                handler(ec, std::size_t{0});
+                return;
+              }
+              run(std::move(op), std::move(handler), true);
+            });
+        return;
+      }
+
+      ec = error(err);
+      n = 0;
+    }
+
+    if (waited) {
+      handler(ec, n);
+      return;
+    }
+
+    complete(std::forward<Handler>(handler), ec, n);
+  }
+
+  next_layer_type socket_;
+  SSL *ssl_;
+  bool ktls_send_;
+  bool ktls_recv_;
+};
+
+} // namespace asio_http2
+
+} // namespace nghttp2
+
+#endif // ASIO_KTLS_STREAM_H
@@ -44,12 +44,25 @@ namespace nghttp2 {
 namespace asio_http2 {
 namespace server {
 
-server::server(std::size_t io_context_pool_size,
-               std::chrono::microseconds tls_handshake_timeout,
-               std::chrono::microseconds read_timeout)
-    : io_context_pool_(io_context_pool_size),
-      tls_handshake_timeout_(tls_handshake_timeout),
-      read_timeout_(read_timeout) {}
+namespace {
+std::vector<boost::asio::io_context *> io_contexts(io_context_pool &pool) {
+  auto iocs = std::vector<boost::asio::io_context *>{};
+  for (std::size_t i = 0; i < pool.size(); ++i) {
+    iocs.push_back(&pool.executor(i));
+  }
+  return iocs;
+}
+} // namespace
+
+server::server(std::size_t io_context_pool_size, bool sharded,
+               const connection_options &opts)
+    : io_context_pool_(io_context_pool_size, sharded),
+      connections_(
+          std::make_shared<connection_manager>(io_contexts(io_context_pool_))),
+      pending_accepts_(1),
+      accept_batch_(1),
+      sharded_(sharded),
+      opts_(opts) {}
 
 boost::system::error_code
 server::listen_and_serve(boost::system::error_code &ec,
@@ -62,12 +75,17 @@ server::listen_and_serve(boost::system::error_code &ec,
     return ec;
   }
 
-  for (auto &acceptor : acceptors_) {
-    if (tls_context) {
-      start_accept(*tls_context, acceptor, mux);
-    } else {
-      start_accept(acceptor, mux);
-    }
+  // The first accept is started from the thread which runs the
+  // acceptor's io_context, so that the connection objects are
+  // allocated on that thread (and its NUMA node if pinned) from the
+  // very first connection on.
+  for (std::size_t i = 0; i < acceptors_.size(); ++i) {
+    auto &ioc = io_context_pool_.executor(i);
+    auto &acceptor = acceptors_[i];
+    boost::asio::post(acceptor.get_executor(),
+                      [this, tls_context, &acceptor, &ioc, &mux] {
+                        start_accept(tls_context, acceptor, ioc, mux);
+                      });
   }
 
   io_context_pool_.run(asynchronous);
@@ -79,33 +97,40 @@ boost::system::error_code server::bind_and_listen(boost::system::error_code &ec,
                                                   const std::string &address,
                                                   const std::string &port,
                                                   int backlog) {
-  // Open the acceptor with the option to reuse the address (i.e.
-  // SO_REUSEADDR).
+#ifndef SO_REUSEPORT
+  if (sharded_) {
+    ec = boost::asio::error::operation_not_supported;
+    return ec;
+  }
+#endif // !SO_REUSEPORT
+
   tcp::resolver resolver(io_context_pool_.executor());
   auto it = resolver.resolve(address, port, ec);
   if (ec) {
     return ec;
   }
 
+  const auto nshards = io_context_pool_.size();
+
   for (const auto &endpoint : it) {
-    acceptors_.emplace_back(io_context_pool_.executor());
+    auto first = acceptors_.size();
 
-    if (acceptors_.back().open(endpoint.endpoint().protocol(), ec)) {
-      acceptors_.pop_back();
+    if (listen(ec, io_context_pool_.executor(0), endpoint.endpoint(), backlog)) {
       continue;
     }
 
-    acceptors_.back().set_option(tcp::acceptor::reuse_address(true));
-
-    if (acceptors_.back().bind(endpoint, ec)) {
-      acceptors_.pop_back();
-      continue;
+    // The remaining shards bind to the address the first one actually
+    // got, so that an ephemeral port (port "0") is shared by all
+    // shards.
+    auto bound = acceptors_[first].local_endpoint(ec);
+    for (std::size_t i = 1; !ec && i < nshards; ++i) {
+      listen(ec, io_context_pool_.executor(i), bound, backlog);
     }
 
-    if (acceptors_.back().listen(
-            backlog == -1 ? boost::asio::socket_base::max_listen_connections : backlog,
-            ec)) {
-      acceptors_.pop_back();
+    if (ec) {
+      // Keep acceptors_ grouped by shard; drop the endpoint entirely
+      // if any of its shards failed.
+      acceptors_.erase(std::begin(acceptors_) + first, std::end(acceptors_));
     }
   }
 
@@ -120,87 +145,310 @@ boost::system::error_code server::bind_and_listen(boost::system::error_code &ec,
   return ec;
 }
 
-void server::start_accept(boost::asio::ssl::context &tls_context,
-                          tcp::acceptor &acceptor, serve_mux &mux) {
+boost::system::error_code server::listen(boost::system::error_code &ec,
+                                         boost::asio::io_context &ioc,
+                                         const tcp::endpoint &endpoint,
+                                         int backlog) {
+  // The completion handlers of the pending accepts of an acceptor are
+  // serialized, even if several threads run |ioc|.
+  tcp::acceptor acceptor(boost::asio::make_strand(ioc));
+
+  if (acceptor.open(endpoint.protocol(), ec)) {
+    return ec;
+  }
+
+  // Open the acceptor with the option to reuse the address (i.e.
+  // SO_REUSEADDR).
+  if (acceptor.set_option(tcp::acceptor::reuse_address(true), ec)) {
+    return ec;
+  }
+
+#ifdef SO_REUSEPORT
+  if (sharded_) {
+    // Every shard listens on its own socket bound to the same address
+    // and the kernel load balances incoming connections between them.
+    using reuse_port =
+        boost::asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>;
+    if (acceptor.set_option(reuse_port(true), ec)) {
+      return ec;
+    }
+  }
+#endif // SO_REUSEPORT
+
+  if (acceptor.bind(endpoint, ec)) {
+    return ec;
+  }
+
+  // Only affects the synchronous accepts of accept_batch().
+  if (accept_batch_ > 1 && acceptor.non_blocking(true, ec)) {
+    return ec;
+  }
+
+  if (acceptor.listen(
+          backlog == -1 ? boost::asio::socket_base::max_listen_connections : backlog,
+          ec)) {
+    return ec;
+  }
+
+  acceptors_.push_back(std::move(acceptor));
+
+  return ec;
+}
+
+void server::start_accept(boost::asio::ssl::context *tls_context,
+                          tcp::acceptor &acceptor,
+                          boost::asio::io_context &ioc, serve_mux &mux) {
+  for (std::size_t i = 0; i < pending_accepts_; ++i) {
+    if (!tls_context) {
+      start_accept<tcp::socket>(tls_context, acceptor, ioc, mux);
+    } else if (opts_.ktls) {
+      start_accept<ktls_stream>(tls_context, acceptor, ioc, mux);
+    } else {
+      start_accept<ssl_socket>(tls_context, acceptor, ioc, mux);
+    }
+  }
+}
+
+template <typename socket_type>
+void server::start_accept(boost::asio::ssl::context *tls_context,
+                          tcp::acceptor &acceptor,
+                          boost::asio::io_context &ioc, serve_mux &mux,
+                          std::shared_ptr<connection<socket_type>> spare) {
 
   if (!acceptor.is_open()) {
     return;
   }
 
-  auto new_connection = std::make_shared<connection<ssl_socket>>(
-      io_context_pool_.executor(), mux, tls_handshake_timeout_, read_timeout_,
-      tls_context);
+  if (!connections_->available()) {
+    pause_accept<socket_type>(tls_context, acceptor, ioc, mux);
+    return;
+  }
+
+  auto new_connection =
+      spare ? std::move(spare)
+            : make_connection<socket_type>(tls_context, ioc, mux);
 
   acceptor.async_accept(
       new_connection->socket().lowest_layer(),
-      [this, &tls_context, &acceptor, &mux,
+      [this, tls_context, &acceptor, &ioc, &mux,
        new_connection](const boost::system::error_code &e) {
+        auto next = std::shared_ptr<connection<socket_type>>{};
+
         if (!e) {
-          new_connection->socket().lowest_layer().set_option(
-              tcp::no_delay(true));
-          new_connection->start_tls_handshake_deadline();
-          new_connection->socket().async_handshake(
-              boost::asio::ssl::stream_base::server,
-              [new_connection](const boost::system::error_code &e) {
-                if (e) {
-                  new_connection->stop();
-                  return;
-                }
-
-                if (!tls_h2_negotiated(new_connection->socket())) {
-                  new_connection->stop();
-                  return;
-                }
-
-                new_connection->start();
-              });
+          if (admit(*new_connection, ioc)) {
+            start_connection(new_connection);
+            next = accept_batch<socket_type>(tls_context, acceptor, ioc, mux);
+          }
         }
 
-        start_accept(tls_context, acceptor, mux);
+        start_accept<socket_type>(tls_context, acceptor, ioc, mux,
+                                  std::move(next));
       });
 }
 
-void server::start_accept(tcp::acceptor &acceptor, serve_mux &mux) {
+template <typename socket_type>
+std::shared_ptr<connection<socket_type>>
+server::accept_batch(boost::asio::ssl::context *tls_context,
+                     tcp::acceptor &acceptor, boost::asio::io_context &ioc,
+                     serve_mux &mux) {
+  auto new_connection = std::shared_ptr<connection<socket_type>>{};
+
+  for (std::size_t i = 1; i < accept_batch_ && acceptor.is_open() &&
+                          connections_->available();
+       ++i) {
+    if (!new_connection) {
+      new_connection = make_connection<socket_type>(tls_context, ioc, mux);
+    }
 
-  if (!acceptor.is_open()) {
-    return;
+    // The acceptor is non-blocking; this fails with would_block once
+    // the listen queue is empty.
+    boost::system::error_code ec;
+    if (acceptor.accept(new_connection->socket().lowest_layer(), ec)) {
+      break;
+    }
+
+    if (admit(*new_connection, ioc)) {
+      start_connection(new_connection);
+    }
+    new_connection.reset();
   }
 
-  auto new_connection = std::make_shared<connection<tcp::socket>>(
-      io_context_pool_.executor(), mux, tls_handshake_timeout_, read_timeout_);
+  return new_connection;
+}
 
-  acceptor.async_accept(
-      new_connection->socket(), [this, &acceptor, &mux, new_connection](
-                                    const boost::system::error_code &e) {
-        if (!e) {
-          new_connection->socket().set_option(tcp::no_delay(true));
-          new_connection->start_read_deadline();
-          new_connection->start();
-        }
-        if (acceptor.is_open()) {
-          start_accept(acceptor, mux);
+template <typename socket_type>
+void server::pause_accept(boost::asio::ssl::context *tls_context,
+                          tcp::acceptor &acceptor,
+                          boost::asio::io_context &ioc, serve_mux &mux) {
+  connections_->park([this, tls_context, &acceptor, &ioc, &mux] {
+    boost::asio::post(acceptor.get_executor(),
+                      [this, tls_context, &acceptor, &ioc, &mux] {
+                        start_accept<socket_type>(tls_context, acceptor, ioc,
+                                                  mux);
+                      });
+  });
+}
+
+template <typename socket_type>
+bool server::admit(connection<socket_type> &new_connection,
+                   boost::asio::io_context &ioc) {
+  if (!connections_->acquire()) {
+    new_connection.stop();
+    return false;
+  }
+
+  new_connection.manager(connections_, ioc);
+
+  return true;
+}
+
+template <typename socket_type>
+std::shared_ptr<connection<socket_type>>
+server::make_connection(boost::asio::ssl::context *tls_context,
+                        boost::asio::io_context &ioc, serve_mux &mux) {
+  if constexpr (!std::is_same_v<socket_type, ssl_socket>) {
+    auto it = pools_.find(&ioc);
+    if (it != std::end(pools_)) {
+      return it->second->acquire<connection<socket_type>>([&] {
+        if constexpr (std::is_same_v<socket_type, tcp::socket>) {
+          return new connection<socket_type>(ioc, mux, opts_);
+        } else {
+          return new connection<socket_type>(ioc, mux, opts_, *tls_context);
         }
       });
+    }
+  }
+
+  if constexpr (std::is_same_v<socket_type, tcp::socket>) {
+    return std::make_shared<connection<socket_type>>(ioc, mux, opts_);
+  } else {
+    return std::make_shared<connection<socket_type>>(ioc, mux, opts_,
+                                                     *tls_context);
+  }
+}
+
+template <typename socket_type>
+void server::start_connection(
+    const std::shared_ptr<connection<socket_type>> &new_connection) {
+  boost::system::error_code ignored_ec;
+  new_connection->socket().lowest_layer().set_option(tcp::no_delay(true),
+                                                     ignored_ec);
+
+  if constexpr (std::is_same_v<socket_type, tcp::socket>) {
+    new_connection->start_read_deadline();
+    new_connection->start();
+  } else {
+    new_connection->start_tls_handshake_deadline();
+    new_connection->socket().async_handshake(
+        boost::asio::ssl::stream_base::server,
+        [new_connection](const boost::system::error_code &e) {
+          if (e) {
+            new_connection->stop();
+            return;
+          }
+
+          if (!tls_h2_negotiated(new_connection->socket().native_handle())) {
+            new_connection->stop();
+            return;
+          }
+
+          new_connection->start();
+        });
+  }
 }
 
 void server::stop() {
+  // The parked accept operations refer to the acceptors.
+  connections_->clear();
+  close_acceptors();
+  io_context_pool_.stop();
+}
+
+void server::shutdown(std::chrono::microseconds deadline) {
+  close_acceptors();
+
+  shutdown_timer_ =
+      std::make_unique<boost::asio::steady_timer>(io_context_pool_.executor());
+  shutdown_timer_->expires_after(deadline);
+  shutdown_timer_->async_wait([this](const boost::system::error_code &ec) {
+    if (ec) {
+      return;
+    }
+    connections_->close_all();
+  });
+
+  // Stopping the pool also abandons the timer.
+  connections_->drain([this] { io_context_pool_.stop(); });
+}
+
+void server::close_acceptors() {
+  // Acceptors are only touched from the thread running their
+  // io_context; closing them from here would race with a pending
+  // accept.
   for (auto &acceptor : acceptors_) {
-    acceptor.close();
+    boost::asio::post(acceptor.get_executor(), [&acceptor] {
+      boost::system::error_code ignored_ec;
+      acceptor.close(ignored_ec);
+    });
+  }
+}
+
+void server::max_connections(std::size_t n) { connections_->limit(n); }
+
+void server::connection_pool_size(std::size_t n) {
+  pools_.clear();
+  if (n == 0) {
+    return;
+  }
+
+  for (std::size_t i = 0; i < io_context_pool_.size(); ++i) {
+    pools_.emplace(&io_context_pool_.executor(i),
+                   std::make_shared<connection_pool>(n));
   }
-  io_context_pool_.stop();
 }
 
-void server::join() { io_context_pool_.join(); }
+server_stats server::stats() {
+  auto stats = connections_->stats();
+  for (auto &[_, pool] : pools_) {
+    pool->add_stats(stats);
+  }
+  return stats;
+}
+
+void server::accept_concurrency(std::size_t pending, std::size_t batch) {
+  pending_accepts_ = std::max<std::size_t>(pending, 1);
+  accept_batch_ = std::max<std::size_t>(batch, 1);
+}
+
+boost::system::error_code
+server::thread_affinity(boost::system::error_code &ec,
+                        const std::vector<int> &ids, bool numa) {
+  return io_context_pool_.affinity(ec, ids, numa);
+}
+
+void server::join() {
+  io_context_pool_.join();
+
+  // No thread runs the io_context anymore, so the acceptors can be
+  // closed directly if stop() did not get to them.
+  for (auto &acceptor : acceptors_) {
+    boost::system::error_code ignored_ec;
+    acceptor.close(ignored_ec);
+  }
+}
 
 boost::asio::io_context & server::executor() {
   return io_context_pool_.executor();
 }
 
 const std::vector<int> server::ports() const {
-  auto ports = std::vector<int>(acceptors_.size());
-  auto index = 0;
-  for (const auto &acceptor : acceptors_) {
-    ports[index++] = acceptor.local_endpoint().port();
+  // In sharded mode, all the acceptors of an endpoint share the same
+  // port; report it once.
+  const auto nshards = io_context_pool_.size();
+  auto ports = std::vector<int>{};
+  ports.reserve(acceptors_.size() / nshards);
+  for (std::size_t i = 0; i < acceptors_.size(); i += nshards) {
+    ports.push_back(acceptors_[i].local_endpoint().port());
   }
   return ports;
 }
@@ -40,14 +40,19 @@
 #include "nghttp2_config.h"
 
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include <memory>
 
 #include <boost/noncopyable.hpp>
+#include <boost/asio/steady_timer.hpp>
 
 #include <nghttp2/asio_http2_server.h>
 
 #include "asio_io_service_pool.h"
+#include "asio_server_connection_manager.h"
+#include "asio_server_connection_options.h"
+#include "asio_server_connection_pool.h"
 
 namespace nghttp2 {
 
@@ -56,6 +61,7 @@ namespace asio_http2 {
 namespace server {
 
 class serve_mux;
+template <typename socket_type> class connection;
 
 using boost::asio::ip::tcp;
 
@@ -63,9 +69,8 @@ using ssl_socket = boost::asio::ssl::stream<tcp::socket>;
 
 class server : private boost::noncopyable {
 public:
-  explicit server(std::size_t io_context_pool_size,
-                  std::chrono::microseconds tls_handshake_timeout,
-                  std::chrono::microseconds read_timeout);
+  explicit server(std::size_t io_context_pool_size, bool sharded,
+                  const connection_options &opts);
 
   boost::system::error_code
   listen_and_serve(boost::system::error_code &ec,
@@ -75,6 +80,32 @@ public:
   void join();
   void stop();
 
+  /// Stops accepting, sends GOAWAY on every connection and stops the
+  /// io_context pool once they are all closed.  Connections still open
+  /// after |deadline| are closed.
+  void shutdown(std::chrono::microseconds deadline);
+
+  /// Sets the number of accept operations kept pending on each
+  /// acceptor, and the maximum number of connections accepted per
+  /// completion.  Must be called before listen_and_serve().
+  void accept_concurrency(std::size_t pending, std::size_t batch);
+
+  /// Sets the maximum number of open connections, 0 for no limit.
+  void max_connections(std::size_t n);
+
+  /// Sets the maximum number of closed connections kept for reuse per
+  /// io_context, 0 to disable pooling.  Must be called before
+  /// listen_and_serve().
+  void connection_pool_size(std::size_t n);
+
+  server_stats stats();
+
+  /// Pins the threads of the io_context pool.  See
+  /// io_context_pool::affinity().
+  boost::system::error_code thread_affinity(boost::system::error_code &ec,
+                                            const std::vector<int> &ids,
+                                            bool numa);
+
   /// Get access to all io_context objects.
   boost::asio::io_context & executor();
 
@@ -82,29 +113,97 @@ public:
   const std::vector<int> ports() const;
 
 private:
-  /// Initiate an asynchronous accept operation.
-  void start_accept(tcp::acceptor &acceptor, serve_mux &mux);
-  /// Same as above but with tls_context
-  void start_accept(boost::asio::ssl::context &tls_context,
-                    tcp::acceptor &acceptor, serve_mux &mux);
-
-  /// Resolves address and bind socket to the resolved addresses.
+  /// Initiates pending_accepts_ asynchronous accept operations on
+  /// |acceptor|, with TLS if |tls_context| is not null.  Accepted
+  /// connections run on |ioc|.
+  void start_accept(boost::asio::ssl::context *tls_context,
+                    tcp::acceptor &acceptor, boost::asio::io_context &ioc,
+                    serve_mux &mux);
+  /// Initiates one asynchronous accept operation of a connection over
+  /// |socket_type|, which is tcp::socket, ssl_socket or ktls_stream.
+  /// The operation re-arms itself on completion.  |spare|, if not
+  /// null, is a connection object to accept into.
+  template <typename socket_type>
+  void start_accept(boost::asio::ssl::context *tls_context,
+                    tcp::acceptor &acceptor, boost::asio::io_context &ioc,
+                    serve_mux &mux,
+                    std::shared_ptr<connection<socket_type>> spare = nullptr);
+  /// Accepts the connections already waiting in the listen queue of
+  /// |acceptor| without going back to the event loop, up to
+  /// accept_batch_ - 1 of them.  Returns the connection object left
+  /// unused, if any.
+  template <typename socket_type>
+  std::shared_ptr<connection<socket_type>>
+  accept_batch(boost::asio::ssl::context *tls_context,
+               tcp::acceptor &acceptor, boost::asio::io_context &ioc,
+               serve_mux &mux);
+  template <typename socket_type>
+  std::shared_ptr<connection<socket_type>>
+  make_connection(boost::asio::ssl::context *tls_context,
+                  boost::asio::io_context &ioc, serve_mux &mux);
+  /// Takes a slot for |new_connection|, which runs on |ioc|, or
+  /// closes it if there is none.
+  template <typename socket_type>
+  bool admit(connection<socket_type> &new_connection,
+             boost::asio::io_context &ioc);
+  /// Closes the acceptors from the threads running them.
+  void close_acceptors();
+  /// Parks the accept operation until a connection closes.
+  template <typename socket_type>
+  void pause_accept(boost::asio::ssl::context *tls_context,
+                    tcp::acceptor &acceptor, boost::asio::io_context &ioc,
+                    serve_mux &mux);
+  /// Starts serving an accepted connection, after the TLS handshake if
+  /// any.
+  template <typename socket_type>
+  void start_connection(
+      const std::shared_ptr<connection<socket_type>> &new_connection);
+
+  /// Resolves address and bind socket to the resolved addresses.  In
+  /// sharded mode, each resolved address gets one SO_REUSEPORT
+  /// acceptor per shard.
   boost::system::error_code bind_and_listen(boost::system::error_code &ec,
                                             const std::string &address,
                                             const std::string &port,
                                             int backlog);
 
+  /// Opens, binds and listens on a single acceptor for |endpoint|
+  /// running on |ioc|.  On success the acceptor is appended to
+  /// acceptors_.
+  boost::system::error_code listen(boost::system::error_code &ec,
+                                   boost::asio::io_context &ioc,
+                                   const tcp::endpoint &endpoint, int backlog);
+
   /// The pool of io_context objects used to perform asynchronous
   /// operations.
   io_context_pool io_context_pool_;
 
-  /// Acceptor used to listen for incoming connections.
+  /// Acceptor used to listen for incoming connections.  In sharded
+  /// mode, acceptors are grouped per endpoint: acceptor i belongs to
+  /// shard i % io_context_pool_.size().
   std::vector<tcp::acceptor> acceptors_;
 
+  /// Counts the connections; shared with them since they may outlive
+  /// the server.
+  std::shared_ptr<connection_manager> connections_;
+
+  /// Closed connections kept for reuse, one pool per io_context.
+  /// Empty if pooling is disabled.
+  std::unordered_map<boost::asio::io_context *,
+                     std::shared_ptr<connection_pool>>
+      pools_;
+
+  std::size_t pending_accepts_;
+  std::size_t accept_batch_;
+
+  bool sharded_;
+
   std::unique_ptr<boost::asio::ssl::context> ssl_ctx_;
 
-  std::chrono::microseconds tls_handshake_timeout_;
-  std::chrono::microseconds read_timeout_;
+  /// Expires at the deadline passed to shutdown().
+  std::unique_ptr<boost::asio::steady_timer> shutdown_timer_;
+
+  connection_options opts_;
 };
 
 } // namespace server
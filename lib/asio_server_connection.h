@@ -39,17 +39,25 @@
 
 #include "nghttp2_config.h"
 
+#ifdef HAVE_SYS_SENDFILE_H
+#  include <sys/sendfile.h>
+#endif // HAVE_SYS_SENDFILE_H
+
+#include <algorithm>
 #include <memory>
+#include <type_traits>
 
 #include <boost/noncopyable.hpp>
-#include <boost/array.hpp>
 #include <boost/asio/strand.hpp>
-#include <boost/asio/system_timer.hpp>
 
 #include <nghttp2/asio_http2_server.h>
 
+#include "asio_ktls_stream.h"
+#include "asio_server_connection_manager.h"
+#include "asio_server_connection_options.h"
 #include "asio_server_http2_handler.h"
 #include "asio_server_serve_mux.h"
+#include "asio_timer_wheel.h"
 #include "util.h"
 #include "template.h"
 
@@ -61,7 +69,8 @@ namespace server {
 
 /// Represents a single connection from a client.
 template <typename socket_type>
-class connection : public std::enable_shared_from_this<connection<socket_type>>,
+class connection : public connection_base,
+                   public std::enable_shared_from_this<connection<socket_type>>,
                    private boost::noncopyable {
 public:
   /// Construct a connection with the given io_context.
@@ -69,18 +78,85 @@ public:
   explicit connection(
       boost::asio::io_context &ioc,
       serve_mux &mux,
-      std::chrono::microseconds tls_handshake_timeout,
-      std::chrono::microseconds read_timeout,
+      const connection_options &opts,
       SocketArgs &&...args)
       : strand_(boost::asio::make_strand(ioc)),
         socket_(strand_, std::forward<SocketArgs>(args)...),
         mux_(mux),
-        deadline_(strand_),
-        tls_handshake_timeout_(tls_handshake_timeout),
-        read_timeout_(read_timeout),
+        opts_(opts),
+        buffer_size_(0),
+        small_reads_(0),
+        deadline_(ioc),
         writing_(false),
         stopped_(false) {}
 
+  ~connection() {
+    if (manager_) {
+      manager_->release(this);
+    }
+  }
+
+  /// Makes the connection, which runs on |ioc|, hold a slot of
+  /// |manager| until it is destroyed.
+  void manager(std::shared_ptr<connection_manager> manager,
+               boost::asio::io_context &ioc) {
+    manager_ = std::move(manager);
+    manager_->add(this->shared_from_this(), ioc);
+  }
+
+  void shutdown() override {
+    boost::asio::post(strand_, [self = this->shared_from_this()] {
+      if (self->stopped_) {
+        return;
+      }
+      // Still in the TLS handshake; there is no stream to wait for.
+      if (!self->handler_) {
+        self->stop();
+        return;
+      }
+      self->handler_->shutdown();
+    });
+  }
+
+  void close() override {
+    boost::asio::post(strand_,
+                      [self = this->shared_from_this()] { self->stop(); });
+  }
+
+  bool recycle() override {
+    stop();
+
+    if (manager_) {
+      manager_->release(this);
+      manager_.reset();
+    }
+
+    if constexpr (std::is_same_v<socket_type, ktls_stream>) {
+      if (!socket_.reset()) {
+        return false;
+      }
+    } else if constexpr (!std::is_same_v<socket_type,
+                                         boost::asio::ip::tcp::socket>) {
+      // boost::asio::ssl::stream cannot be reset.
+      return false;
+    }
+
+    if (handler_) {
+      handler_->close();
+      // Posted writes may still refer to the handler.
+      if (handler_.use_count() == 1) {
+        spare_handler_ = std::move(handler_);
+      }
+      handler_.reset();
+    }
+
+    small_reads_ = 0;
+    writing_ = false;
+    stopped_ = false;
+
+    return true;
+  }
+
   /// Start the first asynchronous operation for the connection.
   void start() {
     boost::system::error_code ec;
@@ -96,28 +172,62 @@ public:
       };
     };
 
-    handler_ = std::make_shared<http2_handler>(
-        strand_, socket_.lowest_layer().remote_endpoint(ec),
-        make_writefun(), mux_);
+    if (spare_handler_) {
+      handler_ = std::move(spare_handler_);
+      handler_->reset(socket_.lowest_layer().remote_endpoint(ec),
+                      make_writefun());
+    } else {
+      handler_ = std::make_shared<http2_handler>(
+          strand_, socket_.lowest_layer().remote_endpoint(ec),
+          make_writefun(), mux_, opts_);
+    }
     if (handler_->start() != 0) {
       stop();
       return;
     }
+
+    // The server started draining during the TLS handshake.
+    if (manager_ && manager_->draining()) {
+      handler_->shutdown();
+    }
+
+#ifdef HAVE_SYS_SENDFILE_H
+    if constexpr (std::is_same_v<socket_type, boost::asio::ip::tcp::socket>) {
+      handler_->output().enable_sendfile(true);
+    } else if constexpr (std::is_same_v<socket_type, ktls_stream>) {
+      handler_->output().enable_sendfile(socket_.ktls_send());
+    }
+#endif // HAVE_SYS_SENDFILE_H
+
+    if (opts_.drain_reads && nonblocking_reads) {
+      // Only affects the synchronous reads done by drain(); Asio keeps
+      // handling the asynchronous operations the same way.
+      socket_.lowest_layer().non_blocking(true, ec);
+    }
+
+    resize_buffer(opts_.read_buffer_min);
     do_read();
   }
 
   socket_type &socket() { return socket_; }
 
   void start_tls_handshake_deadline() {
-    deadline_.expires_after(tls_handshake_timeout_);
-    deadline_.async_wait(
-        std::bind(&connection::handle_deadline, this->shared_from_this()));
+    deadline_.expires_after(opts_.tls_handshake_timeout);
+    wait_deadline();
   }
 
   void start_read_deadline() {
-    deadline_.expires_after(read_timeout_);
-    deadline_.async_wait(
-        std::bind(&connection::handle_deadline, this->shared_from_this()));
+    deadline_.expires_after(opts_.read_timeout);
+    wait_deadline();
+  }
+
+  void wait_deadline() {
+    deadline_.async_wait([weak = this->weak_from_this()] {
+      if (auto self = weak.lock()) {
+        boost::asio::post(self->strand_,
+                          std::bind(&connection::handle_deadline, self));
+      }
+    });
   }
 
   void handle_deadline() {
@@ -125,23 +235,22 @@ public:
       return;
     }
 
-    if (deadline_.expiry() <= std::chrono::system_clock::now()) {
-      stop();
-      deadline_.expires_after(std::chrono::seconds{std::numeric_limits<uint32_t>::max()});
+    // Moved by an I/O completed after the wheel found it expired.
+    if (!deadline_.expired()) {
+      wait_deadline();
       return;
     }
 
-    deadline_.async_wait(
-        std::bind(&connection::handle_deadline, this->shared_from_this()));
+    stop();
   }
 
   void do_read() {
     auto self = this->shared_from_this();
 
-    deadline_.expires_after(read_timeout_);
+    deadline_.expires_after(opts_.read_timeout);
 
     socket_.async_read_some(
-        boost::asio::buffer(buffer_),
+        boost::asio::buffer(buffer_.get(), buffer_size_),
         [this, self](const boost::system::error_code &e,
                      std::size_t bytes_transferred) {
           if (e) {
@@ -149,19 +258,26 @@ public:
             return;
           }
 
-          if (handler_->on_read(buffer_, bytes_transferred) != 0) {
+          if (handler_->on_read(buffer_.get(), bytes_transferred) != 0) {
             stop();
             return;
           }
 
-          do_write();
-
-          if (!writing_ && handler_->should_stop()) {
-            stop();
-            return;
+          adapt_buffer(bytes_transferred);
+
+          if (opts_.drain_reads) {
+            if constexpr (nonblocking_reads) {
+              if (drain() != 0) {
+                stop();
+                return;
+              }
+            } else {
+              drain_async(0);
+              return;
+            }
           }
 
-          do_read();
+          read_done();
 
           // If an error occurs then no new asynchronous operations are
           // started. This means that all shared_ptr references to the
@@ -171,6 +287,18 @@ public:
         });
   }
 
+  /// Writes the output of the reads done so far, and reads again.
+  void read_done() {
+    do_write();
+
+    if (!writing_ && handler_->should_stop()) {
+      stop();
+      return;
+    }
+
+    do_read();
+  }
+
   void do_write() {
     auto self = this->shared_from_this();
 
@@ -181,7 +309,7 @@ public:
     int rv;
     std::size_t nwrite;
 
-    rv = handler_->on_write(outbuf_, nwrite);
+    rv = handler_->on_write(nwrite);
 
     if (rv != 0) {
       stop();
@@ -199,20 +327,40 @@ public:
 
     // Reset read deadline here, because normally client is sending
     // something, it does not expect timeout while doing it.
-    deadline_.expires_after(read_timeout_);
+    deadline_.expires_after(opts_.read_timeout);
 
-    boost::asio::async_write(
-        socket_, boost::asio::buffer(outbuf_, nwrite),
-        [this, self](const boost::system::error_code &e, std::size_t) {
-          if (e) {
-            stop();
-            return;
-          }
+    auto on_written = [this, self](const boost::system::error_code &e,
+                                   std::size_t) {
+      handler_->output().clear();
 
-          writing_ = false;
+      if (e) {
+        stop();
+        return;
+      }
 
-          do_write();
-        });
+      writing_ = false;
+
+      do_write();
+    };
+
+    auto &output = handler_->output();
+
+    if (plaintext_writes()) {
+      if (!output.files().empty()) {
+        write_with_files(0, std::move(on_written));
+        return;
+      }
+
+      // Frame headers and payloads go out in a single writev; with
+      // kTLS the kernel turns them into records.
+      boost::asio::async_write(tcp_socket(), output.buffers(),
+                               std::move(on_written));
+    } else {
+      // ssl::stream encrypts one buffer per SSL_write, which would
+      // produce a TLS record per segment.
+      boost::asio::async_write(socket_, output.linearize(),
+                               std::move(on_written));
+    }
 
     // No new asynchronous operations are started. This means that all
     // shared_ptr references to the connection object will disappear and
@@ -220,6 +368,197 @@ public:
     // returns. The connection class's destructor closes the socket.
   }
 
+  /// Reads what is already available on the socket without going
+  /// back to the reactor, until the socket would block or
+  /// max_drain_reads reads were done, so that one busy connection
+  /// cannot starve the others sharing the thread.  The output of all
+  /// these reads is then sent with a single write.  Returns -1 if the
+  /// connection must be stopped.
+  int drain() {
+    for (std::size_t i = 0; i < max_drain_reads; ++i) {
+      boost::system::error_code ec;
+      auto n = socket_.read_some(
+          boost::asio::buffer(buffer_.get(), buffer_size_), ec);
+      if (ec == boost::asio::error::would_block) {
+        return 0;
+      }
+      if (ec) {
+        return -1;
+      }
+      if (handler_->on_read(buffer_.get(), n) != 0) {
+        return -1;
+      }
+      adapt_buffer(n);
+    }
+
+    return 0;
+  }
+
+  /// Does what drain() does on a boost::asio::ssl::stream, which does
+  /// not support non-blocking reads.  A further asynchronous read is
+  /// only started while OpenSSL or the socket already hold received
+  /// bytes, so that it does not wait for the client; a partial TLS
+  /// record is still bounded by the read deadline.  |i| reads were
+  /// done so far.
+  void drain_async(std::size_t i) {
+    if constexpr (!nonblocking_reads) {
+      boost::system::error_code ec;
+      if (i == max_drain_reads ||
+          (SSL_pending(socket_.native_handle()) == 0 &&
+           tcp_socket().available(ec) == 0)) {
+        read_done();
+        return;
+      }
+
+      auto self = this->shared_from_this();
+
+      socket_.async_read_some(
+          boost::asio::buffer(buffer_.get(), buffer_size_),
+          [this, self, i](const boost::system::error_code &e,
+                          std::size_t bytes_transferred) {
+            if (e) {
+              stop();
+              return;
+            }
+
+            if (handler_->on_read(buffer_.get(), bytes_transferred) != 0) {
+              stop();
+              return;
+            }
+
+            adapt_buffer(bytes_transferred);
+
+            drain_async(i + 1);
+          });
+    }
+  }
+
+  /// Returns the TCP socket under socket_.
+  boost::asio::ip::tcp::socket &tcp_socket() {
+    if constexpr (std::is_same_v<socket_type, boost::asio::ip::tcp::socket>) {
+      return socket_;
+    } else {
+      return socket_.next_layer();
+    }
+  }
+
+  /// Returns true if the output can be written to the TCP socket as
+  /// is, i.e. on cleartext connections, and on TLS connections whose
+  /// records are encrypted by the kernel.
+  bool plaintext_writes() {
+    if constexpr (std::is_same_v<socket_type, boost::asio::ip::tcp::socket>) {
+      return true;
+    } else if constexpr (std::is_same_v<socket_type, ktls_stream>) {
+      return socket_.ktls_send();
+    } else {
+      return false;
+    }
+  }
+
+  /// Writes the output from its |i|th file segment on: the memory
+  /// segments preceding that file segment, then the file segment
+  /// itself with sendfile(2), and so on until the remaining memory
+  /// segments after the last one.
+  template <typename Handler>
+  void write_with_files(std::size_t i, Handler &&handler) {
+    auto &output = handler_->output();
+    auto buffers = output.buffers();
+    auto files = output.files();
+    auto from = i == 0 ? 0 : files[i - 1].index;
+
+    if (i == files.size()) {
+      boost::asio::async_write(tcp_socket(), buffers.subspan(from),
+                               std::forward<Handler>(handler));
+      return;
+    }
+
+    auto &file = files[i];
+
+    auto on_file_sent = [this, i, handler = std::forward<Handler>(handler)](
+                            const boost::system::error_code &e) mutable {
+      if (e) {
+        handler(e, 0);
+        return;
+      }
+
+      write_with_files(i + 1, std::move(handler));
+    };
+
+    boost::asio::async_write(
+        tcp_socket(), buffers.subspan(from, file.index - from),
+        [this, &file, on_file_sent = std::move(on_file_sent)](
+            const boost::system::error_code &e, std::size_t) mutable {
+          if (e) {
+            on_file_sent(e);
+            return;
+          }
+
+          send_file(file, 0, std::move(on_file_sent));
+        });
+  }
+
+  /// Sends |file| from offset |sent| on with sendfile(2), waiting for
+  /// the socket to become writable whenever it would block.  It must
+  /// run with SIGPIPE blocked, as on the threads of io_context_pool.
+  template <typename Handler>
+  void send_file(const write_buffer::file_segment &file, std::size_t sent,
+                 Handler &&handler) {
+#ifdef HAVE_SYS_SENDFILE_H
+    boost::system::error_code ec;
+
+    // Asio only sets the descriptor non-blocking for its own
+    // operations; sendfile must not block the thread.
+    if (!tcp_socket().native_non_blocking()) {
+      tcp_socket().native_non_blocking(true, ec);
+      if (ec) {
+        handler(ec);
+        return;
+      }
+    }
+
+    while (sent < file.len) {
+      off_t offset = file.offset + sent;
+      auto n = ::sendfile(tcp_socket().native_handle(), file.fd,
+                          &offset, file.len - sent);
+      if (n > 0) {
+        sent += n;
+        continue;
+      }
+
+      if (n == 0) {
+        // The file shrank under us.
+        handler(boost::asio::error::eof);
+        return;
+      }
+
+      if (errno == EINTR) {
+        continue;
+      }
+
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        tcp_socket().async_wait(
+            boost::asio::ip::tcp::socket::wait_write,
+            [this, &file, sent, handler = std::forward<Handler>(handler)](
+                const boost::system::error_code &e) mutable {
+              if (e) {
+                handler(e);
+                return;
+              }
+              send_file(file, sent, std::move(handler));
+            });
+        return;
+      }
+
+      handler(boost::system::error_code(errno, boost::system::system_category()));
+      return;
+    }
+
+    handler(boost::system::error_code{});
+#else  // !HAVE_SYS_SENDFILE_H
+    handler(boost::asio::error::operation_not_supported);
+#endif // !HAVE_SYS_SENDFILE_H
+  }
+
   void stop() {
     if (stopped_) {
       return;
@@ -232,21 +571,74 @@ public:
   }
 
 private:
+  /// Upper bound of reads done by a single drain().
+  static constexpr std::size_t max_drain_reads = 16;
+  /// true if socket_ can read without waiting, which
+  /// boost::asio::ssl::stream cannot do.
+  static constexpr bool nonblocking_reads =
+      std::is_same_v<socket_type, boost::asio::ip::tcp::socket> ||
+      std::is_same_v<socket_type, ktls_stream>;
+  /// Number of consecutive small reads after which the read buffer
+  /// shrinks.
+  static constexpr std::size_t small_reads_to_shrink = 4;
+
+  /// Grows the read buffer if the last read of |n| bytes filled it,
+  /// and shrinks it once reads keep using less than a quarter of it,
+  /// e.g. when the connection went idle.  Must only be called when no
+  /// read is pending.
+  void adapt_buffer(std::size_t n) {
+    if (n == buffer_size_) {
+      small_reads_ = 0;
+      if (buffer_size_ < opts_.read_buffer_max) {
+        resize_buffer(std::min(buffer_size_ * 2, opts_.read_buffer_max));
+      }
+      return;
+    }
+
+    if (n >= buffer_size_ / 4 || buffer_size_ <= opts_.read_buffer_min) {
+      small_reads_ = 0;
+      return;
+    }
+
+    if (++small_reads_ == small_reads_to_shrink) {
+      small_reads_ = 0;
+      resize_buffer(std::max(buffer_size_ / 2, opts_.read_buffer_min));
+    }
+  }
+
+  void resize_buffer(std::size_t size) {
+    // A recycled connection may already have the buffer.
+    if (size == buffer_size_) {
+      return;
+    }
+    buffer_ = std::make_unique_for_overwrite<uint8_t[]>(size);
+    buffer_size_ = size;
+  }
+
   boost::asio::strand<boost::asio::io_context::executor_type> strand_;
   socket_type socket_;
 
   serve_mux &mux_;
 
   std::shared_ptr<http2_handler> handler_;
+  /// Handler of the previous connection, kept by recycle() for the
+  /// next one.
+  std::shared_ptr<http2_handler> spare_handler_;
+
+  connection_options opts_;
 
-  /// Buffer for incoming data.
-  boost::array<uint8_t, 8_k> buffer_;
+  /// Buffer for incoming data, sized between opts_.read_buffer_min
+  /// and opts_.read_buffer_max.
+  std::unique_ptr<uint8_t[]> buffer_;
+  std::size_t buffer_size_;
+  /// Number of consecutive reads which used less than a quarter of
+  /// buffer_.
+  std::size_t small_reads_;
 
-  boost::array<uint8_t, 64_k> outbuf_;
+  /// Read or TLS handshake deadline, moved on every read and write.
+  timer_wheel::timer deadline_;
 
-  boost::asio::system_timer deadline_;
-  std::chrono::microseconds tls_handshake_timeout_;
-  std::chrono::microseconds read_timeout_;
+  std::shared_ptr<connection_manager> manager_;
 
   bool writing_;
   bool stopped_;
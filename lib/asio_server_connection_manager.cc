@@ -0,0 +1,238 @@
+/*
+ * nghttp2 - HTTP/2 C Library
+ *
+ * Copyright (c) 2015 Tatsuhiro Tsujikawa
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "asio_server_connection_manager.h"
+
+namespace nghttp2 {
+namespace asio_http2 {
+namespace server {
+
+connection_manager::connection_manager(
+    const std::vector<boost::asio::io_context *> &contexts)
+    : max_connections_(0),
+      active_(0),
+      paused_(0),
+      accepted_(0),
+      rejected_(0),
+      accept_pauses_(0),
+      draining_(false) {
+  for (auto ioc : contexts) {
+    registries_.emplace(ioc, std::make_unique<registry>());
+  }
+}
+
+void connection_manager::limit(std::size_t max_connections) {
+  max_connections_ = max_connections;
+}
+
+bool connection_manager::available() {
+  auto max = max_connections_.load();
+  return !draining_ && (max == 0 || active_ < max);
+}
+
+bool connection_manager::acquire() {
+  auto max = max_connections_.load();
+
+  if (max == 0) {
+    ++active_;
+  } else {
+    auto n = active_.load();
+    do {
+      if (n >= max) {
+        ++rejected_;
+        return false;
+      }
+    } while (!active_.compare_exchange_weak(n, n + 1));
+  }
+
+  // drain() may have started since the caller checked available().
+  if (draining_) {
+    release_slot();
+    ++rejected_;
+    return false;
+  }
+
+  ++accepted_;
+
+  return true;
+}
+
+void connection_manager::add(const std::shared_ptr<connection_base> &conn,
+                             boost::asio::io_context &ioc) {
+  auto &reg = *registries_.at(&ioc);
+
+  std::lock_guard<std::mutex> lock(reg.mutex);
+  conn->self_ = conn;
+  conn->registry_ = &reg;
+  conn->prev_ = nullptr;
+  conn->next_ = reg.head;
+  if (reg.head) {
+    reg.head->prev_ = conn.get();
+  }
+  reg.head = conn.get();
+}
+
+void connection_manager::release(connection_base *conn) {
+  if (auto reg = conn->registry_) {
+    std::lock_guard<std::mutex> lock(reg->mutex);
+    if (conn->prev_) {
+      conn->prev_->next_ = conn->next_;
+    } else {
+      reg->head = conn->next_;
+    }
+    if (conn->next_) {
+      conn->next_->prev_ = conn->prev_;
+    }
+    conn->prev_ = conn->next_ = nullptr;
+    conn->registry_ = nullptr;
+    conn->self_.reset();
+  }
+
+  release_slot();
+}
+
+void connection_manager::release_slot() {
+  auto n = --active_;
+
+  if (paused_) {
+    resume_parked();
+  }
+
+  if (n == 0 && draining_) {
+    drained();
+  }
+}
+
+void connection_manager::resume_parked() {
+  std::vector<std::function<void()>> resume;
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    resume.swap(parked_);
+    paused_ = 0;
+  }
+
+  for (auto &f : resume) {
+    f();
+  }
+}
+
+void connection_manager::park(std::function<void()> resume) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (draining_) {
+      return;
+    }
+    parked_.push_back(std::move(resume));
+    paused_ = parked_.size();
+    ++accept_pauses_;
+  }
+
+  // A slot may have been released since the caller found none, before
+  // it could see paused_.
+  if (available()) {
+    resume_parked();
+  }
+}
+
+void connection_manager::clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  parked_.clear();
+  paused_ = 0;
+}
+
+void connection_manager::drain(std::function<void()> drained) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    drained_ = std::move(drained);
+    parked_.clear();
+    paused_ = 0;
+  }
+
+  // Whichever of this and the release of the last slot comes last
+  // sees the other one.
+  draining_ = true;
+
+  if (active_ == 0) {
+    this->drained();
+    return;
+  }
+
+  for (auto &conn : live()) {
+    conn->shutdown();
+  }
+}
+
+void connection_manager::drained() {
+  std::function<void()> cb;
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    cb.swap(drained_);
+  }
+
+  if (cb) {
+    cb();
+  }
+}
+
+void connection_manager::close_all() {
+  for (auto &conn : live()) {
+    conn->close();
+  }
+}
+
+bool connection_manager::draining() { return draining_; }
+
+std::vector<std::shared_ptr<connection_base>> connection_manager::live() {
+  auto conns = std::vector<std::shared_ptr<connection_base>>{};
+
+  for (auto &[_, reg] : registries_) {
+    std::lock_guard<std::mutex> lock(reg->mutex);
+    for (auto p = reg->head; p; p = p->next_) {
+      // Skips the connections being destroyed.
+      if (auto conn = p->self_.lock()) {
+        conns.push_back(std::move(conn));
+      }
+    }
+  }
+
+  return conns;
+}
+
+server_stats connection_manager::stats() {
+  auto stats = server_stats{};
+
+  stats.active_connections = active_;
+  stats.paused_accepts = paused_;
+  stats.accepted_connections = accepted_;
+  stats.rejected_connections = rejected_;
+  stats.accept_pauses = accept_pauses_;
+
+  return stats;
+}
+
+} // namespace server
+} // namespace asio_http2
+} // namespace nghttp2
@@ -0,0 +1,181 @@
+/*
+ * nghttp2 - HTTP/2 C Library
+ *
+ * Copyright (c) 2015 Tatsuhiro Tsujikawa
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef ASIO_SERVER_CONNECTION_MANAGER_H
+#define ASIO_SERVER_CONNECTION_MANAGER_H
+
+#include "nghttp2_config.h"
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/asio/io_context.hpp>
+#include <boost/noncopyable.hpp>
+
+#include <nghttp2/asio_http2_server.h>
+
+namespace nghttp2 {
+
+namespace asio_http2 {
+
+namespace server {
+
+class connection_manager;
+
+/// The part of a connection the connection_manager deals with.
+class connection_base {
+public:
+  virtual ~connection_base() = default;
+
+  /// Sends GOAWAY and closes the connection once its open streams are
+  /// done.
+  virtual void shutdown() = 0;
+
+  /// Closes the connection right away.
+  virtual void close() = 0;
+
+  /// Called by connection_pool once the last reference is gone.
+  /// Closes what is left of the connection and resets it, so that it
+  /// can accept another client.  Returns false if the connection
+  /// cannot be reused and must be deleted instead.
+  virtual bool recycle() = 0;
+
+private:
+  friend class connection_manager;
+
+  /// Links of the list of connections of the io_context, kept by
+  /// connection_manager without allocating.
+  connection_base *prev_ = nullptr;
+  connection_base *next_ = nullptr;
+  struct registry *registry_ = nullptr;
+  std::weak_ptr<connection_base> self_;
+};
+
+/// The open connections of one io_context.
+struct registry {
+  std::mutex mutex;
+  connection_base *head = nullptr;
+};
+
+/// Keeps count of the connections of a server against an optional
+/// limit.  Accepted connections take a slot, which they release when
+/// they are destroyed.  Accept operations which find no free slot
+/// park themselves here and are resumed once a slot is released, so
+/// that the server stops accepting instead of running out of memory.
+/// It is shared with the connections, which may outlive the server.
+///
+/// Accepting and closing a connection only touch atomic counters and
+/// the list of connections of its own io_context, so that the shards
+/// of a sharded server do not contend.  The lock of the manager is
+/// only taken while accept operations are parked, and by drain().
+class connection_manager : private boost::noncopyable {
+public:
+  /// Keeps a list of connections for each of |contexts|.
+  explicit connection_manager(
+      const std::vector<boost::asio::io_context *> &contexts);
+
+  /// Sets the maximum number of connections; 0 means no limit.
+  void limit(std::size_t max_connections);
+
+  /// Returns true if there is a free slot.
+  bool available();
+
+  /// Takes a slot for a newly accepted connection.  Returns false if
+  /// there is none, or if the server is draining, in which case the
+  /// connection must be closed.
+  bool acquire();
+
+  /// Registers |conn|, which holds a slot and runs on |ioc|, for
+  /// drain() and close_all().
+  void add(const std::shared_ptr<connection_base> &conn,
+           boost::asio::io_context &ioc);
+
+  /// Releases the slot of |conn|, resuming the parked accept
+  /// operations.
+  void release(connection_base *conn);
+
+  /// Calls |resume| once a slot is free, right away if there is one
+  /// already.
+  void park(std::function<void()> resume);
+
+  /// Drops the parked accept operations.
+  void clear();
+
+  /// Stops admitting connections and shuts down the open ones.
+  /// |drained| is called once the last one is gone, right away if
+  /// there is none.
+  void drain(std::function<void()> drained);
+
+  /// Closes all the open connections.
+  void close_all();
+
+  /// Returns true once drain() has been called.
+  bool draining();
+
+  server_stats stats();
+
+private:
+  /// Gives a slot back, resuming the parked accept operations and
+  /// finishing drain() if it was the last one.
+  void release_slot();
+
+  /// Resumes the parked accept operations.
+  void resume_parked();
+
+  /// Calls the callback given to drain(), at most once.
+  void drained();
+
+  /// Returns the open connections.
+  std::vector<std::shared_ptr<connection_base>> live();
+
+  /// Never changed after construction, so that it is read without
+  /// locking.
+  std::unordered_map<boost::asio::io_context *, std::unique_ptr<registry>>
+      registries_;
+  /// Guards parked_ and drained_.
+  std::mutex mutex_;
+  std::vector<std::function<void()>> parked_;
+  /// Set by drain(), called when the last connection is gone.
+  std::function<void()> drained_;
+  std::atomic<std::size_t> max_connections_;
+  std::atomic<std::size_t> active_;
+  /// The size of parked_, read without locking.
+  std::atomic<std::size_t> paused_;
+  std::atomic<uint64_t> accepted_;
+  std::atomic<uint64_t> rejected_;
+  std::atomic<uint64_t> accept_pauses_;
+  std::atomic<bool> draining_;
+};
+
+} // namespace server
+
+} // namespace asio_http2
+
+} // namespace nghttp2
+
+#endif // ASIO_SERVER_CONNECTION_MANAGER_H
@@ -0,0 +1,73 @@
+/*
+ * nghttp2 - HTTP/2 C Library
+ *
+ * Copyright (c) 2015 Tatsuhiro Tsujikawa
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef ASIO_SERVER_CONNECTION_OPTIONS_H
+#define ASIO_SERVER_CONNECTION_OPTIONS_H
+
+#include "nghttp2_config.h"
+
+#include <chrono>
+#include <cstddef>
+
+#include <nghttp2/asio_http2_server.h>
+
+#include "template.h"
+
+namespace nghttp2 {
+
+namespace asio_http2 {
+
+namespace server {
+
+/// Per connection settings, configured through http2 and handed down
+/// to every connection by the server.
+struct connection_options {
+  std::chrono::microseconds tls_handshake_timeout = std::chrono::seconds(60);
+  std::chrono::microseconds read_timeout = std::chrono::seconds(60);
+  /// Bounds of the adaptive read buffer.  The buffer starts at
+  /// read_buffer_min bytes, doubles whenever a read fills it and
+  /// halves after a run of reads using less than a quarter of it.
+  std::size_t read_buffer_min = 8_k;
+  std::size_t read_buffer_max = 64_k;
+  /// If true, after a read completes the connection keeps reading
+  /// without blocking until the socket would block, before going back
+  /// to the reactor.
+  bool drain_reads = false;
+  /// If true, TLS connections use ktls_stream and let OpenSSL enable
+  /// kernel TLS after the handshake.
+  bool ktls = false;
+  /// If true, request header fields reference the buffers nghttp2
+  /// decoded them into instead of being copied.
+  bool header_refs = false;
+  /// SETTINGS sent to the client and options of the session.
+  server_settings settings;
+};
+
+} // namespace server
+
+} // namespace asio_http2
+
+} // namespace nghttp2
+
+#endif // ASIO_SERVER_CONNECTION_OPTIONS_H
@@ -0,0 +1,79 @@
+/*
+ * nghttp2 - HTTP/2 C Library
+ *
+ * Copyright (c) 2015 Tatsuhiro Tsujikawa
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "asio_server_connection_pool.h"
+
+namespace nghttp2 {
+namespace asio_http2 {
+namespace server {
+
+connection_pool::connection_pool(std::size_t capacity)
+    : capacity_(capacity), hits_(0), misses_(0) {
+  free_.reserve(capacity_);
+}
+
+connection_pool::~connection_pool() {
+  for (auto conn : free_) {
+    delete conn;
+  }
+}
+
+connection_base *connection_pool::pop() {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  if (free_.empty()) {
+    ++misses_;
+    return nullptr;
+  }
+
+  ++hits_;
+  auto conn = free_.back();
+  free_.pop_back();
+  return conn;
+}
+
+void connection_pool::release(connection_base *conn) {
+  // Done outside of the lock; this closes the streams left, which
+  // calls back into the application.
+  if (conn->recycle()) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (free_.size() < capacity_) {
+      free_.push_back(conn);
+      return;
+    }
+  }
+
+  delete conn;
+}
+
+void connection_pool::add_stats(server_stats &stats) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  stats.pooled_connections += free_.size();
+  stats.pool_hits += hits_;
+  stats.pool_misses += misses_;
+}
+
+} // namespace server
+} // namespace asio_http2
+} // namespace nghttp2
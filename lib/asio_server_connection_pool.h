@@ -0,0 +1,104 @@
+/*
+ * nghttp2 - HTTP/2 C Library
+ *
+ * Copyright (c) 2015 Tatsuhiro Tsujikawa
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef ASIO_SERVER_CONNECTION_POOL_H
+#define ASIO_SERVER_CONNECTION_POOL_H
+
+#include "nghttp2_config.h"
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+
+#include <nghttp2/asio_http2_server.h>
+
+#include "asio_server_connection_manager.h"
+
+namespace nghttp2 {
+
+namespace asio_http2 {
+
+namespace server {
+
+/// Free list of closed connection objects of one io_context.  A
+/// connection handed out by acquire() comes back here when its last
+/// reference goes away: it is reset with connection_base::recycle(),
+/// keeping its socket, strand, timer, read buffer and http2_handler,
+/// and the next accept on the io_context reuses it instead of
+/// allocating a new one.  At most |capacity| connections are kept;
+/// the others are deleted.  All the connections of a pool must be of
+/// the same type.  The pool is shared with the connections, which may
+/// outlive the server.
+class connection_pool : public std::enable_shared_from_this<connection_pool>,
+                        private boost::noncopyable {
+public:
+  explicit connection_pool(std::size_t capacity);
+  ~connection_pool();
+
+  /// Returns a pooled connection, or one created by |make| if the pool
+  /// is empty.  |make| returns a connection_type * allocated with new.
+  template <typename connection_type, typename Make>
+  std::shared_ptr<connection_type> acquire(Make &&make) {
+    auto conn = static_cast<connection_type *>(pop());
+    if (!conn) {
+      conn = make();
+    }
+
+    return std::shared_ptr<connection_type>(
+        conn, [pool = weak_from_this()](connection_type *conn) {
+          if (auto p = pool.lock()) {
+            p->release(conn);
+            return;
+          }
+          delete conn;
+        });
+  }
+
+  /// Adds the counters of the pool to |stats|.
+  void add_stats(server_stats &stats);
+
+private:
+  /// Returns a pooled connection or nullptr, counting a hit or a miss.
+  connection_base *pop();
+
+  /// Takes back |conn|, whose last reference is gone.
+  void release(connection_base *conn);
+
+  std::mutex mutex_;
+  std::vector<connection_base *> free_;
+  std::size_t capacity_;
+  uint64_t hits_;
+  uint64_t misses_;
+};
+
+} // namespace server
+
+} // namespace asio_http2
+
+} // namespace nghttp2
+
+#endif // ASIO_SERVER_CONNECTION_POOL_H
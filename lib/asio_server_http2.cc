@@ -67,8 +67,26 @@ boost::system::error_code http2::listen_and_serve(
 
 void http2::num_threads(size_t num_threads) { impl_->num_threads(num_threads); }
 
+void http2::sharded(bool sharded) { impl_->sharded(sharded); }
+
+void http2::thread_affinity(std::vector<int> ids, affinity_kind kind) {
+  impl_->thread_affinity(std::move(ids), kind);
+}
+
 void http2::backlog(int backlog) { impl_->backlog(backlog); }
 
+void http2::pending_accepts(std::size_t n) { impl_->pending_accepts(n); }
+
+void http2::accept_batch(std::size_t n) { impl_->accept_batch(n); }
+
+void http2::max_connections(std::size_t n) { impl_->max_connections(n); }
+
+void http2::connection_pool_size(std::size_t n) {
+  impl_->connection_pool_size(n);
+}
+
+void http2::settings(const server_settings &s) { impl_->settings(s); }
+
 void http2::tls_handshake_timeout(const std::chrono::microseconds &t) {
   impl_->tls_handshake_timeout(t);
 }
@@ -77,12 +95,26 @@ void http2::read_timeout(const std::chrono::microseconds &t) {
   impl_->read_timeout(t);
 }
 
+void http2::read_buffer_size(std::size_t min, std::size_t max) {
+  impl_->read_buffer_size(min, max);
+}
+
+void http2::drain_reads(bool f) { impl_->drain_reads(f); }
+
+void http2::ktls(bool f) { impl_->ktls(f); }
+
+void http2::header_refs(bool f) { impl_->header_refs(f); }
+
 bool http2::handle(std::string pattern, request_cb cb) {
   return impl_->handle(std::move(pattern), std::move(cb));
 }
 
 void http2::stop() { impl_->stop(); }
 
+void http2::shutdown(const std::chrono::microseconds &deadline) {
+  impl_->shutdown(deadline);
+}
+
 void http2::join() { return impl_->join(); }
 
 boost::asio::io_context& http2::executor() const {
@@ -91,6 +123,8 @@ boost::asio::io_context& http2::executor() const {
 
 std::vector<int> http2::ports() const { return impl_->ports(); }
 
+server_stats http2::stats() const { return impl_->stats(); }
+
 } // namespace server
 
 } // namespace asio_http2
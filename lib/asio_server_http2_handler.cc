@@ -24,6 +24,7 @@
  */
 #include "asio_server_http2_handler.h"
 
+#include <array>
 #include <iostream>
 
 #include "asio_common.h"
@@ -31,6 +32,7 @@
 #include "asio_server_stream.h"
 #include "asio_server_request_impl.h"
 #include "asio_server_response_impl.h"
+#include "asio_server_prebuilt_response_impl.h"
 #include "http2.h"
 #include "util.h"
 #include "template.h"
@@ -66,10 +68,13 @@ int on_begin_headers_callback(nghttp2_session *session,
 } // namespace
 
 namespace {
-int on_header_callback(nghttp2_session *session, const nghttp2_frame *frame,
-                       const uint8_t *name, size_t namelen,
-                       const uint8_t *value, size_t valuelen, uint8_t flags,
-                       void *user_data) {
+// Handles a request header field.  If |namebuf| and |valuebuf| are not
+// null, they hold |name| and |value| and are referenced rather than
+// copied.
+int on_header(nghttp2_session *session, const nghttp2_frame *frame,
+              const uint8_t *name, size_t namelen, const uint8_t *value,
+              size_t valuelen, uint8_t flags, nghttp2_rcbuf *namebuf,
+              nghttp2_rcbuf *valuebuf, void *user_data) {
   auto handler = static_cast<http2_handler *>(user_data);
   auto stream_id = frame->hd.stream_id;
 
@@ -112,15 +117,39 @@ int on_header_callback(nghttp2_session *session, const nghttp2_frame *frame,
     }
     req.update_header_buffer_size(namelen + valuelen);
 
-    req.header().emplace(std::string(name, name + namelen),
-                         header_value{std::string(value, value + valuelen),
-                                      (flags & NGHTTP2_NV_FLAG_NO_INDEX) != 0});
+    auto sensitive = (flags & NGHTTP2_NV_FLAG_NO_INDEX) != 0;
+    if (namebuf) {
+      req.fields().add(namebuf, valuebuf, sensitive);
+    } else {
+      req.fields().add(name, namelen, value, valuelen, sensitive);
+    }
   }
 
   return 0;
 }
 } // namespace
 
+namespace {
+int on_header_callback(nghttp2_session *session, const nghttp2_frame *frame,
+                       const uint8_t *name, size_t namelen,
+                       const uint8_t *value, size_t valuelen, uint8_t flags,
+                       void *user_data) {
+  return on_header(session, frame, name, namelen, value, valuelen, flags,
+                   nullptr, nullptr, user_data);
+}
+} // namespace
+
+namespace {
+int on_header_callback2(nghttp2_session *session, const nghttp2_frame *frame,
+                        nghttp2_rcbuf *name, nghttp2_rcbuf *value,
+                        uint8_t flags, void *user_data) {
+  auto namebuf = nghttp2_rcbuf_get_buf(name);
+  auto valuebuf = nghttp2_rcbuf_get_buf(value);
+  return on_header(session, frame, namebuf.base, namebuf.len, valuebuf.base,
+                   valuebuf.len, flags, name, value, user_data);
+}
+} // namespace
+
 namespace {
 int on_frame_recv_callback(nghttp2_session *session, const nghttp2_frame *frame,
                            void *user_data) {
@@ -154,6 +183,12 @@ int on_frame_recv_callback(nghttp2_session *session, const nghttp2_frame *frame,
 
     break;
   }
+  case NGHTTP2_PING:
+    if (frame->hd.flags & NGHTTP2_FLAG_ACK) {
+      handler->ping_acked(frame->ping.opaque_data);
+    }
+
+    break;
   }
 
   return 0;
@@ -167,11 +202,19 @@ int on_data_chunk_recv_callback(nghttp2_session *session, uint8_t flags,
   auto handler = static_cast<http2_handler *>(user_data);
   auto strm = handler->find_stream(stream_id);
 
+  handler->data_received(len);
+
   if (!strm) {
+    handler->consume(stream_id, len);
     return 0;
   }
 
-  strm->request().impl().call_on_data(data, len);
+  auto &req = strm->request().impl();
+  req.call_on_data(data, len);
+
+  if (handler->manual_flow_control()) {
+    req.received(len);
+  }
 
   return 0;
 }
@@ -188,6 +231,7 @@ int on_stream_close_callback(nghttp2_session *session, int32_t stream_id,
     return 0;
   }
 
+  strm->request().impl().call_on_close(error_code);
   strm->response().impl().call_on_close(error_code);
 
   handler->close_stream(stream_id);
@@ -218,6 +262,18 @@ int on_frame_send_callback(nghttp2_session *session, const nghttp2_frame *frame,
 }
 } // namespace
 
+namespace {
+int send_data_callback(nghttp2_session *session, nghttp2_frame *frame,
+                       const uint8_t *framehd, size_t length,
+                       nghttp2_data_source *source, void *user_data) {
+  auto handler = static_cast<http2_handler *>(user_data);
+  auto &strm = *static_cast<stream *>(source->ptr);
+
+  return strm.response().impl().call_send(handler->output(), frame, framehd,
+                                          length);
+}
+} // namespace
+
 namespace {
 int on_frame_not_send_callback(nghttp2_session *session,
                                const nghttp2_frame *frame, int lib_error_code,
@@ -236,26 +292,41 @@ int on_frame_not_send_callback(nghttp2_session *session,
 
 http2_handler::http2_handler(boost::asio::strand<boost::asio::io_context::executor_type> strand,
                              boost::asio::ip::tcp::endpoint ep,
-                             connection_write writefun, serve_mux &mux)
+                             connection_write writefun, serve_mux &mux,
+                             const connection_options &opts)
     : writefun_(writefun),
       mux_(mux),
       strand_(strand),
       remote_ep_(ep),
       session_(nullptr),
-      buf_(nullptr),
-      buflen_(0),
       inside_callback_(false),
       write_signaled_(false),
+      opts_(opts),
       tstamp_cached_(time(nullptr)),
       formatted_date_(util::http_date(tstamp_cached_)) {}
 
-http2_handler::~http2_handler() {
-  for (auto &p : streams_) {
-    auto &strm = p.second;
+http2_handler::~http2_handler() { close(); }
+
+void http2_handler::close() {
+  streams_.clear([this](stream *strm) {
+    strm->request().impl().call_on_close(NGHTTP2_INTERNAL_ERROR);
     strm->response().impl().call_on_close(NGHTTP2_INTERNAL_ERROR);
-  }
+    stream_slab_.destroy(strm);
+  });
 
   nghttp2_session_del(session_);
+  session_ = nullptr;
+  arena_.reset();
+  bdp_.reset();
+}
+
+void http2_handler::reset(boost::asio::ip::tcp::endpoint ep,
+                          connection_write writefun) {
+  writefun_ = std::move(writefun);
+  remote_ep_ = std::move(ep);
+  wb_.clear();
+  inside_callback_ = false;
+  write_signaled_ = false;
 }
 
 const std::string &http2_handler::http_date() {
@@ -280,8 +351,13 @@ int http2_handler::start() {
 
   nghttp2_session_callbacks_set_on_begin_headers_callback(
       callbacks, on_begin_headers_callback);
-  nghttp2_session_callbacks_set_on_header_callback(callbacks,
-                                                   on_header_callback);
+  if (opts_.header_refs) {
+    nghttp2_session_callbacks_set_on_header_callback2(callbacks,
+                                                      on_header_callback2);
+  } else {
+    nghttp2_session_callbacks_set_on_header_callback(callbacks,
+                                                     on_header_callback);
+  }
   nghttp2_session_callbacks_set_on_frame_recv_callback(callbacks,
                                                        on_frame_recv_callback);
   nghttp2_session_callbacks_set_on_data_chunk_recv_callback(
@@ -292,45 +368,115 @@ int http2_handler::start() {
                                                        on_frame_send_callback);
   nghttp2_session_callbacks_set_on_frame_not_send_callback(
       callbacks, on_frame_not_send_callback);
+  nghttp2_session_callbacks_set_send_data_callback(callbacks,
+                                                   send_data_callback);
+
+  auto &settings = opts_.settings;
+
+  nghttp2_option *option = nullptr;
+  if (settings.max_deflate_dynamic_table_size ||
+      settings.keep_closed_streams || manual_flow_control()) {
+    rv = nghttp2_option_new(&option);
+    if (rv != 0) {
+      return -1;
+    }
+    if (settings.max_deflate_dynamic_table_size) {
+      nghttp2_option_set_max_deflate_dynamic_table_size(
+          option, *settings.max_deflate_dynamic_table_size);
+    }
+    if (settings.keep_closed_streams) {
+      nghttp2_option_set_no_closed_streams(option,
+                                           !*settings.keep_closed_streams);
+    }
+    if (manual_flow_control()) {
+      nghttp2_option_set_no_auto_window_update(option, 1);
+    }
+  }
 
-  rv = nghttp2_session_server_new(&session_, callbacks, this);
+  auto opt_del = defer(nghttp2_option_del, option);
+
+  rv = nghttp2_session_server_new3(&session_, callbacks, this, option,
+                                   arena_.mem());
   if (rv != 0) {
     return -1;
   }
 
 #ifdef SERVER_MAX_CONCURRENT_STREAMS
-  nghttp2_settings_entry ent{NGHTTP2_SETTINGS_MAX_CONCURRENT_STREAMS, SERVER_MAX_CONCURRENT_STREAMS};
+  uint32_t max_concurrent_streams = SERVER_MAX_CONCURRENT_STREAMS;
 #else
-  nghttp2_settings_entry ent{NGHTTP2_SETTINGS_MAX_CONCURRENT_STREAMS, 100};
+  uint32_t max_concurrent_streams = 100;
 #endif
-  nghttp2_submit_settings(session_, NGHTTP2_FLAG_NONE, &ent, 1);
+  std::array<nghttp2_settings_entry, 5> ents;
+  size_t nent = 0;
+  ents[nent++] = {NGHTTP2_SETTINGS_MAX_CONCURRENT_STREAMS,
+                  settings.max_concurrent_streams.value_or(
+                      max_concurrent_streams)};
+  if (settings.initial_window_size) {
+    ents[nent++] = {NGHTTP2_SETTINGS_INITIAL_WINDOW_SIZE,
+                    *settings.initial_window_size};
+  }
+  if (settings.max_frame_size) {
+    ents[nent++] = {NGHTTP2_SETTINGS_MAX_FRAME_SIZE, *settings.max_frame_size};
+  }
+  if (settings.header_table_size) {
+    ents[nent++] = {NGHTTP2_SETTINGS_HEADER_TABLE_SIZE,
+                    *settings.header_table_size};
+  }
+  if (settings.max_header_list_size) {
+    ents[nent++] = {NGHTTP2_SETTINGS_MAX_HEADER_LIST_SIZE,
+                    *settings.max_header_list_size};
+  }
+  rv = nghttp2_submit_settings(session_, NGHTTP2_FLAG_NONE, ents.data(), nent);
+  if (rv != 0) {
+    return -1;
+  }
+
+  if (settings.connection_window_size) {
+    rv = nghttp2_session_set_local_window_size(
+        session_, NGHTTP2_FLAG_NONE, 0,
+        static_cast<int32_t>(*settings.connection_window_size));
+    if (rv != 0) {
+      return -1;
+    }
+  }
+
+  if (settings.max_auto_window_size) {
+    bdp_.emplace(
+        settings.initial_window_size.value_or(NGHTTP2_INITIAL_WINDOW_SIZE),
+        *settings.max_auto_window_size);
+  }
 
   return 0;
 }
 
 stream *http2_handler::create_stream(int32_t stream_id) {
-  auto p =
-      streams_.emplace(stream_id, std::make_unique<stream>(this, stream_id));
-  assert(p.second);
-  return (*p.first).second.get();
+  auto strm = stream_slab_.create(this, stream_id);
+  streams_.insert(stream_id, strm);
+  return strm;
 }
 
 void http2_handler::close_stream(int32_t stream_id) {
-  streams_.erase(stream_id);
+  if (auto strm = streams_.erase(stream_id)) {
+    // The connection window still needs the bytes held back.
+    if (auto n = strm->request().impl().unconsumed(); n > 0) {
+      nghttp2_session_consume_connection(session_, n);
+    }
+    stream_slab_.destroy(strm);
+  }
 }
 
 stream *http2_handler::find_stream(int32_t stream_id) {
-  auto i = streams_.find(stream_id);
-  if (i == std::end(streams_)) {
-    return nullptr;
-  }
-
-  return (*i).second.get();
+  return streams_.find(stream_id);
 }
 
 void http2_handler::call_on_request(stream &strm) {
-  auto cb = mux_.handler(strm.request().impl());
-  cb(strm.request(), strm.response());
+  auto &req = strm.request().impl();
+  if (auto uri = mux_.redirect(req)) {
+    redirect_handler(301, std::move(*uri))(strm.request(), strm.response());
+    return;
+  }
+
+  mux_.handler(req)(strm.request(), strm.response());
 }
 
 bool http2_handler::should_stop() const {
@@ -342,16 +488,23 @@ int http2_handler::start_response(stream &strm) {
   int rv;
 
   auto &res = strm.response().impl();
-  auto &header = res.header();
-  auto nva = std::vector<nghttp2_nv>();
-  nva.reserve(2 + header.size());
-  auto status = util::utos(res.status_code());
-  auto date = http_date();
-  nva.push_back(nghttp2::http2::make_nv_ls(":status", status));
-  nva.push_back(nghttp2::http2::make_nv_ls("date", date));
-  for (auto &hd : header) {
-    nva.push_back(nghttp2::http2::make_nv(hd.first, hd.second.value,
-                                          hd.second.sensitive));
+  auto &nva = nva_;
+  nva.clear();
+  auto &date = http_date();
+  std::string status;
+  if (auto prebuilt = res.prebuilt()) {
+    auto fields = prebuilt->nva();
+    nva.insert(std::end(nva), std::begin(fields), std::end(fields));
+    nva.push_back(nghttp2::http2::make_nv_ls("date", date));
+  } else {
+    auto &header = res.header();
+    status = util::utos(res.status_code());
+    nva.push_back(nghttp2::http2::make_nv_ls(":status", status));
+    nva.push_back(nghttp2::http2::make_nv_ls("date", date));
+    for (auto &hd : header) {
+      nva.push_back(nghttp2::http2::make_nv(hd.first, hd.second.value,
+                                            hd.second.sensitive));
+    }
   }
 
   nghttp2_data_provider *prd_ptr = nullptr, prd;
@@ -400,6 +553,30 @@ int http2_handler::submit_trailer(stream &strm, header_map h) {
   return 0;
 }
 
+int http2_handler::on_read(const uint8_t *data, std::size_t len) {
+  callback_guard cg(*this);
+
+  auto rv = nghttp2_session_mem_recv(session_, data, len);
+
+  if (rv < 0) {
+    return -1;
+  }
+
+  return 0;
+}
+
+int http2_handler::on_write(std::size_t &len) {
+  callback_guard cg(*this);
+
+  auto rv = fill_write_buffer(wb_, session_);
+
+  len = wb_.size();
+
+  return rv == 0 ? 0 : -1;
+}
+
+write_buffer &http2_handler::output() { return wb_; }
+
 void http2_handler::enter_callback() {
   assert(!inside_callback_);
   inside_callback_ = true;
@@ -415,6 +592,13 @@ void http2_handler::stream_error(int32_t stream_id, uint32_t error_code) {
   signal_write();
 }
 
+void http2_handler::shutdown() {
+  nghttp2_submit_goaway(session_, NGHTTP2_FLAG_NONE,
+                        nghttp2_session_get_last_proc_stream_id(session_),
+                        NGHTTP2_NO_ERROR, nullptr, 0);
+  signal_write();
+}
+
 void http2_handler::signal_write() {
   if (!inside_callback_ && !write_signaled_) {
     write_signaled_ = true;
@@ -433,6 +617,43 @@ void http2_handler::resume(stream &strm) {
   signal_write();
 }
 
+void http2_handler::data_received(std::size_t len) {
+  if (!bdp_ || !bdp_->received(len)) {
+    return;
+  }
+
+  nghttp2_submit_ping(session_, NGHTTP2_FLAG_NONE, bdp_->ping_data());
+  signal_write();
+}
+
+void http2_handler::ping_acked(const uint8_t *opaque_data) {
+  if (!bdp_ || !bdp_->acked(opaque_data)) {
+    return;
+  }
+
+  if (bdp_->apply(session_) != 0) {
+    // Stop tuning the windows, which gives back the share of the
+    // budget the new window was committed with.
+    bdp_.reset();
+    return;
+  }
+
+  signal_write();
+}
+
+bool http2_handler::manual_flow_control() const {
+  return opts_.settings.manual_flow_control.value_or(false);
+}
+
+void http2_handler::consume(int32_t stream_id, std::size_t n) {
+  if (!manual_flow_control() || n == 0) {
+    return;
+  }
+
+  nghttp2_session_consume(session_, stream_id, n);
+  signal_write();
+}
+
 response *http2_handler::push_promise(boost::system::error_code &ec,
                                       stream &strm, std::string method,
                                       std::string raw_path_query,
@@ -27,15 +27,22 @@
 
 #include "nghttp2_config.h"
 
-#include <map>
 #include <functional>
+#include <optional>
 #include <string>
+#include <vector>
 
-#include <boost/array.hpp>
 #include <boost/asio/strand.hpp>
 
 #include <nghttp2/asio_http2_server.h>
 
+#include "asio_bdp_estimator.h"
+#include "asio_server_connection_options.h"
+#include "asio_session_arena.h"
+#include "asio_slab.h"
+#include "asio_stream_table.h"
+#include "asio_write_buffer.h"
+
 namespace nghttp2 {
 namespace asio_http2 {
 namespace server {
@@ -56,12 +63,19 @@ class http2_handler : public std::enable_shared_from_this<http2_handler> {
 public:
   http2_handler(boost::asio::strand<boost::asio::io_context::executor_type> strand,
                 boost::asio::ip::tcp::endpoint ep, connection_write writefun,
-                serve_mux &mux);
+                serve_mux &mux, const connection_options &opts);
 
   ~http2_handler();
 
   int start();
 
+  // Closes the streams left and deletes the session.
+  void close();
+
+  // Prepares a close()d handler for a new connection from |ep|, to be
+  // started with start().  The write buffer keeps its capacity.
+  void reset(boost::asio::ip::tcp::endpoint ep, connection_write writefun);
+
   stream *create_stream(int32_t stream_id);
   void close_stream(int32_t stream_id);
   stream *find_stream(int32_t stream_id);
@@ -76,6 +90,11 @@ public:
 
   void stream_error(int32_t stream_id, uint32_t error_code);
 
+  // Submits GOAWAY with the last stream id processed so far.  The
+  // open streams may still finish, after which should_stop() becomes
+  // true.
+  void shutdown();
+
   void initiate_write();
 
   void enter_callback();
@@ -83,6 +102,21 @@ public:
 
   void resume(stream &s);
 
+  // Returns true if the request body is acknowledged through
+  // consume() rather than by nghttp2 as it is received.
+  bool manual_flow_control() const;
+
+  // Gives the client credit for |n| bytes of request body received on
+  // |stream_id|, with manual flow control.
+  void consume(int32_t stream_id, std::size_t n);
+
+  // Accounts for |len| bytes of request body received, for window
+  // auto tuning.
+  void data_received(std::size_t len);
+
+  // Handles the ACK of a PING we sent.
+  void ping_acked(const uint8_t *opaque_data);
+
   response *push_promise(boost::system::error_code &ec, stream &s,
                          std::string method, std::string raw_path_query,
                          header_map h);
@@ -95,75 +129,42 @@ public:
 
   const std::string &http_date();
 
-  template <size_t N>
-  int on_read(const boost::array<uint8_t, N> &buffer, std::size_t len) {
-    callback_guard cg(*this);
-
-    int rv;
-
-    rv = nghttp2_session_mem_recv(session_, buffer.data(), len);
-
-    if (rv < 0) {
-      return -1;
-    }
-
-    return 0;
-  }
-
-  template <size_t N>
-  int on_write(boost::array<uint8_t, N> &buffer, std::size_t &len) {
-    callback_guard cg(*this);
-
-    len = 0;
-
-    if (buf_) {
-      std::copy_n(buf_, buflen_, std::begin(buffer));
-
-      len += buflen_;
-
-      buf_ = nullptr;
-      buflen_ = 0;
-    }
-
-    for (;;) {
-      const uint8_t *data;
-      auto nread = nghttp2_session_mem_send(session_, &data);
-      if (nread < 0) {
-        return -1;
-      }
-
-      if (nread == 0) {
-        break;
-      }
-
-      if (len + nread > buffer.size()) {
-        buf_ = data;
-        buflen_ = nread;
-
-        break;
-      }
-
-      std::copy_n(data, nread, std::begin(buffer) + len);
+  // Feeds |len| bytes of |data| received from the client to the
+  // session.
+  int on_read(const uint8_t *data, std::size_t len);
 
-      len += nread;
-    }
+  // Gathers pending output into the write buffer returned by
+  // output().  |len| is set to the number of bytes gathered.
+  int on_write(std::size_t &len);
 
-    return 0;
-  }
+  // Returns the output of the current write.  It must be cleared once
+  // the write has completed.
+  write_buffer &output();
 
 private:
-  std::map<int32_t, std::shared_ptr<stream>> streams_;
+  // Storage of the streams, kept for the next ones once they close.
+  slab<stream> stream_slab_;
+  stream_table<stream> streams_;
   connection_write writefun_;
   serve_mux &mux_;
   boost::asio::strand<boost::asio::io_context::executor_type> strand_;
   boost::asio::ip::tcp::endpoint remote_ep_;
+  // Memory of session_, freed at once by close().
+  session_arena arena_;
   nghttp2_session *session_;
-  const uint8_t *buf_;
-  std::size_t buflen_;
+  // Set if windows are auto tuned.
+  std::optional<bdp_estimator> bdp_;
+  write_buffer wb_;
+  // Header fields of the response being submitted, kept for the
+  // capacity.
+  std::vector<nghttp2_nv> nva_;
   bool inside_callback_;
   // true if we have pending on_write call.  This avoids repeated call
   // of io_context::post.
   bool write_signaled_;
+  // Options of the session, and whether request header fields
+  // reference nghttp2's buffers instead of copying them.
+  connection_options opts_;
   time_t tstamp_cached_;
   std::string formatted_date_;
 };
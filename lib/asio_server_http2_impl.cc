@@ -26,6 +26,7 @@
 
 #include <openssl/ssl.h>
 
+#include <algorithm>
 #include <memory>
 
 #include "asio_server.h"
@@ -41,37 +42,102 @@ namespace server {
 
 http2_impl::http2_impl()
     : num_threads_(1),
+      sharded_(false),
+      affinity_kind_(affinity_kind::cpu),
       backlog_(-1),
-      tls_handshake_timeout_(std::chrono::seconds(60)),
-      read_timeout_(std::chrono::seconds(60)) {}
+      pending_accepts_(1),
+      accept_batch_(1),
+      max_connections_(0),
+      connection_pool_size_(0) {}
 
 boost::system::error_code http2_impl::listen_and_serve(
     boost::system::error_code &ec, boost::asio::ssl::context *tls_context,
     const std::string &address, const std::string &port, bool asynchronous) {
-  server_ = std::make_unique<server>(num_threads_, tls_handshake_timeout_, read_timeout_);
+  server_ = std::make_unique<server>(num_threads_, sharded_,
+                                     connection_options_);
+  server_->accept_concurrency(pending_accepts_, accept_batch_);
+  server_->max_connections(max_connections_);
+  server_->connection_pool_size(connection_pool_size_);
+  if (!affinity_ids_.empty() &&
+      server_->thread_affinity(ec, affinity_ids_,
+                               affinity_kind_ == affinity_kind::numa_node)) {
+    return ec;
+  }
   return server_->listen_and_serve(ec, tls_context, address, port, backlog_,
                                    mux_, asynchronous);
 }
 
 void http2_impl::num_threads(size_t num_threads) { num_threads_ = num_threads; }
 
+void http2_impl::sharded(bool sharded) { sharded_ = sharded; }
+
+void http2_impl::thread_affinity(std::vector<int> ids, affinity_kind kind) {
+  affinity_ids_ = std::move(ids);
+  affinity_kind_ = kind;
+}
+
 void http2_impl::backlog(int backlog) { backlog_ = backlog; }
 
+void http2_impl::pending_accepts(std::size_t n) { pending_accepts_ = n; }
+
+void http2_impl::accept_batch(std::size_t n) { accept_batch_ = n; }
+
+void http2_impl::max_connections(std::size_t n) { max_connections_ = n; }
+
+void http2_impl::connection_pool_size(std::size_t n) {
+  connection_pool_size_ = n;
+}
+
+void http2_impl::settings(const server_settings &s) {
+  auto &dst = connection_options_.settings;
+  dst = s;
+
+  constexpr uint32_t max_window_size = (1u << 31) - 1;
+  if (dst.initial_window_size) {
+    dst.initial_window_size =
+        std::min(*dst.initial_window_size, max_window_size);
+  }
+  if (dst.connection_window_size) {
+    dst.connection_window_size =
+        std::min(*dst.connection_window_size, max_window_size);
+  }
+  if (dst.max_frame_size) {
+    dst.max_frame_size = std::clamp(*dst.max_frame_size, uint32_t{16_k},
+                                    uint32_t{16_m - 1});
+  }
+}
+
 void http2_impl::tls_handshake_timeout(
     const std::chrono::microseconds &t) {
-  tls_handshake_timeout_ = t;
+  connection_options_.tls_handshake_timeout = t;
 }
 
 void http2_impl::read_timeout(const std::chrono::microseconds &t) {
-  read_timeout_ = t;
+  connection_options_.read_timeout = t;
 }
 
+void http2_impl::read_buffer_size(std::size_t min, std::size_t max) {
+  connection_options_.read_buffer_min = std::max<std::size_t>(min, 1);
+  connection_options_.read_buffer_max =
+      std::max(max, connection_options_.read_buffer_min);
+}
+
+void http2_impl::drain_reads(bool f) { connection_options_.drain_reads = f; }
+
+void http2_impl::ktls(bool f) { connection_options_.ktls = f; }
+
+void http2_impl::header_refs(bool f) { connection_options_.header_refs = f; }
+
 bool http2_impl::handle(std::string pattern, request_cb cb) {
   return mux_.handle(std::move(pattern), std::move(cb));
 }
 
 void http2_impl::stop() { return server_->stop(); }
 
+void http2_impl::shutdown(const std::chrono::microseconds &deadline) {
+  server_->shutdown(deadline);
+}
+
 void http2_impl::join() { return server_->join(); }
 
 boost::asio::io_context & http2_impl::executor() const {
@@ -80,6 +146,13 @@ boost::asio::io_context & http2_impl::executor() const {
 
 std::vector<int> http2_impl::ports() const { return server_->ports(); }
 
+server_stats http2_impl::stats() const {
+  if (!server_) {
+    return server_stats{};
+  }
+  return server_->stats();
+}
+
 } // namespace server
 
 } // namespace asio_http2
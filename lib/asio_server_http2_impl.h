@@ -29,6 +29,7 @@
 
 #include <nghttp2/asio_http2_server.h>
 
+#include "asio_server_connection_options.h"
 #include "asio_server_serve_mux.h"
 
 namespace nghttp2 {
@@ -46,22 +47,41 @@ public:
       boost::system::error_code &ec, boost::asio::ssl::context *tls_context,
       const std::string &address, const std::string &port, bool asynchronous);
   void num_threads(size_t num_threads);
+  void sharded(bool sharded);
+  void thread_affinity(std::vector<int> ids, affinity_kind kind);
   void backlog(int backlog);
+  void pending_accepts(std::size_t n);
+  void accept_batch(std::size_t n);
+  void max_connections(std::size_t n);
+  void connection_pool_size(std::size_t n);
+  void settings(const server_settings &s);
   void tls_handshake_timeout(const std::chrono::microseconds &t);
   void read_timeout(const std::chrono::microseconds &t);
+  void read_buffer_size(std::size_t min, std::size_t max);
+  void drain_reads(bool f);
+  void ktls(bool f);
+  void header_refs(bool f);
   bool handle(std::string pattern, request_cb cb);
   void stop();
+  void shutdown(const std::chrono::microseconds &deadline);
   void join();
   boost::asio::io_context & executor() const;
   std::vector<int> ports() const;
+  server_stats stats() const;
 
 private:
   std::unique_ptr<server> server_;
   std::size_t num_threads_;
+  bool sharded_;
+  std::vector<int> affinity_ids_;
+  affinity_kind affinity_kind_;
   int backlog_;
+  std::size_t pending_accepts_;
+  std::size_t accept_batch_;
+  std::size_t max_connections_;
+  std::size_t connection_pool_size_;
   serve_mux mux_;
-  std::chrono::microseconds tls_handshake_timeout_;
-  std::chrono::microseconds read_timeout_;
+  connection_options connection_options_;
 };
 
 } // namespace server
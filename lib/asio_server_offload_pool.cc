@@ -0,0 +1,89 @@
+/*
+ * nghttp2 - HTTP/2 C Library
+ *
+ * Copyright (c) 2015 Tatsuhiro Tsujikawa
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "nghttp2_config.h"
+
+#include <nghttp2/asio_http2_server.h>
+
+#include "asio_server_offload_pool_impl.h"
+#include "asio_server_offload_response_impl.h"
+
+namespace nghttp2 {
+namespace asio_http2 {
+namespace server {
+
+offload_pool::offload_pool(std::size_t num_threads, std::size_t max_queued)
+    : impl_(std::make_shared<offload_pool_impl>(num_threads, max_queued)) {}
+
+offload_pool::~offload_pool() { impl_->stop(); }
+
+offload_stats offload_pool::stats() const { return impl_->stats(); }
+
+const std::shared_ptr<offload_pool_impl> &offload_pool::impl() const {
+  return impl_;
+}
+
+request_cb offload_handler(offload_pool &pool, offload_request_cb cb,
+                           std::size_t max_body) {
+  // Shared, so that the handler is not copied for each request.
+  auto shared_cb = std::make_shared<const offload_request_cb>(std::move(cb));
+
+  return [pool = pool.impl(), cb = std::move(shared_cb),
+          max_body](const request &req, const response &res) {
+    req.async_read_all(max_body, [pool, cb, &req,
+                                  &res](const boost::system::error_code &ec,
+                                        std::string body) {
+      if (ec == boost::asio::error::message_size) {
+        res.write_head(413);
+        res.end();
+        return;
+      }
+
+      if (ec) {
+        // The stream is closed.
+        return;
+      }
+
+      auto oreq = std::make_shared<const offload_request>(
+          offload_request{req.method(), req.uri(), req.header(),
+                          std::move(body), req.remote_endpoint()});
+      auto ores = std::make_shared<offload_response_impl>(res.impl());
+
+      if (!pool->submit([cb, oreq, ores]() {
+            try {
+              (*cb)(*oreq, offload_response{ores});
+            } catch (...) {
+              ores->abandon();
+            }
+          })) {
+        ores->write_head(503, header_map{});
+        ores->end(std::string{});
+      }
+    });
+  };
+}
+
+} // namespace server
+} // namespace asio_http2
+} // namespace nghttp2
@@ -0,0 +1,176 @@
+/*
+ * nghttp2 - HTTP/2 C Library
+ *
+ * Copyright (c) 2015 Tatsuhiro Tsujikawa
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "asio_server_offload_pool_impl.h"
+
+#include <algorithm>
+
+namespace nghttp2 {
+namespace asio_http2 {
+namespace server {
+
+offload_pool_impl::offload_pool_impl(std::size_t num_threads,
+                                     std::size_t max_queued)
+    : max_queued_(max_queued),
+      next_(0),
+      queued_(0),
+      max_seen_(0),
+      running_(0),
+      executed_(0),
+      stolen_(0),
+      rejected_(0),
+      stopped_(false) {
+  num_threads = std::max<std::size_t>(num_threads, 1);
+
+  for (std::size_t i = 0; i < num_threads; ++i) {
+    queues_.push_back(std::make_unique<queue>());
+  }
+
+  for (std::size_t i = 0; i < num_threads; ++i) {
+    threads_.emplace_back([this, i]() { run(i); });
+  }
+}
+
+offload_pool_impl::~offload_pool_impl() { stop(); }
+
+bool offload_pool_impl::submit(task t) {
+  // Reserves a slot first, so that concurrent submits cannot queue
+  // more than max_queued_ tasks between them.
+  auto n = queued_.load();
+  do {
+    if (n >= max_queued_) {
+      ++rejected_;
+      return false;
+    }
+  } while (!queued_.compare_exchange_weak(n, n + 1));
+  ++n;
+
+  auto &q = *queues_[next_++ % queues_.size()];
+  {
+    std::lock_guard<std::mutex> g(q.mu);
+    // stop() drains each queue with its lock held after setting
+    // stopped_, so that no task is left behind once it returns.
+    if (stopped_) {
+      --queued_;
+      ++rejected_;
+      return false;
+    }
+    q.tasks.push_back(std::move(t));
+  }
+
+  auto m = max_seen_.load();
+  while (m < n && !max_seen_.compare_exchange_weak(m, n)) {
+  }
+
+  {
+    // An idle thread checks queued_ with mu_ held before it sleeps, so
+    // that it cannot miss this notification.
+    std::lock_guard<std::mutex> g(mu_);
+  }
+  cv_.notify_one();
+
+  return true;
+}
+
+void offload_pool_impl::stop() {
+  {
+    std::lock_guard<std::mutex> g(mu_);
+    if (stopped_) {
+      return;
+    }
+    stopped_ = true;
+  }
+  cv_.notify_all();
+
+  for (auto &t : threads_) {
+    t.join();
+  }
+
+  for (auto &q : queues_) {
+    std::deque<task> tasks;
+    {
+      std::lock_guard<std::mutex> g(q->mu);
+      tasks.swap(q->tasks);
+      queued_ -= tasks.size();
+    }
+  }
+}
+
+offload_stats offload_pool_impl::stats() const {
+  offload_stats s;
+  s.queued = queued_;
+  s.max_queued = max_seen_;
+  s.running = running_;
+  s.executed = executed_;
+  s.stolen = stolen_;
+  s.rejected = rejected_;
+  return s;
+}
+
+void offload_pool_impl::run(std::size_t i) {
+  for (;;) {
+    if (stopped_) {
+      return;
+    }
+
+    task t;
+    if (pop(i, t)) {
+      ++running_;
+      t();
+      ++executed_;
+      --running_;
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lk(mu_);
+    cv_.wait(lk, [this]() { return stopped_ || queued_ > 0; });
+  }
+}
+
+bool offload_pool_impl::pop(std::size_t i, task &t) {
+  auto n = queues_.size();
+  for (std::size_t k = 0; k < n; ++k) {
+    auto &q = *queues_[(i + k) % n];
+    std::lock_guard<std::mutex> g(q.mu);
+    if (q.tasks.empty()) {
+      continue;
+    }
+
+    t = std::move(q.tasks.front());
+    q.tasks.pop_front();
+    --queued_;
+
+    if (k != 0) {
+      ++stolen_;
+    }
+
+    return true;
+  }
+
+  return false;
+}
+
+} // namespace server
+} // namespace asio_http2
+} // namespace nghttp2
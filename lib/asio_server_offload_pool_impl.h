@@ -0,0 +1,105 @@
+/*
+ * nghttp2 - HTTP/2 C Library
+ *
+ * Copyright (c) 2015 Tatsuhiro Tsujikawa
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef ASIO_SERVER_OFFLOAD_POOL_IMPL_H
+#define ASIO_SERVER_OFFLOAD_POOL_IMPL_H
+
+#include "nghttp2_config.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <nghttp2/asio_http2_server.h>
+
+namespace nghttp2 {
+namespace asio_http2 {
+namespace server {
+
+// Bounded thread pool behind offload_pool.  Each thread pops the
+// tasks of its own queue in order, and when it is empty, steals the
+// oldest task of the next non-empty queue.  Tasks are spread over the
+// queues in turn, as they are submitted from the threads serving the
+// connections rather than from the pool itself.
+class offload_pool_impl {
+public:
+  using task = std::function<void()>;
+
+  offload_pool_impl(std::size_t num_threads, std::size_t max_queued);
+  ~offload_pool_impl();
+
+  offload_pool_impl(const offload_pool_impl &) = delete;
+  offload_pool_impl &operator=(const offload_pool_impl &) = delete;
+
+  // Queues |t| to be run by a thread.  Returns false if the queues
+  // already hold max_queued tasks or the pool is stopped.
+  bool submit(task t);
+
+  // Joins the threads once the running tasks return, and destroys the
+  // queued tasks.  Further submit() fail.
+  void stop();
+
+  offload_stats stats() const;
+
+private:
+  struct queue {
+    std::mutex mu;
+    std::deque<task> tasks;
+  };
+
+  void run(std::size_t i);
+  // Takes the next task for thread |i| into |t|.  Returns false if
+  // all the queues are empty.
+  bool pop(std::size_t i, task &t);
+
+  std::vector<std::unique_ptr<queue>> queues_;
+  std::vector<std::thread> threads_;
+  // Guards the sleep of idle threads, and stopped_ changing.
+  std::mutex mu_;
+  std::condition_variable cv_;
+  std::size_t max_queued_;
+  // Next queue submit() pushes to.
+  std::atomic<std::size_t> next_;
+  // Tasks in the queues, and slots submit() reserved for tasks it is
+  // about to push.  An idle thread may briefly find a reserved slot
+  // empty.
+  std::atomic<std::size_t> queued_;
+  std::atomic<std::size_t> max_seen_;
+  std::atomic<std::size_t> running_;
+  std::atomic<uint64_t> executed_;
+  std::atomic<uint64_t> stolen_;
+  std::atomic<uint64_t> rejected_;
+  std::atomic<bool> stopped_;
+};
+
+} // namespace server
+} // namespace asio_http2
+} // namespace nghttp2
+
+#endif // ASIO_SERVER_OFFLOAD_POOL_IMPL_H
@@ -0,0 +1,62 @@
+/*
+ * nghttp2 - HTTP/2 C Library
+ *
+ * Copyright (c) 2015 Tatsuhiro Tsujikawa
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "nghttp2_config.h"
+
+#include <nghttp2/asio_http2_server.h>
+
+#include "asio_server_offload_response_impl.h"
+
+namespace nghttp2 {
+namespace asio_http2 {
+namespace server {
+
+offload_response::offload_response(
+    std::shared_ptr<offload_response_impl> impl)
+    : impl_(std::move(impl)) {}
+
+void offload_response::write_head(unsigned int status_code,
+                                  header_map h) const {
+  impl_->write_head(status_code, std::move(h));
+}
+
+void offload_response::end(std::string data) const {
+  impl_->end(std::move(data));
+}
+
+void offload_response::end(buffer_chain body) const {
+  impl_->end(body.release());
+}
+
+void offload_response::end(const prebuilt_response &r) const {
+  impl_->end(r.impl());
+}
+
+void offload_response::cancel(uint32_t error_code) const {
+  impl_->cancel(error_code);
+}
+
+} // namespace server
+} // namespace asio_http2
+} // namespace nghttp2
@@ -0,0 +1,97 @@
+/*
+ * nghttp2 - HTTP/2 C Library
+ *
+ * Copyright (c) 2015 Tatsuhiro Tsujikawa
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "asio_server_offload_response_impl.h"
+
+#include <boost/asio/post.hpp>
+
+#include "asio_server_response_impl.h"
+#include "asio_server_stream.h"
+
+namespace nghttp2 {
+namespace asio_http2 {
+namespace server {
+
+offload_response_impl::offload_response_impl(response_impl &res)
+    : strand_(res.executor()),
+      token_(res.stream()->token()),
+      res_(&res),
+      done_(false) {}
+
+offload_response_impl::~offload_response_impl() { abandon(); }
+
+template <typename F> void offload_response_impl::post(F f) {
+  boost::asio::post(strand_, [f = std::move(f), token = token_,
+                               res = res_]() mutable {
+    // The stream may be closed since.
+    if (token.expired()) {
+      return;
+    }
+    f(*res);
+  });
+}
+
+void offload_response_impl::write_head(unsigned int status_code,
+                                       header_map h) {
+  post([status_code, h = std::move(h)](response_impl &res) mutable {
+    res.write_head(status_code, std::move(h));
+  });
+}
+
+void offload_response_impl::end(std::string data) {
+  done_ = true;
+  post([data = std::move(data)](response_impl &res) mutable {
+    res.end(std::move(data));
+  });
+}
+
+void offload_response_impl::end(std::unique_ptr<buffer_body> body) {
+  done_ = true;
+  post([body = std::move(body)](response_impl &res) mutable {
+    res.end(std::move(body));
+  });
+}
+
+void offload_response_impl::end(
+    std::shared_ptr<const prebuilt_response_impl> r) {
+  done_ = true;
+  post([r = std::move(r)](response_impl &res) { res.end(r); });
+}
+
+void offload_response_impl::cancel(uint32_t error_code) {
+  done_ = true;
+  post([error_code](response_impl &res) { res.cancel(error_code); });
+}
+
+void offload_response_impl::abandon() {
+  if (done_) {
+    return;
+  }
+
+  cancel(NGHTTP2_INTERNAL_ERROR);
+}
+
+} // namespace server
+} // namespace asio_http2
+} // namespace nghttp2
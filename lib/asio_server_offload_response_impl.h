@@ -0,0 +1,78 @@
+/*
+ * nghttp2 - HTTP/2 C Library
+ *
+ * Copyright (c) 2015 Tatsuhiro Tsujikawa
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef ASIO_SERVER_OFFLOAD_RESPONSE_IMPL_H
+#define ASIO_SERVER_OFFLOAD_RESPONSE_IMPL_H
+
+#include "nghttp2_config.h"
+
+#include <atomic>
+#include <memory>
+
+#include <nghttp2/asio_http2_server.h>
+#include <boost/asio/strand.hpp>
+
+#include "asio_write_buffer.h"
+
+namespace nghttp2 {
+namespace asio_http2 {
+namespace server {
+
+// Forwards the calls made on an offload_response, from any thread, to
+// the response on the executor of its stream.
+class offload_response_impl {
+public:
+  // Must be called from the executor of |res|.
+  explicit offload_response_impl(response_impl &res);
+  ~offload_response_impl();
+
+  offload_response_impl(const offload_response_impl &) = delete;
+  offload_response_impl &operator=(const offload_response_impl &) = delete;
+
+  void write_head(unsigned int status_code, header_map h);
+  void end(std::string data);
+  void end(std::unique_ptr<buffer_body> body);
+  void end(std::shared_ptr<const prebuilt_response_impl> r);
+  void cancel(uint32_t error_code);
+
+  // Resets the stream, unless end() or cancel() was called.
+  void abandon();
+
+private:
+  // Posts |f| to the executor of the stream, to be called with the
+  // response unless the stream is closed by then.
+  template <typename F> void post(F f);
+
+  boost::asio::strand<boost::asio::io_context::executor_type> strand_;
+  std::weak_ptr<const void> token_;
+  response_impl *res_;
+  // true once end() or cancel() was called.
+  std::atomic<bool> done_;
+};
+
+} // namespace server
+} // namespace asio_http2
+} // namespace nghttp2
+
+#endif // ASIO_SERVER_OFFLOAD_RESPONSE_IMPL_H
@@ -0,0 +1,81 @@
+/*
+ * nghttp2 - HTTP/2 C Library
+ *
+ * Copyright (c) 2015 Tatsuhiro Tsujikawa
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "asio_server_prebuilt_response_impl.h"
+
+#include "http2.h"
+#include "util.h"
+
+namespace nghttp2 {
+namespace asio_http2 {
+namespace server {
+
+namespace {
+nghttp2_nv make_nv_nocopy(const std::string &name, const std::string &value,
+                          bool no_index) {
+  return {(uint8_t *)name.c_str(), (uint8_t *)value.c_str(), name.size(),
+          value.size(),
+          static_cast<uint8_t>(NGHTTP2_NV_FLAG_NO_COPY_NAME |
+                               NGHTTP2_NV_FLAG_NO_COPY_VALUE |
+                               (no_index ? NGHTTP2_NV_FLAG_NO_INDEX
+                                         : NGHTTP2_NV_FLAG_NONE))};
+}
+} // namespace
+
+prebuilt_response_impl::prebuilt_response_impl(unsigned int status_code,
+                                               header_map h, std::string body)
+    : status_code_(status_code),
+      status_(util::utos(status_code)),
+      header_(std::move(h)),
+      body_(std::move(body)) {
+  if (::nghttp2::http2::expect_response_body(status_code) &&
+      header_.find("content-length") == std::end(header_)) {
+    header_.emplace("content-length", header_value{util::utos(body_.size())});
+  }
+
+  static const std::string status_name = ":status";
+
+  nva_.reserve(1 + header_.size());
+  nva_.push_back(make_nv_nocopy(status_name, status_, false));
+  for (auto &hd : header_) {
+    nva_.push_back(
+        make_nv_nocopy(hd.first, hd.second.value, hd.second.sensitive));
+  }
+}
+
+unsigned int prebuilt_response_impl::status_code() const {
+  return status_code_;
+}
+
+const header_map &prebuilt_response_impl::header() const { return header_; }
+
+const std::string &prebuilt_response_impl::body() const { return body_; }
+
+std::span<const nghttp2_nv> prebuilt_response_impl::nva() const {
+  return nva_;
+}
+
+} // namespace server
+} // namespace asio_http2
+} // namespace nghttp2
@@ -0,0 +1,67 @@
+/*
+ * nghttp2 - HTTP/2 C Library
+ *
+ * Copyright (c) 2015 Tatsuhiro Tsujikawa
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef ASIO_SERVER_PREBUILT_RESPONSE_IMPL_H
+#define ASIO_SERVER_PREBUILT_RESPONSE_IMPL_H
+
+#include "nghttp2_config.h"
+
+#include <span>
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+
+#include <nghttp2/asio_http2_server.h>
+
+namespace nghttp2 {
+namespace asio_http2 {
+namespace server {
+
+class prebuilt_response_impl : private boost::noncopyable {
+public:
+  prebuilt_response_impl(unsigned int status_code, header_map h,
+                         std::string body);
+
+  unsigned int status_code() const;
+  const header_map &header() const;
+  const std::string &body() const;
+
+  // Returns :status followed by the header fields, flagged so that
+  // nghttp2 references the strings of this object instead of copying
+  // them.
+  std::span<const nghttp2_nv> nva() const;
+
+private:
+  unsigned int status_code_;
+  std::string status_;
+  header_map header_;
+  std::string body_;
+  std::vector<nghttp2_nv> nva_;
+};
+
+} // namespace server
+} // namespace asio_http2
+} // namespace nghttp2
+
+#endif // ASIO_SERVER_PREBUILT_RESPONSE_IMPL_H
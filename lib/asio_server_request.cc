@@ -34,12 +34,14 @@ namespace nghttp2 {
 namespace asio_http2 {
 namespace server {
 
-request::request() : impl_(std::make_unique<request_impl>()) {}
+request::request(request_impl &impl) : impl_(&impl) {}
 
 request::~request() {}
 
 const header_map &request::header() const { return impl_->header(); }
 
+header_view request::fields() const { return impl_->fields().view(); }
+
 const std::string &request::method() const { return impl_->method(); }
 
 const uri_ref &request::uri() const { return impl_->uri(); }
@@ -48,6 +50,22 @@ void request::on_data(data_cb cb) const {
   return impl_->on_data(std::move(cb));
 }
 
+void request::pause() const { impl_->pause(); }
+
+void request::resume() const { impl_->resume(); }
+
+void request::consume(std::size_t n) const { impl_->consume(n); }
+
+void request::keep_body() const { impl_->keep_body(); }
+
+void request::async_read_some(read_cb cb) const {
+  impl_->read_some(std::move(cb));
+}
+
+void request::async_read_all(std::size_t limit, read_cb cb) const {
+  impl_->read_all(limit, std::move(cb));
+}
+
 request_impl &request::impl() const { return *impl_; }
 
 const boost::asio::ip::tcp::endpoint &request::remote_endpoint() const {
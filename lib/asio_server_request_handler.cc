@@ -52,37 +52,29 @@ std::string create_html(int status_code) {
 } // namespace
 
 request_cb redirect_handler(int status_code, std::string uri) {
-  return [status_code, uri](const request &req, const response &res) {
-    header_map h;
-    h.emplace("location", header_value{std::move(uri)});
-    std::string html;
-    if (req.method() == "GET") {
-      html = create_html(status_code);
-    }
-    h.emplace("content-length", header_value{util::utos(html.size())});
-
-    res.write_head(status_code, std::move(h));
-    res.end(std::move(html));
+  // Only GET gets the HTML body.
+  auto get = prebuilt_response(
+      status_code, {{"location", header_value{uri}}}, create_html(status_code));
+  auto other = prebuilt_response(status_code,
+                                 {{"location", header_value{std::move(uri)}}});
+  return [get, other](const request &req, const response &res) {
+    res.end(req.method() == "GET" ? get : other);
   };
 }
 
 request_cb status_handler(int status_code) {
-  return [status_code](const request &req, const response &res) {
-    if (!::nghttp2::http2::expect_response_body(status_code)) {
-      res.write_head(status_code);
-      res.end();
-      return;
-    }
-    // we supply content-length for HEAD request, but body will not be
-    // sent.
-    auto html = create_html(status_code);
-    header_map h;
-    h.emplace("content-length", header_value{util::utos(html.size())});
-    h.emplace("content-type", header_value{"text/html; charset=utf-8"});
+  if (!::nghttp2::http2::expect_response_body(status_code)) {
+    return prebuilt_handler(prebuilt_response(status_code));
+  }
+  // we supply content-length for HEAD request, but body will not be
+  // sent.
+  return prebuilt_handler(prebuilt_response(
+      status_code, {{"content-type", header_value{"text/html; charset=utf-8"}}},
+      create_html(status_code)));
+}
 
-    res.write_head(status_code, std::move(h));
-    res.end(std::move(html));
-  };
+request_cb prebuilt_handler(prebuilt_response r) {
+  return [r](const request &, const response &res) { res.end(r); };
 }
 
 } // namespace server
@@ -24,13 +24,32 @@
  */
 #include "asio_server_request_impl.h"
 
+#include <algorithm>
+#include <utility>
+
+#include <boost/asio/post.hpp>
+
+#include "asio_server_stream.h"
+#include "asio_server_http2_handler.h"
+
 namespace nghttp2 {
 namespace asio_http2 {
 namespace server {
 
-request_impl::request_impl() : strm_(nullptr), header_buffer_size_(0) {}
-
-const header_map &request_impl::header() const { return header_; }
+request_impl::request_impl()
+    : strm_(nullptr),
+      header_buffer_size_(0),
+      unconsumed_(0),
+      kept_taken_(0),
+      read_limit_(0),
+      taken_(0),
+      paused_(false),
+      keep_body_(false),
+      discard_(false),
+      eof_(false),
+      read_all_(false) {}
+
+const header_map &request_impl::header() const { return fields_.map(); }
 
 const std::string &request_impl::method() const { return method_; }
 
@@ -38,9 +57,11 @@ const uri_ref &request_impl::uri() const { return uri_; }
 
 uri_ref &request_impl::uri() { return uri_; }
 
-void request_impl::header(header_map h) { header_ = std::move(h); }
+void request_impl::header(header_map h) { fields_.assign(std::move(h)); }
 
-header_map &request_impl::header() { return header_; }
+header_fields &request_impl::fields() { return fields_; }
+
+const header_fields &request_impl::fields() const { return fields_; }
 
 void request_impl::method(std::string arg) { method_ = std::move(arg); }
 
@@ -49,11 +70,161 @@ void request_impl::on_data(data_cb cb) { on_data_cb_ = std::move(cb); }
 void request_impl::stream(class stream *s) { strm_ = s; }
 
 void request_impl::call_on_data(const uint8_t *data, std::size_t len) {
+  if (keep_body_) {
+    if (len == 0) {
+      eof_ = true;
+    } else if (discard_) {
+      // The rest of a body over the limit of read_all() is dropped,
+      // but the client still gets credit for it.
+      take(len);
+      return;
+    } else {
+      kept_.append(reinterpret_cast<const char *>(data), len);
+    }
+    complete_read();
+    return;
+  }
+
   if (on_data_cb_) {
     on_data_cb_(data, len);
   }
 }
 
+void request_impl::keep_body() {
+  if (keep_body_) {
+    return;
+  }
+
+  keep_body_ = true;
+  // The client gets credit for the body as it is read, so that no
+  // more than a stream window of it is kept.
+  pause();
+}
+
+void request_impl::read_some(read_cb cb) {
+  if (read_cb_) {
+    post_read(std::move(cb), boost::asio::error::already_started);
+    return;
+  }
+
+  keep_body();
+
+  read_cb_ = std::move(cb);
+  read_all_ = false;
+
+  complete_read();
+}
+
+void request_impl::read_all(std::size_t limit, read_cb cb) {
+  if (read_cb_) {
+    post_read(std::move(cb), boost::asio::error::already_started);
+    return;
+  }
+
+  keep_body();
+
+  read_cb_ = std::move(cb);
+  read_limit_ = limit;
+  read_all_ = true;
+
+  complete_read();
+}
+
+void request_impl::complete_read() {
+  if (!read_cb_) {
+    return;
+  }
+
+  if (read_all_ && kept_.size() > read_limit_) {
+    take(kept_.size() - std::exchange(kept_taken_, 0));
+    kept_.clear();
+    read_all_ = false;
+    discard_ = true;
+    post_read(std::exchange(read_cb_, nullptr),
+              boost::asio::error::message_size);
+    return;
+  }
+
+  if (!eof_ && read_all_) {
+    // The client gets credit for the body kept so far, so that a body
+    // larger than the stream window still arrives with manual flow
+    // control.  read_limit_ bounds what is kept.
+    take(kept_.size() - kept_taken_);
+    kept_taken_ = kept_.size();
+    return;
+  }
+
+  if (!eof_ && kept_.empty()) {
+    return;
+  }
+
+  take(kept_.size() - std::exchange(kept_taken_, 0));
+  read_all_ = false;
+  // An empty string marks the end of the body, as with data_cb.
+  post_read(std::exchange(read_cb_, nullptr), {}, std::exchange(kept_, {}));
+}
+
+void request_impl::post_read(read_cb cb, const boost::system::error_code &ec,
+                             std::string data) {
+  boost::asio::post(strm_->handler()->executor(),
+                    [cb = std::move(cb), ec, data = std::move(data),
+                     token = strm_->token()]() mutable {
+                      // The stream may be closed since.
+                      if (token.expired()) {
+                        cb(boost::asio::error::operation_aborted, "");
+                        return;
+                      }
+                      cb(ec, std::move(data));
+                    });
+}
+
+void request_impl::take(std::size_t n) {
+  taken_ += n;
+  // Bytes passed to call_on_data() are only added to unconsumed_
+  // after it returns.
+  auto m = std::min(taken_, unconsumed_);
+  taken_ -= m;
+  consume(m);
+}
+
+void request_impl::call_on_close(uint32_t error_code) {
+  if (read_cb_) {
+    post_read(std::exchange(read_cb_, nullptr),
+              boost::asio::error::operation_aborted);
+  }
+}
+
+void request_impl::pause() { paused_ = true; }
+
+void request_impl::resume() {
+  paused_ = false;
+  consume(unconsumed_);
+}
+
+void request_impl::consume(std::size_t n) {
+  n = std::min(n, unconsumed_);
+  if (n == 0) {
+    return;
+  }
+
+  unconsumed_ -= n;
+  strm_->handler()->consume(strm_->get_stream_id(), n);
+}
+
+void request_impl::received(std::size_t len) {
+  if (paused_) {
+    unconsumed_ += len;
+    if (taken_ > 0) {
+      take(0);
+    }
+    return;
+  }
+
+  strm_->handler()->consume(strm_->get_stream_id(), len);
+}
+
+std::size_t request_impl::unconsumed() const { return unconsumed_; }
+
 const boost::asio::ip::tcp::endpoint &request_impl::remote_endpoint() const {
   return remote_ep_;
 }
@@ -30,6 +30,8 @@
 #include <nghttp2/asio_http2_server.h>
 #include <boost/asio/ip/tcp.hpp>
 
+#include "asio_header_fields.h"
+
 namespace nghttp2 {
 namespace asio_http2 {
 namespace server {
@@ -42,7 +44,9 @@ public:
 
   void header(header_map h);
   const header_map &header() const;
-  header_map &header();
+
+  header_fields &fields();
+  const header_fields &fields() const;
 
   void method(std::string method);
   const std::string &method() const;
@@ -55,6 +59,27 @@ public:
   void stream(class stream *s);
   void call_on_data(const uint8_t *data, std::size_t len);
 
+  // Keeps the request body for read_some() and read_all() instead of
+  // passing it to the on_data callback.
+  void keep_body();
+  void read_some(read_cb cb);
+  void read_all(std::size_t limit, read_cb cb);
+
+  // Fails the pending read, as the stream is closed.
+  void call_on_close(uint32_t error_code);
+
+  void pause();
+  void resume();
+  void consume(std::size_t n);
+
+  // Gives credit for |len| bytes of request body passed to the
+  // on_data callback, or holds them back if paused, with manual flow
+  // control.
+  void received(std::size_t len);
+
+  // Returns the number of bytes held back.
+  std::size_t unconsumed() const;
+
   const boost::asio::ip::tcp::endpoint &remote_endpoint() const;
   void remote_endpoint(boost::asio::ip::tcp::endpoint ep);
 
@@ -62,13 +87,44 @@ public:
   void update_header_buffer_size(size_t len);
 
 private:
+  // Passes the kept body to the pending read, if it can complete.
+  void complete_read();
+  // Posts |cb| with |ec| and |data| to the executor of the stream.
+  // |cb| gets boost::asio::error::operation_aborted instead if the
+  // stream is closed by the time it runs.
+  void post_read(read_cb cb, const boost::system::error_code &ec,
+                 std::string data = "");
+  // Gives credit for |n| bytes of kept body passed to a read, with
+  // manual flow control.
+  void take(std::size_t n);
+
   class stream *strm_;
-  header_map header_;
+  header_fields fields_;
   std::string method_;
   uri_ref uri_;
   data_cb on_data_cb_;
   boost::asio::ip::tcp::endpoint remote_ep_;
   size_t header_buffer_size_;
+  // Bytes of request body held back while paused_.
+  std::size_t unconsumed_;
+  // Request body kept for the next read, with keep_body().
+  std::string kept_;
+  // Bytes at the front of kept_ already given credit for.
+  std::size_t kept_taken_;
+  read_cb read_cb_;
+  // Upper bound of the body passed to read_all().
+  std::size_t read_limit_;
+  // Bytes passed to reads which are not given credit for yet.
+  std::size_t taken_;
+  bool paused_;
+  bool keep_body_;
+  // true once read_all() failed with message_size; the rest of the
+  // body is not kept.
+  bool discard_;
+  // true once the end of the request body is received.
+  bool eof_;
+  // true if read_cb_ is waiting for the whole body.
+  bool read_all_;
 };
 
 } // namespace server
@@ -27,6 +27,7 @@
 #include <nghttp2/asio_http2_server.h>
 
 #include "asio_server_response_impl.h"
+#include "asio_server_stream.h"
 
 #include "template.h"
 
@@ -34,7 +35,7 @@ namespace nghttp2 {
 namespace asio_http2 {
 namespace server {
 
-response::response() : impl_(std::make_unique<response_impl>()) {}
+response::response(response_impl &impl) : impl_(&impl) {}
 
 response::~response() {}
 
@@ -46,6 +47,14 @@ void response::end(std::string data) const { impl_->end(std::move(data)); }
 
 void response::end(generator_cb cb) const { impl_->end(std::move(cb)); }
 
+void response::end(buffer_chain body) const { impl_->end(body.release()); }
+
+void response::end_file(int fd, int64_t offset, int64_t length) const {
+  impl_->end_file(fd, offset, length);
+}
+
+void response::end(const prebuilt_response &r) const { impl_->end(r.impl()); }
+
 void response::write_trailer(header_map h) const {
   impl_->write_trailer(std::move(h));
 }
@@ -62,6 +71,18 @@ const response *response::push(boost::system::error_code &ec,
 
 void response::resume() const { impl_->resume(); }
 
+void response::async_write(std::string data, write_cb cb) const {
+  impl_->write(std::make_unique<buffer_body>(std::move(data)), std::move(cb));
+}
+
+void response::async_write(buffer_chain data, write_cb cb) const {
+  impl_->write(data.release(), std::move(cb));
+}
+
+void response::async_finish(write_cb cb) const {
+  impl_->finish(std::move(cb));
+}
+
 unsigned int response::status_code() const { return impl_->status_code(); }
 
 boost::asio::strand<boost::asio::io_context::executor_type> &response::executor() const {
@@ -70,6 +91,17 @@ boost::asio::strand<boost::asio::io_context::executor_type> &response::executor(
 
 response_impl &response::impl() const { return *impl_; }
 
+std::function<void(std::exception_ptr)> response::on_exception() const {
+  return [impl = impl_,
+          token = impl_->stream()->token()](std::exception_ptr e) {
+    // The stream may be closed since.
+    if (!e || token.expired()) {
+      return;
+    }
+    impl->abandon();
+  };
+}
+
 } // namespace server
 } // namespace asio_http2
 } // namespace nghttp2
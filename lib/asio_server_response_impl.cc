@@ -24,9 +24,19 @@
  */
 #include "asio_server_response_impl.h"
 
+#include <sys/stat.h>
+#ifdef HAVE_UNISTD_H
+#  include <unistd.h>
+#endif // HAVE_UNISTD_H
+
+#include <utility>
+
+#include <boost/asio/post.hpp>
+
 #include "asio_server_stream.h"
 #include "asio_server_request_impl.h"
 #include "asio_server_http2_handler.h"
+#include "asio_server_prebuilt_response_impl.h"
 #include "asio_common.h"
 
 #include "http2.h"
@@ -38,10 +48,12 @@ namespace server {
 response_impl::response_impl()
     : strm_(nullptr),
       generator_cb_(deferred_generator()),
+      prebuilt_offset_(0),
       status_code_(200),
       state_(response_state::INITIAL),
       pushed_(false),
-      push_promise_sent_(false) {}
+      push_promise_sent_(false),
+      streaming_(false) {}
 
 unsigned int response_impl::status_code() const { return status_code_; }
 
@@ -63,7 +75,7 @@ void response_impl::write_head(unsigned int status_code, header_map h) {
 }
 
 void response_impl::end(std::string data) {
-  end(string_generator(std::move(data)));
+  end(std::make_unique<buffer_body>(std::move(data)));
 }
 
 void response_impl::end(generator_cb cb) {
@@ -73,6 +85,132 @@ void response_impl::end(generator_cb cb) {
 
   generator_cb_ = std::move(cb);
 
+  start_body();
+}
+
+void response_impl::end(std::unique_ptr<buffer_body> body) {
+  if (state_ == response_state::BODY_STARTED) {
+    return;
+  }
+
+  body_ = std::move(body);
+
+  start_body();
+}
+
+void response_impl::end_file(int fd, int64_t offset, int64_t length) {
+  if (state_ == response_state::BODY_STARTED) {
+    close(fd);
+    return;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+    // Pipes and the like have no size to frame the body with; read
+    // them until EOF.
+    if (offset > 0) {
+      lseek(fd, offset, SEEK_SET);
+    }
+    end(file_generator_from_fd(fd));
+    return;
+  }
+
+  if (length < 0) {
+    length = std::max<int64_t>(st.st_size - offset, 0);
+  }
+
+  auto body = std::make_unique<buffer_body>();
+  body->push_back_file(fd, offset, length, close_on_release(fd));
+
+  end(std::move(body));
+}
+
+void response_impl::end(
+    const std::shared_ptr<const prebuilt_response_impl> &r) {
+  if (state_ != response_state::INITIAL) {
+    return;
+  }
+
+  prebuilt_ = r;
+
+  write_head(r->status_code());
+
+  state_ = response_state::BODY_STARTED;
+}
+
+void response_impl::write(std::unique_ptr<buffer_body> data, write_cb cb) {
+  if (write_cb_ || finish_cb_) {
+    post_write(std::move(cb), boost::asio::error::already_started);
+    return;
+  }
+
+  if (state_ == response_state::BODY_STARTED && !streaming_ &&
+      expect_body()) {
+    post_write(std::move(cb), boost::asio::error::operation_not_supported);
+    return;
+  }
+
+  write_cb_ = std::move(cb);
+
+  if (!streaming_) {
+    streaming_ = true;
+    body_ = std::make_unique<buffer_body>();
+    body_->open(true);
+    body_->splice(*data);
+    start_body();
+  } else {
+    body_->splice(*data);
+    resume();
+  }
+
+  complete_write();
+}
+
+void response_impl::finish(write_cb cb) {
+  if (write_cb_ || finish_cb_) {
+    post_write(std::move(cb), boost::asio::error::already_started);
+    return;
+  }
+
+  finish_cb_ = std::move(cb);
+
+  if (streaming_) {
+    body_->open(false);
+    resume();
+    return;
+  }
+
+  if (state_ != response_state::BODY_STARTED) {
+    end(std::make_unique<buffer_body>());
+  }
+}
+
+bool response_impl::expect_body() const {
+  return ::nghttp2::http2::expect_response_body(
+      strm_->request().impl().method(), status_code_);
+}
+
+void response_impl::complete_write() {
+  if (!write_cb_ || (body_->left() > 0 && expect_body())) {
+    return;
+  }
+
+  post_write(std::exchange(write_cb_, nullptr), {});
+}
+
+void response_impl::post_write(write_cb cb, const boost::system::error_code &ec,
+                               bool closing) {
+  boost::asio::post(executor(), [cb = std::move(cb), ec, closing,
+                                 token = strm_->token()]() {
+    if (!closing && token.expired()) {
+      cb(boost::asio::error::operation_aborted);
+      return;
+    }
+    cb(ec);
+  });
+}
+
+void response_impl::start_body() {
   if (state_ == response_state::INITIAL) {
     write_head(status_code_);
   } else {
@@ -110,6 +248,19 @@ void response_impl::call_on_close(uint32_t error_code) {
   if (close_cb_) {
     close_cb_(error_code);
   }
+
+  if (write_cb_) {
+    post_write(std::exchange(write_cb_, nullptr),
+               boost::asio::error::operation_aborted);
+  }
+
+  if (finish_cb_) {
+    post_write(std::exchange(finish_cb_, nullptr),
+               error_code == NGHTTP2_NO_ERROR
+                   ? boost::system::error_code{}
+                   : boost::asio::error::operation_aborted,
+               true);
+  }
 }
 
 void response_impl::cancel(uint32_t error_code) {
@@ -117,6 +268,15 @@ void response_impl::cancel(uint32_t error_code) {
   handler->stream_error(strm_->get_stream_id(), error_code);
 }
 
+void response_impl::abandon() {
+  if (state_ == response_state::BODY_STARTED &&
+      !(streaming_ && body_->is_open())) {
+    return;
+  }
+
+  cancel(NGHTTP2_INTERNAL_ERROR);
+}
+
 response *response_impl::push(boost::system::error_code &ec, std::string method,
                               std::string raw_path_query, header_map h) const {
   auto handler = strm_->handler();
@@ -148,10 +308,32 @@ void response_impl::push_promise_sent() {
 
 const header_map &response_impl::header() const { return header_; }
 
+const prebuilt_response_impl *response_impl::prebuilt() const {
+  return prebuilt_.get();
+}
+
 void response_impl::stream(class stream *s) { strm_ = s; }
 
+class stream *response_impl::stream() const { return strm_; }
+
 generator_cb::result_type
 response_impl::call_read(uint8_t *data, std::size_t len, uint32_t *data_flags) {
+  if (prebuilt_) {
+    auto left = prebuilt_->body().size() - prebuilt_offset_;
+    auto n = std::min(len, left);
+    if (n == left) {
+      *data_flags |= NGHTTP2_DATA_FLAG_EOF;
+    }
+    if (n > 0) {
+      *data_flags |= NGHTTP2_DATA_FLAG_NO_COPY;
+    }
+    return n;
+  }
+
+  if (body_) {
+    return body_->read(len, data_flags);
+  }
+
   if (generator_cb_) {
     return generator_cb_(data, len, data_flags);
   }
@@ -161,6 +343,31 @@ response_impl::call_read(uint8_t *data, std::size_t len, uint32_t *data_flags) {
   return 0;
 }
 
+int response_impl::call_send(write_buffer &wb, nghttp2_frame *frame,
+                             const uint8_t *framehd, std::size_t length) {
+  if (prebuilt_) {
+    auto data =
+        reinterpret_cast<const uint8_t *>(prebuilt_->body().data());
+    auto rv = send_data_frame(wb, frame, framehd, data + prebuilt_offset_,
+                              length, prebuilt_);
+    if (rv == 0) {
+      prebuilt_offset_ += length;
+    }
+    return rv;
+  }
+
+  if (!body_) {
+    return NGHTTP2_ERR_CALLBACK_FAILURE;
+  }
+
+  auto rv = body_->send(wb, frame, framehd, length);
+  if (rv == 0) {
+    complete_write();
+  }
+
+  return rv;
+}
+
 } // namespace server
 } // namespace asio_http2
 } // namespace nghttp2
@@ -30,6 +30,8 @@
 #include <nghttp2/asio_http2_server.h>
 #include <boost/asio/strand.hpp>
 
+#include "asio_write_buffer.h"
+
 namespace nghttp2 {
 namespace asio_http2 {
 namespace server {
@@ -50,11 +52,24 @@ public:
   void write_head(unsigned int status_code, header_map h = header_map{});
   void end(std::string data = "");
   void end(generator_cb cb);
+  void end(std::unique_ptr<buffer_body> body);
+  void end_file(int fd, int64_t offset, int64_t length);
+  void end(const std::shared_ptr<const prebuilt_response_impl> &r);
   void write_trailer(header_map h);
   void on_close(close_cb cb);
   void resume();
 
+  // Appends |data| to the response body, which is left open for more,
+  // and passes to |cb| when nghttp2 took all of it.
+  void write(std::unique_ptr<buffer_body> data, write_cb cb);
+  // Ends the response body, and passes to |cb| when the stream is
+  // closed.
+  void finish(write_cb cb);
+
   void cancel(uint32_t error_code);
+  // Resets the stream with NGHTTP2_INTERNAL_ERROR, unless the whole
+  // response was given already.
+  void abandon();
 
   response *push(boost::system::error_code &ec, std::string method,
                  std::string raw_path_query, header_map) const;
@@ -65,18 +80,45 @@ public:
 
   unsigned int status_code() const;
   const header_map &header() const;
+  // Returns the response given to end(), or nullptr.
+  const prebuilt_response_impl *prebuilt() const;
   void pushed(bool f);
   void push_promise_sent();
   void stream(class stream *s);
+  class stream *stream() const;
   generator_cb::result_type call_read(uint8_t *data, std::size_t len,
                                       uint32_t *data_flags);
+  int call_send(write_buffer &wb, nghttp2_frame *frame,
+                const uint8_t *framehd, std::size_t length);
   void call_on_close(uint32_t error_code);
 
 private:
+  void start_body();
+  // Returns true if the response has a body, for the request method
+  // and status code.
+  bool expect_body() const;
+  // Completes the pending write once nghttp2 took all of its data.
+  void complete_write();
+  // Posts |cb| with |ec| to the executor of the stream.  Unless
+  // |closing|, |cb| gets boost::asio::error::operation_aborted
+  // instead of |ec| if the stream is closed by the time it runs.
+  void post_write(write_cb cb, const boost::system::error_code &ec,
+                  bool closing = false);
+
   class stream *strm_;
   header_map header_;
   generator_cb generator_cb_;
+  // Body sent without copying, used instead of generator_cb_ if set.
+  std::unique_ptr<buffer_body> body_;
+  // Response sent as a whole, used instead of header_ and the body if
+  // set.
+  std::shared_ptr<const prebuilt_response_impl> prebuilt_;
+  // Bytes of the body of prebuilt_ passed to call_send().
+  std::size_t prebuilt_offset_;
   close_cb close_cb_;
+  // Pending write() and finish().
+  write_cb write_cb_;
+  write_cb finish_cb_;
   unsigned int status_code_;
   response_state state_;
   // true if this is pushed stream's response
@@ -84,6 +126,9 @@ private:
   // true if PUSH_PROMISE is sent if this is response of a pushed
   // stream
   bool push_promise_sent_;
+  // true if body_ is written with write(), and still open unless
+  // finish() was called.
+  bool streaming_;
 };
 
 } // namespace server
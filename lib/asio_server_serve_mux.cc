@@ -24,6 +24,8 @@
  */
 #include "asio_server_serve_mux.h"
 
+#include <algorithm>
+
 #include "asio_server_request_impl.h"
 #include "asio_server_request_handler.h"
 #include "util.h"
@@ -35,22 +37,26 @@ namespace asio_http2 {
 
 namespace server {
 
+serve_mux::serve_mux() {}
+
+serve_mux::~serve_mux() {}
+
 bool serve_mux::handle(std::string pattern, request_cb cb) {
   if (pattern.empty() || !cb) {
     return false;
   }
 
-  auto it = mux_.find(pattern);
-  if (it != std::end(mux_) && (*it).second.user_defined) {
+  auto ent = find(pattern);
+  if (ent && ent->user_defined) {
     return false;
   }
 
   // if pattern ends with '/' (e.g., /foo/), add implicit permanent
   // redirect for '/foo'.
   if (pattern.size() >= 2 && pattern.back() == '/') {
-    auto redirect_pattern = pattern.substr(0, pattern.size() - 1);
-    auto it = mux_.find(redirect_pattern);
-    if (it == std::end(mux_) || !(*it).second.user_defined) {
+    auto redirect_pattern = std::string_view{pattern}.substr(0, pattern.size() - 1);
+    auto redirect_ent = find(redirect_pattern);
+    if (!redirect_ent || !redirect_ent->user_defined) {
       std::string path;
       if (pattern[0] == '/') {
         path = pattern;
@@ -58,77 +64,204 @@ bool serve_mux::handle(std::string pattern, request_cb cb) {
         // skip host part
         path = pattern.substr(pattern.find('/'));
       }
-      if (it == std::end(mux_)) {
-        mux_.emplace(std::move(redirect_pattern),
-                     handler_entry{false,
-                                   redirect_handler(301, std::move(path)),
-                                   pattern});
-      } else {
-        (*it).second = handler_entry{
-            false, redirect_handler(301, std::move(path)), pattern};
-      }
+      insert(redirect_pattern,
+             handler_entry{false, redirect_handler(301, std::move(path)),
+                           pattern});
     }
   }
-  mux_.emplace(pattern, handler_entry{true, std::move(cb), pattern});
+
+  // This replaces the implicit redirect of an earlier pattern, if any.
+  insert(pattern, handler_entry{true, std::move(cb), pattern});
 
   return true;
 }
 
-request_cb serve_mux::handler(request_impl &req) const {
-  auto &path = req.uri().path;
-  if (req.method() != "CONNECT") {
-    auto clean_path = ::nghttp2::http2::path_join(StringRef{}, StringRef{},
-                                                  StringRef{path}, StringRef{});
-    if (clean_path != path) {
-      auto new_uri = util::percent_encode_path(clean_path);
-      auto &uref = req.uri();
-      if (!uref.raw_query.empty()) {
-        new_uri += '?';
-        new_uri += uref.raw_query;
-      }
+namespace {
+// Returns true if path_join() leaves |path| as it is: it starts with
+// '/', and has neither empty, . nor .. segments.
+bool is_clean_path(std::string_view path) {
+  if (path.empty() || path[0] != '/') {
+    return false;
+  }
 
-      return redirect_handler(301, std::move(new_uri));
+  for (std::size_t i = 1; i <= path.size();) {
+    auto slash = std::min(path.find('/', i), path.size());
+    auto segment = path.substr(i, slash - i);
+    // An empty segment is only allowed at the end, after the last '/'.
+    if ((segment.empty() && slash != path.size()) || segment == "." ||
+        segment == "..") {
+      return false;
     }
+    i = slash + 1;
   }
-  auto &host = req.uri().host;
 
-  auto cb = match(host + path);
-  if (cb) {
-    return cb;
+  return true;
+}
+} // namespace
+
+std::optional<std::string> serve_mux::redirect(const request_impl &req) const {
+  if (req.method() == "CONNECT") {
+    return std::nullopt;
   }
-  cb = match(path);
-  if (cb) {
-    return cb;
+
+  auto &path = req.uri().path;
+  if (is_clean_path(path)) {
+    return std::nullopt;
+  }
+
+  auto clean_path = ::nghttp2::http2::path_join(StringRef{}, StringRef{},
+                                                StringRef{path}, StringRef{});
+  if (clean_path == path) {
+    return std::nullopt;
+  }
+
+  auto new_uri = util::percent_encode_path(clean_path);
+  auto &uref = req.uri();
+  if (!uref.raw_query.empty()) {
+    new_uri += '?';
+    new_uri += uref.raw_query;
   }
-  return status_handler(404);
+
+  return new_uri;
 }
 
-namespace {
-bool path_match(const std::string &pattern, const std::string &path) {
-  if (pattern.back() != '/') {
-    return pattern == path;
+const request_cb &serve_mux::handler(const request_impl &req) const {
+  auto &uref = req.uri();
+
+  if (auto ent = match(uref.host, uref.path)) {
+    return ent->cb;
+  }
+  if (!uref.host.empty()) {
+    if (auto ent = match({}, uref.path)) {
+      return ent->cb;
+    }
   }
-  return util::starts_with(path, pattern);
+  static const auto not_found = status_handler(404);
+  return not_found;
 }
+
+namespace {
+// The string a pattern is matched against: |host| followed by |path|,
+// without concatenating them.
+struct route_key {
+  std::size_t size() const { return host.size() + path.size(); }
+
+  char operator[](std::size_t i) const {
+    return i < host.size() ? host[i] : path[i - host.size()];
+  }
+
+  // Returns true if |s| is at |pos| of the key.
+  bool has_at(std::size_t pos, std::string_view s) const {
+    if (s.size() > size() - pos) {
+      return false;
+    }
+    if (pos < host.size()) {
+      auto n = std::min(s.size(), host.size() - pos);
+      if (host.substr(pos, n) != s.substr(0, n)) {
+        return false;
+      }
+      s.remove_prefix(n);
+      pos = host.size();
+    }
+    return path.substr(pos - host.size(), s.size()) == s;
+  }
+
+  std::string_view host;
+  std::string_view path;
+};
 } // namespace
 
-request_cb serve_mux::match(const std::string &path) const {
+const handler_entry *serve_mux::match(std::string_view host,
+                                      std::string_view path) const {
+  auto key = route_key{host, path};
   const handler_entry *ent = nullptr;
-  size_t best = 0;
-  for (auto &kv : mux_) {
-    auto &pattern = kv.first;
-    if (!path_match(pattern, path)) {
-      continue;
+  const node *n = &root_;
+
+  // Patterns get longer down the tree, so that the last one matching
+  // is the longest.
+  for (std::size_t pos = 0;;) {
+    // The pattern of n is the first pos bytes of the key.  If it ends
+    // with '/', it matches the paths below it too.
+    if (n->entry && (pos == key.size() || key[pos - 1] == '/')) {
+      ent = n->entry.get();
     }
-    if (!ent || best < pattern.size()) {
-      best = pattern.size();
-      ent = &kv.second;
+
+    if (pos == key.size()) {
+      return ent;
     }
+
+    auto i = n->index.find(key[pos]);
+    if (i == std::string::npos) {
+      return ent;
+    }
+
+    auto child = n->children[i].get();
+    if (!key.has_at(pos, child->label)) {
+      return ent;
+    }
+
+    pos += child->label.size();
+    n = child;
   }
-  if (ent) {
-    return ent->cb;
+}
+
+handler_entry *serve_mux::find(std::string_view pattern) {
+  auto n = &root_;
+  while (!pattern.empty()) {
+    auto i = n->index.find(pattern[0]);
+    if (i == std::string::npos) {
+      return nullptr;
+    }
+
+    n = n->children[i].get();
+    if (!pattern.starts_with(n->label)) {
+      return nullptr;
+    }
+
+    pattern.remove_prefix(n->label.size());
   }
-  return request_cb();
+
+  return n->entry.get();
+}
+
+void serve_mux::insert(std::string_view pattern, handler_entry e) {
+  auto n = &root_;
+  while (!pattern.empty()) {
+    auto i = n->index.find(pattern[0]);
+    if (i == std::string::npos) {
+      auto child = std::make_unique<node>();
+      child->label = pattern;
+      n->index += pattern[0];
+      n->children.push_back(std::move(child));
+      n = n->children.back().get();
+      break;
+    }
+
+    auto child = n->children[i].get();
+    auto &label = child->label;
+    auto m = static_cast<std::size_t>(
+        std::mismatch(std::begin(label), std::end(label), std::begin(pattern),
+                      std::end(pattern))
+            .first -
+        std::begin(label));
+
+    if (m < label.size()) {
+      // Splits the edge at the end of the common part, moving the
+      // child below a new node.
+      auto mid = std::make_unique<node>();
+      mid->label = label.substr(0, m);
+      label.erase(0, m);
+      mid->index += label[0];
+      mid->children.push_back(std::move(n->children[i]));
+      n->children[i] = std::move(mid);
+      child = n->children[i].get();
+    }
+
+    pattern.remove_prefix(m);
+    n = child;
+  }
+
+  n->entry = std::make_unique<handler_entry>(std::move(e));
 }
 
 } // namespace server
@@ -27,6 +27,12 @@
 
 #include "nghttp2_config.h"
 
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
 #include <nghttp2/asio_http2_server.h>
 
 namespace nghttp2 {
@@ -45,14 +51,51 @@ struct handler_entry {
   std::string pattern;
 };
 
+// The patterns are kept in a radix tree, with the edges labelled by
+// the longest strings the patterns below have in common.  A request
+// is matched by walking down the tree along its host followed by its
+// path, so that the cost of a lookup depends on the length of the
+// path rather than on the number of patterns, and it does not
+// allocate.
 class serve_mux {
 public:
+  serve_mux();
+  ~serve_mux();
+
   bool handle(std::string pattern, request_cb cb);
-  request_cb handler(request_impl &req) const;
-  request_cb match(const std::string &path) const;
+
+  // Returns the URI to redirect |req| to, if its path is not clean
+  // (e.g., it contains . or .. segments).
+  std::optional<std::string> redirect(const request_impl &req) const;
+
+  // Returns the handler of |req|, whose path must be clean.  This is
+  // the handler of the longest pattern matching its host followed by
+  // its path, or else its path alone, or a handler responding 404.
+  const request_cb &handler(const request_impl &req) const;
+
+  // Returns the entry of the longest pattern matching |host| followed
+  // by |path|, or nullptr.
+  const handler_entry *match(std::string_view host,
+                             std::string_view path) const;
 
 private:
-  std::map<std::string, handler_entry> mux_;
+  struct node {
+    // Bytes of the patterns between the parent and this node.
+    std::string label;
+    // First byte of the label of each child, in the order of
+    // children.
+    std::string index;
+    std::vector<std::unique_ptr<node>> children;
+    // Set if a pattern ends at this node.
+    std::unique_ptr<handler_entry> entry;
+  };
+
+  // Returns the entry of |pattern|, or nullptr.
+  handler_entry *find(std::string_view pattern);
+  // Sets |e| as the entry of |pattern|, replacing the existing one.
+  void insert(std::string_view pattern, handler_entry e);
+
+  node root_;
 };
 
 } // namespace server
@@ -25,17 +25,18 @@
 #include "asio_server_stream.h"
 
 #include "asio_server_http2_handler.h"
-#include "asio_server_request_impl.h"
-#include "asio_server_response_impl.h"
 
 namespace nghttp2 {
 namespace asio_http2 {
 namespace server {
 
 stream::stream(http2_handler *h, int32_t stream_id)
-    : handler_(h), stream_id_(stream_id) {
-  request_.impl().stream(this);
-  response_.impl().stream(this);
+    : handler_(h),
+      request_(request_impl_),
+      response_(response_impl_),
+      stream_id_(stream_id) {
+  request_impl_.stream(this);
+  response_impl_.stream(this);
 }
 
 int32_t stream::get_stream_id() const { return stream_id_; }
@@ -50,6 +51,13 @@ class response &stream::response() {
 
 http2_handler *stream::handler() const { return handler_; }
 
+std::weak_ptr<const void> stream::token() {
+  if (!token_) {
+    token_ = std::make_shared<int>(0);
+  }
+  return token_;
+}
+
 } // namespace server
 } // namespace asio_http2
 } // namespace nghttp2
@@ -29,24 +29,42 @@
 
 #include <nghttp2/asio_http2_server.h>
 
+#include <memory>
+
+#include "asio_server_request_impl.h"
+#include "asio_server_response_impl.h"
+
 namespace nghttp2 {
 namespace asio_http2 {
 namespace server {
 
 class http2_handler;
 
+// A stream, with its request and response in the same allocation.
 class stream {
 public:
   stream(http2_handler *h, int32_t stream_id);
 
+  stream(const stream &) = delete;
+  stream &operator=(const stream &) = delete;
+
   int32_t get_stream_id() const;
   class request &request();
   class response &response();
 
   http2_handler *handler() const;
 
+  // Returns a token which expires when this stream is destroyed, for
+  // the completions posted to its executor to tell whether the stream
+  // is still there when they run.
+  std::weak_ptr<const void> token();
+
 private:
   http2_handler *handler_;
+  // Created on first use.
+  std::shared_ptr<const void> token_;
+  request_impl request_impl_;
+  response_impl response_impl_;
   class request request_;
   class response response_;
   int32_t stream_id_;
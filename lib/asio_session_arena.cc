@@ -0,0 +1,155 @@
+/*
+ * nghttp2 - HTTP/2 C Library
+ *
+ * Copyright (c) 2015 Tatsuhiro Tsujikawa
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "asio_session_arena.h"
+
+#include <bit>
+#include <cstdlib>
+#include <cstring>
+
+namespace nghttp2 {
+
+namespace asio_http2 {
+
+namespace {
+// Chunks handed out are 16 byte aligned, like malloc's, with their
+// length stored in the 8 bytes before them.  BlockAllocator puts its
+// own length field right before the memory it returns, which is 8
+// bytes off a 16 byte boundary, so chunks start one field further.
+constexpr size_t header_size = sizeof(size_t);
+constexpr size_t large_header_size = 16;
+} // namespace
+
+session_arena::session_arena()
+    : balloc_(8_k, 8_k),
+      free_{},
+      mem_{this,
+           [](size_t size, void *user_data) {
+             return static_cast<session_arena *>(user_data)->malloc(size);
+           },
+           [](void *ptr, void *user_data) {
+             static_cast<session_arena *>(user_data)->free(ptr);
+           },
+           [](size_t nmemb, size_t size, void *user_data) {
+             return static_cast<session_arena *>(user_data)->calloc(nmemb,
+                                                                    size);
+           },
+           [](void *ptr, size_t size, void *user_data) {
+             return static_cast<session_arena *>(user_data)->realloc(ptr,
+                                                                     size);
+           }} {}
+
+session_arena::~session_arena() { reset(); }
+
+nghttp2_mem *session_arena::mem() { return &mem_; }
+
+void session_arena::reset() {
+  // Large chunks were all given back by the session.
+  balloc_.reset();
+  free_.fill(nullptr);
+}
+
+size_t session_arena::size_class(size_t size) {
+  if (size <= (size_t{1} << min_class_bits)) {
+    return 0;
+  }
+  return std::bit_width(size - 1) - min_class_bits;
+}
+
+size_t &session_arena::length(void *ptr) {
+  return *reinterpret_cast<size_t *>(static_cast<uint8_t *>(ptr) -
+                                     header_size);
+}
+
+void *session_arena::malloc(size_t size) {
+  if (size > max_class) {
+    auto p = static_cast<uint8_t *>(std::malloc(size + large_header_size));
+    if (!p) {
+      return nullptr;
+    }
+    auto ptr = p + large_header_size;
+    length(ptr) = size;
+    return ptr;
+  }
+
+  auto c = size_class(size);
+  if (auto ptr = free_[c]) {
+    free_[c] = *static_cast<void **>(ptr);
+    return ptr;
+  }
+
+  auto len = size_t{1} << (c + min_class_bits);
+  auto ptr = static_cast<uint8_t *>(balloc_.alloc(len + header_size)) +
+             header_size;
+  length(ptr) = len;
+  return ptr;
+}
+
+void session_arena::free(void *ptr) {
+  if (!ptr) {
+    return;
+  }
+
+  auto len = length(ptr);
+  if (len > max_class) {
+    std::free(static_cast<uint8_t *>(ptr) - large_header_size);
+    return;
+  }
+
+  auto c = size_class(len);
+  *static_cast<void **>(ptr) = free_[c];
+  free_[c] = ptr;
+}
+
+void *session_arena::calloc(size_t nmemb, size_t size) {
+  auto ptr = malloc(nmemb * size);
+  if (ptr) {
+    std::memset(ptr, 0, nmemb * size);
+  }
+  return ptr;
+}
+
+void *session_arena::realloc(void *ptr, size_t size) {
+  if (!ptr) {
+    return malloc(size);
+  }
+
+  auto len = length(ptr);
+  if (size <= len && (len <= max_class || size > max_class)) {
+    return ptr;
+  }
+
+  auto res = malloc(size);
+  if (!res) {
+    return nullptr;
+  }
+  std::memcpy(res, ptr, std::min(len, size));
+  free(ptr);
+
+  return res;
+}
+
+} // namespace asio_http2
+
+} // namespace nghttp2
@@ -0,0 +1,92 @@
+/*
+ * nghttp2 - HTTP/2 C Library
+ *
+ * Copyright (c) 2015 Tatsuhiro Tsujikawa
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef ASIO_SESSION_ARENA_H
+#define ASIO_SESSION_ARENA_H
+
+#include "nghttp2_config.h"
+
+#include <array>
+#include <cstddef>
+
+#include <boost/noncopyable.hpp>
+
+#include <nghttp2/nghttp2.h>
+
+#include "allocator.h"
+#include "template.h"
+
+namespace nghttp2 {
+
+namespace asio_http2 {
+
+/// Memory of one nghttp2 session, so that the sessions of different
+/// threads do not contend on the process wide allocator.  Requests up
+/// to max_class bytes are rounded up to a power of two and cut from
+/// the blocks of a BlockAllocator; freed chunks go to a free list per
+/// size, from which later requests of that size are served.  Larger
+/// requests, which nghttp2 makes for its frame buffers, go to malloc.
+/// reset() frees everything at once.  Not thread safe; only the
+/// session may use it.
+class session_arena : private boost::noncopyable {
+public:
+  session_arena();
+  ~session_arena();
+
+  /// Returns the allocator to pass to nghttp2_session_*_new3().
+  nghttp2_mem *mem();
+
+  /// Frees all the memory.  The session must have been deleted.
+  void reset();
+
+  void *malloc(size_t size);
+  void free(void *ptr);
+  void *calloc(size_t nmemb, size_t size);
+  void *realloc(void *ptr, size_t size);
+
+private:
+  static constexpr size_t min_class_bits = 4;
+  static constexpr size_t classes = 9;
+  static constexpr size_t max_class = size_t{1} << (min_class_bits + classes - 1);
+
+  /// Returns the index of the smallest size class holding |size|
+  /// bytes.
+  static size_t size_class(size_t size);
+
+  /// Returns the usable size of |ptr|, which is a power of two up to
+  /// max_class for chunks from balloc_.
+  static size_t &length(void *ptr);
+
+  BlockAllocator balloc_;
+  /// Free chunks of each size class, linked through their first
+  /// bytes.
+  std::array<void *, classes> free_;
+  nghttp2_mem mem_;
+};
+
+} // namespace asio_http2
+
+} // namespace nghttp2
+
+#endif // ASIO_SESSION_ARENA_H
@@ -0,0 +1,110 @@
+/*
+ * nghttp2 - HTTP/2 C Library
+ *
+ * Copyright (c) 2015 Tatsuhiro Tsujikawa
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef ASIO_SLAB_H
+#define ASIO_SLAB_H
+
+#include "nghttp2_config.h"
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+
+namespace nghttp2 {
+
+namespace asio_http2 {
+
+/// Storage for objects of type T, allocated objects_per_chunk at a
+/// time and reused through a free list, so that creating an object
+/// usually costs no allocation at all.  Memory goes back to the
+/// system only when the slab is destroyed, which must not happen
+/// before all its objects are destroyed.  Not thread safe.
+template <typename T, std::size_t objects_per_chunk = 16>
+class slab : private boost::noncopyable {
+public:
+  /// Destroys objects of the slab, for use with std::unique_ptr.
+  struct deleter {
+    slab *owner;
+    void operator()(T *p) const { owner->destroy(p); }
+  };
+  using pointer = std::unique_ptr<T, deleter>;
+
+  slab() : free_(nullptr) {}
+
+  /// Constructs an object from |args|.
+  template <typename... Args> T *create(Args &&...args) {
+    if (!free_) {
+      grow();
+    }
+
+    // If the constructor throws, the slot stays on the free list.
+    auto s = free_;
+    auto next = s->next;
+    auto p = new (s->storage) T(std::forward<Args>(args)...);
+    free_ = next;
+    return p;
+  }
+
+  /// Same as create(), but returns an owning pointer.
+  template <typename... Args> pointer make(Args &&...args) {
+    return pointer(create(std::forward<Args>(args)...), deleter{this});
+  }
+
+  /// Destroys |p|, which was returned by create() or make(), and keeps
+  /// its memory for the next object.
+  void destroy(T *p) {
+    p->~T();
+    auto s = reinterpret_cast<slot *>(reinterpret_cast<std::byte *>(p));
+    s->next = free_;
+    free_ = s;
+  }
+
+private:
+  union slot {
+    slot *next;
+    alignas(T) std::byte storage[sizeof(T)];
+  };
+
+  void grow() {
+    auto chunk = std::make_unique_for_overwrite<slot[]>(objects_per_chunk);
+    for (std::size_t i = 0; i < objects_per_chunk; ++i) {
+      chunk[i].next = free_;
+      free_ = &chunk[i];
+    }
+    chunks_.push_back(std::move(chunk));
+  }
+
+  std::vector<std::unique_ptr<slot[]>> chunks_;
+  slot *free_;
+};
+
+} // namespace asio_http2
+
+} // namespace nghttp2
+
+#endif // ASIO_SLAB_H
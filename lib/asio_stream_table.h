@@ -0,0 +1,180 @@
+/*
+ * nghttp2 - HTTP/2 C Library
+ *
+ * Copyright (c) 2015 Tatsuhiro Tsujikawa
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef ASIO_STREAM_TABLE_H
+#define ASIO_STREAM_TABLE_H
+
+#include "nghttp2_config.h"
+
+#include <bit>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+namespace nghttp2 {
+
+namespace asio_http2 {
+
+/// Hash table from stream id to T *, with open addressing and linear
+/// probing in a single array.  Stream ids are positive, so 0 marks an
+/// empty slot.  Erasing shifts the following entries back instead of
+/// leaving tombstones, so that lookups never slow down as streams come
+/// and go.  The table doubles once it is half full.
+template <typename T> class stream_table {
+public:
+  stream_table()
+      : slots_(initial_capacity),
+        size_(0),
+        shift_(32 - std::countr_zero(initial_capacity)) {}
+
+  /// Returns the value of |stream_id|, or nullptr.
+  T *find(int32_t stream_id) const {
+    for (auto i = index(stream_id);; i = next(i)) {
+      auto &e = slots_[i];
+      if (e.stream_id == stream_id) {
+        return e.value;
+      }
+      if (e.stream_id == 0) {
+        return nullptr;
+      }
+    }
+  }
+
+  /// Adds |value| for |stream_id|, which must not be in the table.
+  void insert(int32_t stream_id, T *value) {
+    assert(stream_id > 0);
+    assert(!find(stream_id));
+
+    if ((size_ + 1) * 2 > slots_.size()) {
+      grow();
+    }
+
+    place(stream_id, value);
+    ++size_;
+  }
+
+  /// Removes |stream_id| and returns its value, or nullptr if it is
+  /// not in the table.
+  T *erase(int32_t stream_id) {
+    auto i = index(stream_id);
+    for (; slots_[i].stream_id != stream_id; i = next(i)) {
+      if (slots_[i].stream_id == 0) {
+        return nullptr;
+      }
+    }
+
+    auto value = slots_[i].value;
+    slots_[i] = entry{};
+    --size_;
+
+    // Moves back the entries of the run after i which would not be
+    // found anymore.
+    for (auto j = next(i); slots_[j].stream_id != 0; j = next(j)) {
+      auto k = index(slots_[j].stream_id);
+      // Stays if its home slot k is cyclically in (i, j].
+      if (i <= j ? (i < k && k <= j) : (i < k || k <= j)) {
+        continue;
+      }
+      slots_[i] = slots_[j];
+      slots_[j] = entry{};
+      i = j;
+    }
+
+    return value;
+  }
+
+  std::size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  /// Calls |f| with each value in the table.  |f| must not insert or
+  /// erase.
+  template <typename F> void for_each(F f) const {
+    for (auto &e : slots_) {
+      if (e.stream_id != 0) {
+        f(e.value);
+      }
+    }
+  }
+
+  /// Empties the table, then calls |f| with each value that was in it.
+  /// |f| may use the table.
+  template <typename F> void clear(F f) {
+    auto slots = std::vector<entry>(initial_capacity);
+    slots.swap(slots_);
+    size_ = 0;
+    shift_ = 32 - std::countr_zero(initial_capacity);
+
+    for (auto &e : slots) {
+      if (e.stream_id != 0) {
+        f(e.value);
+      }
+    }
+  }
+
+private:
+  static constexpr std::size_t initial_capacity = 16;
+
+  struct entry {
+    int32_t stream_id = 0;
+    T *value = nullptr;
+  };
+
+  /// Fibonacci hashing; consecutive stream ids land far apart.
+  std::size_t index(int32_t stream_id) const {
+    return (static_cast<uint32_t>(stream_id) * 2654435769u) >> shift_;
+  }
+
+  std::size_t next(std::size_t i) const { return (i + 1) & (slots_.size() - 1); }
+
+  void place(int32_t stream_id, T *value) {
+    auto i = index(stream_id);
+    while (slots_[i].stream_id != 0) {
+      i = next(i);
+    }
+    slots_[i] = entry{stream_id, value};
+  }
+
+  void grow() {
+    auto slots = std::vector<entry>(slots_.size() * 2);
+    slots.swap(slots_);
+    --shift_;
+
+    for (auto &e : slots) {
+      if (e.stream_id != 0) {
+        place(e.stream_id, e.value);
+      }
+    }
+  }
+
+  std::vector<entry> slots_;
+  std::size_t size_;
+  /// 32 minus log2 of the capacity.
+  int shift_;
+};
+
+} // namespace asio_http2
+
+} // namespace nghttp2
+
+#endif // ASIO_STREAM_TABLE_H
@@ -0,0 +1,271 @@
+/*
+ * nghttp2 - HTTP/2 C Library
+ *
+ * Copyright (c) 2015 Tatsuhiro Tsujikawa
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "asio_timer_wheel.h"
+
+#include <time.h>
+
+namespace nghttp2 {
+
+namespace asio_http2 {
+
+namespace {
+// Reads CLOCK_MONOTONIC_COARSE, which costs a fraction of a precise
+// clock read, where available.
+std::chrono::nanoseconds coarse_now() {
+#ifdef CLOCK_MONOTONIC_COARSE
+  timespec ts;
+  if (clock_gettime(CLOCK_MONOTONIC_COARSE, &ts) == 0) {
+    return std::chrono::seconds{ts.tv_sec} +
+           std::chrono::nanoseconds{ts.tv_nsec};
+  }
+#endif // CLOCK_MONOTONIC_COARSE
+  return std::chrono::steady_clock::now().time_since_epoch();
+}
+} // namespace
+
+boost::asio::io_context::id timer_wheel::id;
+
+timer_wheel::timer::timer(boost::asio::io_context &ioc)
+    : wheel_(boost::asio::use_service<timer_wheel>(ioc)),
+      prev_(nullptr),
+      next_(nullptr),
+      deadline_(0),
+      scheduled_(0),
+      level_(0),
+      slot_(0),
+      linked_(false) {}
+
+timer_wheel::timer::~timer() { cancel(); }
+
+void timer_wheel::timer::expires_after(std::chrono::microseconds timeout) {
+  // Round up, and add a tick since the current one is partly over.
+  auto ticks = (timeout + resolution - std::chrono::microseconds{1}) /
+               resolution;
+  auto deadline = wheel_.clock() + ticks + 1;
+  deadline_.store(deadline, std::memory_order_relaxed);
+
+  // The wheel would only find out at the old deadline.
+  if (deadline < scheduled_.load(std::memory_order_relaxed)) {
+    std::lock_guard<std::mutex> lock(wheel_.mutex_);
+    if (linked_) {
+      wheel_.unlink(*this);
+      wheel_.link(*this);
+    }
+  }
+}
+
+bool timer_wheel::timer::expired() const {
+  return deadline_.load(std::memory_order_relaxed) <= wheel_.clock();
+}
+
+void timer_wheel::timer::async_wait(std::function<void()> cb) {
+  std::lock_guard<std::mutex> lock(wheel_.mutex_);
+  cb_ = std::move(cb);
+  if (!linked_) {
+    wheel_.add(*this);
+  }
+}
+
+void timer_wheel::timer::cancel() {
+  std::lock_guard<std::mutex> lock(wheel_.mutex_);
+  if (linked_) {
+    wheel_.remove(*this);
+  }
+}
+
+timer_wheel::timer_wheel(boost::asio::io_context &ioc)
+    : boost::asio::io_context::service(ioc),
+      wheel_{},
+      ticker_(ioc),
+      epoch_(coarse_now()),
+      now_(0),
+      size_(0),
+      generation_(0),
+      ticking_(false),
+      shutdown_(false) {}
+
+void timer_wheel::shutdown() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  shutdown_ = true;
+  ticking_ = false;
+  ticker_.cancel();
+}
+
+uint64_t timer_wheel::clock() const {
+  return (coarse_now() - epoch_) / resolution;
+}
+
+void timer_wheel::add(timer &t) {
+  if (!ticking_) {
+    // Nothing is in the wheel, so it can jump to the present.
+    now_ = clock();
+  }
+
+  link(t);
+  ++size_;
+
+  if (!ticking_ && !shutdown_) {
+    start_ticking();
+  }
+}
+
+void timer_wheel::remove(timer &t) {
+  unlink(t);
+  if (--size_ == 0 && ticking_) {
+    // Let the io_context run out of work.
+    ticking_ = false;
+    ticker_.cancel();
+  }
+}
+
+void timer_wheel::link(timer &t) {
+  auto deadline = std::max(t.deadline_.load(std::memory_order_relaxed),
+                           now_ + 1);
+
+  // The lowest level whose slots, counted from the current one, reach
+  // the deadline.  Deadlines beyond the last level wait in its
+  // farthest slot, and are put back once it comes due.
+  std::size_t level = 0;
+  for (; level < levels; ++level) {
+    auto shift = level * slot_bits;
+    if ((deadline >> shift) - (now_ >> shift) < slots) {
+      break;
+    }
+  }
+  if (level == levels) {
+    level = levels - 1;
+    deadline = ((now_ >> (level * slot_bits)) + slots - 1)
+               << (level * slot_bits);
+  }
+
+  t.scheduled_.store(deadline, std::memory_order_relaxed);
+
+  auto slot = (deadline >> (level * slot_bits)) & (slots - 1);
+  auto &head = wheel_[level][slot];
+
+  t.level_ = level;
+  t.slot_ = slot;
+  t.prev_ = nullptr;
+  t.next_ = head;
+  if (head) {
+    head->prev_ = &t;
+  }
+  head = &t;
+  t.linked_ = true;
+}
+
+void timer_wheel::unlink(timer &t) {
+  if (t.prev_) {
+    t.prev_->next_ = t.next_;
+  } else {
+    wheel_[t.level_][t.slot_] = t.next_;
+  }
+  if (t.next_) {
+    t.next_->prev_ = t.prev_;
+  }
+  t.prev_ = t.next_ = nullptr;
+  t.linked_ = false;
+}
+
+void timer_wheel::start_ticking() {
+  ticking_ = true;
+  ticker_.expires_after(resolution);
+  ticker_.async_wait(
+      [this, generation = ++generation_](const boost::system::error_code &ec) {
+        if (ec) {
+          return;
+        }
+        tick(generation);
+      });
+}
+
+void timer_wheel::tick(uint64_t generation) {
+  std::vector<std::function<void()>> expired;
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (generation != generation_ || !ticking_) {
+      return;
+    }
+
+    advance(clock(), expired);
+
+    ticking_ = false;
+    if (size_ != 0 && !shutdown_) {
+      start_ticking();
+    }
+  }
+
+  for (auto &cb : expired) {
+    cb();
+  }
+}
+
+void timer_wheel::advance(uint64_t now,
+                          std::vector<std::function<void()>> &expired) {
+  while (now_ < now) {
+    ++now_;
+
+    // Once the slots of a level went round, the next slot of the level
+    // above comes due; its timers move down to lower levels.
+    std::size_t level = 1;
+    while (level < levels &&
+           (now_ & ((uint64_t{1} << (level * slot_bits)) - 1)) == 0) {
+      ++level;
+    }
+    while (--level > 0) {
+      reschedule(level, (now_ >> (level * slot_bits)) & (slots - 1),
+                 expired);
+    }
+
+    reschedule(0, now_ & (slots - 1), expired);
+  }
+}
+
+void timer_wheel::reschedule(std::size_t level, std::size_t slot,
+                             std::vector<std::function<void()>> &expired) {
+  auto t = wheel_[level][slot];
+  wheel_[level][slot] = nullptr;
+
+  while (t) {
+    auto next = t->next_;
+    t->prev_ = t->next_ = nullptr;
+    t->linked_ = false;
+
+    if (t->deadline_.load(std::memory_order_relaxed) <= now_) {
+      --size_;
+      expired.push_back(t->cb_);
+    } else {
+      link(*t);
+    }
+
+    t = next;
+  }
+}
+
+} // namespace asio_http2
+
+} // namespace nghttp2
@@ -0,0 +1,151 @@
+/*
+ * nghttp2 - HTTP/2 C Library
+ *
+ * Copyright (c) 2015 Tatsuhiro Tsujikawa
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef ASIO_TIMER_WHEEL_H
+#define ASIO_TIMER_WHEEL_H
+
+#include "nghttp2_config.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/noncopyable.hpp>
+
+namespace nghttp2 {
+
+namespace asio_http2 {
+
+/// Hierarchical timer wheel driving the connection deadlines of an
+/// io_context, obtained with boost::asio::use_service.  Deadlines are
+/// counted in ticks of a coarse monotonic clock, so that moving a
+/// deadline, which happens on every read and write, only stores a
+/// number into the timer.  A timer found in a due slot whose deadline
+/// has moved is put back into the wheel, instead of rescheduling it
+/// each time it is moved.  The wheel only ticks while it holds timers,
+/// so that an io_context without other work still runs out of it.
+class timer_wheel : public boost::asio::io_context::service {
+public:
+  static boost::asio::io_context::id id;
+
+  /// Length of a tick.  Timers expire at most two ticks late, never
+  /// early.
+  static constexpr std::chrono::milliseconds resolution{100};
+
+  /// A deadline of some connection.  It must only be used from the
+  /// connection's strand.
+  class timer : private boost::noncopyable {
+  public:
+    explicit timer(boost::asio::io_context &ioc);
+    ~timer();
+
+    /// Moves the deadline to |timeout| from now.  Only a deadline
+    /// earlier than the one the timer was put into the wheel with
+    /// takes the wheel's lock.
+    void expires_after(std::chrono::microseconds timeout);
+
+    /// Returns true if the deadline has passed.
+    bool expired() const;
+
+    /// Puts the timer into the wheel, which calls |cb| once the
+    /// deadline has passed.  |cb| runs on the io_context, but not
+    /// necessarily on the strand of the timer's owner; as an expired()
+    /// timer may have been moved in the meantime, it should check
+    /// expired() on the strand and call async_wait again if it is
+    /// false.
+    void async_wait(std::function<void()> cb);
+
+    /// Removes the timer from the wheel.
+    void cancel();
+
+  private:
+    friend class timer_wheel;
+
+    timer_wheel &wheel_;
+    std::function<void()> cb_;
+    timer *prev_;
+    timer *next_;
+    /// Deadline in ticks; written by the owner, read by the wheel.
+    std::atomic<uint64_t> deadline_;
+    /// Deadline the timer was put into the wheel with; the wheel looks
+    /// at the timer again no later than that.
+    std::atomic<uint64_t> scheduled_;
+    uint8_t level_;
+    uint8_t slot_;
+    bool linked_;
+  };
+
+  explicit timer_wheel(boost::asio::io_context &ioc);
+
+  void shutdown() override;
+
+  /// Returns the number of ticks since the wheel was created.
+  uint64_t clock() const;
+
+private:
+  static constexpr std::size_t slot_bits = 6;
+  static constexpr std::size_t slots = 1 << slot_bits;
+  static constexpr std::size_t levels = 4;
+
+  void add(timer &t);
+  void remove(timer &t);
+  void link(timer &t);
+  void unlink(timer &t);
+  void start_ticking();
+  void tick(uint64_t generation);
+  /// Moves the wheel to tick |now|, appending the callbacks of the
+  /// timers which expired to |expired|.
+  void advance(uint64_t now, std::vector<std::function<void()>> &expired);
+  /// Puts the timers of |level|/|slot| back into the wheel, or into
+  /// |expired| if their deadline has passed.
+  void reschedule(std::size_t level, std::size_t slot,
+                  std::vector<std::function<void()>> &expired);
+
+  std::mutex mutex_;
+  std::array<std::array<timer *, slots>, levels> wheel_;
+  boost::asio::steady_timer ticker_;
+  /// Coarse clock reading at which tick 0 started.
+  std::chrono::nanoseconds epoch_;
+  /// The tick the wheel was last moved to.
+  uint64_t now_;
+  /// Number of timers in the wheel.
+  std::size_t size_;
+  /// Identifies the current wait of ticker_, so that a tick which
+  /// completed after the wheel stopped ticking is ignored.
+  uint64_t generation_;
+  bool ticking_;
+  bool shutdown_;
+};
+
+} // namespace asio_http2
+
+} // namespace nghttp2
+
+#endif // ASIO_TIMER_WHEEL_H
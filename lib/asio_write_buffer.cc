@@ -0,0 +1,478 @@
+/*
+ * nghttp2 - HTTP/2 C Library
+ *
+ * Copyright (c) 2015 Tatsuhiro Tsujikawa
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "asio_write_buffer.h"
+
+#include <nghttp2/asio_http2.h>
+
+#ifdef HAVE_UNISTD_H
+#  include <unistd.h>
+#endif // HAVE_UNISTD_H
+
+#include <algorithm>
+#include <cerrno>
+#include <iterator>
+
+namespace nghttp2 {
+namespace asio_http2 {
+
+write_buffer::write_buffer()
+    : size_(0), file_size_(0), staging_len_(0), sendfile_enabled_(false) {}
+
+bool write_buffer::copy(const uint8_t *data, std::size_t len) {
+  auto dst = stage(len);
+  if (!dst) {
+    return false;
+  }
+
+  std::copy_n(data, len, dst);
+
+  return true;
+}
+
+void write_buffer::reference(const uint8_t *data, std::size_t len,
+                             std::shared_ptr<const void> owner) {
+  if (len == 0) {
+    return;
+  }
+
+  segments_.emplace_back(data, len);
+  size_ += len;
+
+  // Kept by control block: an owner may hold a null pointer and
+  // still release the memory with its deleter.
+  if (owner.use_count()) {
+    owners_.push_back(std::move(owner));
+  }
+}
+
+uint8_t *write_buffer::stage(std::size_t len) {
+  if (len > staging_left()) {
+    return nullptr;
+  }
+
+  auto dst = staging_.data() + staging_len_;
+
+  // Extend the last segment if it ends right where we stage to, unless
+  // a file segment goes in between.
+  if (!segments_.empty() &&
+      (files_.empty() || segments_.size() > files_.back().index)) {
+    auto &last = segments_.back();
+    if (static_cast<const uint8_t *>(last.data()) + last.size() == dst) {
+      last = boost::asio::const_buffer(last.data(), last.size() + len);
+      staging_len_ += len;
+      size_ += len;
+      return dst;
+    }
+  }
+
+  segments_.emplace_back(dst, len);
+  staging_len_ += len;
+  size_ += len;
+
+  return dst;
+}
+
+void write_buffer::file(int fd, int64_t offset, std::size_t len,
+                        std::shared_ptr<const void> owner) {
+  files_.push_back(file_segment{fd, offset, len, segments_.size()});
+  size_ += len;
+  file_size_ += len;
+
+  // Kept by control block: an owner may hold a null pointer and
+  // still release the memory with its deleter.
+  if (owner.use_count()) {
+    owners_.push_back(std::move(owner));
+  }
+}
+
+void write_buffer::enable_sendfile(bool f) { sendfile_enabled_ = f; }
+
+bool write_buffer::sendfile_enabled() const { return sendfile_enabled_; }
+
+std::span<const write_buffer::file_segment> write_buffer::files() const {
+  return files_;
+}
+
+std::size_t write_buffer::staging_left() const {
+  return staging_.size() - staging_len_;
+}
+
+bool write_buffer::full() const {
+  return size_ - file_size_ >= limit || file_size_ >= file_limit;
+}
+
+std::span<const boost::asio::const_buffer> write_buffer::buffers() const {
+  return segments_;
+}
+
+boost::asio::const_buffer write_buffer::linearize() {
+  if (segments_.size() <= 1) {
+    return segments_.empty() ? boost::asio::const_buffer() : segments_[0];
+  }
+
+  linear_.resize(size_);
+  boost::asio::buffer_copy(boost::asio::buffer(linear_), segments_);
+
+  return boost::asio::buffer(linear_);
+}
+
+std::size_t write_buffer::size() const { return size_; }
+
+bool write_buffer::empty() const { return size_ == 0; }
+
+void write_buffer::clear() {
+  segments_.clear();
+  owners_.clear();
+  files_.clear();
+  size_ = 0;
+  file_size_ = 0;
+  staging_len_ = 0;
+}
+
+int fill_write_buffer(write_buffer &wb, nghttp2_session *session) {
+  while (!wb.full()) {
+    const uint8_t *data;
+    auto n = nghttp2_session_mem_send(session, &data);
+    if (n < 0) {
+      return static_cast<int>(n);
+    }
+
+    if (n == 0) {
+      break;
+    }
+
+    if (wb.copy(data, n)) {
+      continue;
+    }
+
+    // data is only valid until the next call of
+    // nghttp2_session_mem_send, so this ends the write.
+    wb.reference(data, n);
+
+    break;
+  }
+
+  return 0;
+}
+
+namespace {
+struct file_closer {
+  ~file_closer() { close(fd); }
+  int fd;
+};
+} // namespace
+
+std::shared_ptr<const void> close_on_release(int fd) {
+  return std::make_shared<file_closer>(fd);
+}
+
+buffer_body::buffer_body() : offset_(0), left_(0), open_(false) {}
+
+buffer_body::buffer_body(std::string data) : buffer_body() {
+  auto owner = std::make_shared<std::string>(std::move(data));
+  auto p = reinterpret_cast<const uint8_t *>(owner->data());
+  auto len = owner->size();
+  push_back(p, len, std::move(owner));
+}
+
+void buffer_body::push_back(const uint8_t *data, std::size_t len,
+                            std::shared_ptr<const void> owner) {
+  if (len == 0) {
+    return;
+  }
+
+  chunks_.push_back(chunk{data, len, std::move(owner), -1, 0});
+  left_ += len;
+}
+
+void buffer_body::push_back_file(int fd, int64_t offset, std::size_t len,
+                                 std::shared_ptr<const void> owner) {
+  if (len == 0) {
+    return;
+  }
+
+  chunks_.push_back(chunk{nullptr, len, std::move(owner), fd, offset});
+  left_ += len;
+}
+
+void buffer_body::splice(buffer_body &other) {
+  if (other.chunks_.empty()) {
+    return;
+  }
+
+  if (other.offset_ > 0) {
+    auto &c = other.chunks_.front();
+    if (c.data) {
+      c.data += other.offset_;
+    } else {
+      c.file_offset += other.offset_;
+    }
+    c.len -= other.offset_;
+    other.offset_ = 0;
+  }
+
+  std::move(std::begin(other.chunks_), std::end(other.chunks_),
+            std::back_inserter(chunks_));
+  left_ += other.left_;
+
+  other.chunks_.clear();
+  other.left_ = 0;
+}
+
+void buffer_body::open(bool f) { open_ = f; }
+
+bool buffer_body::is_open() const { return open_; }
+
+ssize_t buffer_body::read(std::size_t len, uint32_t *data_flags) {
+  // Stop the payload at the boundary between memory and file chunks,
+  // so that send() deals with one kind only.
+  std::size_t avail = 0;
+  if (!chunks_.empty()) {
+    auto first = chunks_.front().fd != -1;
+    auto off = offset_;
+    for (auto &c : chunks_) {
+      if ((c.fd != -1) != first || (first && avail > 0)) {
+        break;
+      }
+      avail += c.len - off;
+      off = 0;
+      if (avail >= len) {
+        break;
+      }
+    }
+  }
+
+  auto n = std::min(len, avail);
+
+  if (n == 0 && open_) {
+    return NGHTTP2_ERR_DEFERRED;
+  }
+
+  if (n == left_ && !open_) {
+    *data_flags |= NGHTTP2_DATA_FLAG_EOF;
+  }
+
+  if (n > 0) {
+    *data_flags |= NGHTTP2_DATA_FLAG_NO_COPY;
+  }
+
+  return n;
+}
+
+namespace {
+const std::array<uint8_t, 256> padding{};
+} // namespace
+
+namespace {
+// Appends the frame header |framehd| of DATA frame |frame|, and its
+// pad length field, to |wb|.  Returns false, and does nothing, unless
+// |wb| has room for them and |staged| more bytes.
+bool begin_data_frame(write_buffer &wb, const nghttp2_frame *frame,
+                      const uint8_t *framehd, std::size_t staged) {
+  // 9 bytes frame header, and 1 byte pad length if padded.
+  if (wb.full() || wb.staging_left() < 10 + staged) {
+    return false;
+  }
+
+  wb.copy(framehd, 9);
+
+  if (frame->data.padlen > 0) {
+    uint8_t padlen_field = static_cast<uint8_t>(frame->data.padlen - 1);
+    wb.copy(&padlen_field, 1);
+  }
+
+  return true;
+}
+} // namespace
+
+namespace {
+// Appends the padding of DATA frame |frame| to |wb|.
+void end_data_frame(write_buffer &wb, const nghttp2_frame *frame) {
+  if (frame->data.padlen > 1) {
+    wb.reference(padding.data(), frame->data.padlen - 1);
+  }
+}
+} // namespace
+
+int send_data_frame(write_buffer &wb, nghttp2_frame *frame,
+                    const uint8_t *framehd, const uint8_t *data,
+                    std::size_t length, std::shared_ptr<const void> owner) {
+  if (!begin_data_frame(wb, frame, framehd, 0)) {
+    return NGHTTP2_ERR_WOULDBLOCK;
+  }
+
+  if (length > 0) {
+    wb.reference(data, length, std::move(owner));
+  }
+
+  end_data_frame(wb, frame);
+
+  return 0;
+}
+
+int buffer_body::send(write_buffer &wb, nghttp2_frame *frame,
+                      const uint8_t *framehd, std::size_t length) {
+  auto file = !chunks_.empty() && chunks_.front().fd != -1;
+
+  // Without sendfile, a file payload is read into the staging area
+  // too.
+  if (!begin_data_frame(wb, frame, framehd,
+                        file && !wb.sendfile_enabled() ? length : 0)) {
+    return NGHTTP2_ERR_WOULDBLOCK;
+  }
+
+  if (file) {
+    if (send_file(wb, length) != 0) {
+      return NGHTTP2_ERR_CALLBACK_FAILURE;
+    }
+  }
+
+  while (!file && length > 0) {
+    auto &c = chunks_.front();
+    auto n = std::min(length, c.len - offset_);
+
+    wb.reference(c.data + offset_, n, c.owner);
+
+    offset_ += n;
+    left_ -= n;
+    length -= n;
+
+    if (offset_ == c.len) {
+      chunks_.pop_front();
+      offset_ = 0;
+    }
+  }
+
+  end_data_frame(wb, frame);
+
+  return 0;
+}
+
+int buffer_body::send_file(write_buffer &wb, std::size_t length) {
+  auto &c = chunks_.front();
+  auto offset = c.file_offset + static_cast<int64_t>(offset_);
+
+  if (wb.sendfile_enabled()) {
+    wb.file(c.fd, offset, length, c.owner);
+  } else {
+    auto dst = wb.stage(length);
+    for (std::size_t nread = 0; nread < length;) {
+      ssize_t n;
+      while ((n = pread(c.fd, dst + nread, length - nread,
+                        offset + nread)) == -1 &&
+             errno == EINTR)
+        ;
+      // The frame header has already been written; a file which shrank
+      // cannot be recovered from.
+      if (n <= 0) {
+        return -1;
+      }
+      nread += n;
+    }
+  }
+
+  offset_ += length;
+  left_ -= length;
+
+  if (offset_ == c.len) {
+    chunks_.pop_front();
+    offset_ = 0;
+  }
+
+  return 0;
+}
+
+std::size_t buffer_body::left() const { return left_; }
+
+buffer_chain::buffer_chain() : body_(std::make_unique<buffer_body>()) {}
+
+buffer_chain::~buffer_chain() {}
+
+buffer_chain::buffer_chain(buffer_chain &&other) noexcept = default;
+
+buffer_chain &buffer_chain::operator=(buffer_chain &&other) noexcept = default;
+
+void buffer_chain::append(std::string data) {
+  if (data.empty()) {
+    return;
+  }
+
+  auto owner = std::make_shared<std::string>(std::move(data));
+  auto p = reinterpret_cast<const uint8_t *>(owner->data());
+  auto len = owner->size();
+  body().push_back(p, len, std::move(owner));
+}
+
+void buffer_chain::append(std::vector<std::string> data) {
+  // The strings share one owner, released with the last of them.
+  auto owner = std::make_shared<std::vector<std::string>>(std::move(data));
+  for (auto &s : *owner) {
+    body().push_back(reinterpret_cast<const uint8_t *>(s.data()), s.size(),
+                     owner);
+  }
+}
+
+void buffer_chain::append(std::shared_ptr<const std::byte[]> data,
+                          std::size_t offset, std::size_t len) {
+  auto p = reinterpret_cast<const uint8_t *>(data.get()) + offset;
+  body().push_back(p, len, std::move(data));
+}
+
+void buffer_chain::append(boost::asio::const_buffer buf,
+                          std::function<void()> release) {
+  // The deleter runs once the last chunk referencing |buf| is
+  // released, after its bytes have been written.
+  auto owner = std::shared_ptr<const void>(
+      buf.data(), [release = std::move(release)](const void *) {
+        if (release) {
+          release();
+        }
+      });
+  body().push_back(static_cast<const uint8_t *>(buf.data()), buf.size(),
+                   std::move(owner));
+}
+
+std::size_t buffer_chain::size() const { return body_ ? body_->left() : 0; }
+
+bool buffer_chain::empty() const { return size() == 0; }
+
+std::unique_ptr<buffer_body> buffer_chain::release() {
+  // Leaves this chain empty, like a moved-from one; append() gives it
+  // a new body.
+  if (!body_) {
+    return std::make_unique<buffer_body>();
+  }
+  return std::move(body_);
+}
+
+buffer_body &buffer_chain::body() {
+  if (!body_) {
+    body_ = std::make_unique<buffer_body>();
+  }
+  return *body_;
+}
+
+} // namespace asio_http2
+} // namespace nghttp2
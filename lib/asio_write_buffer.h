@@ -0,0 +1,234 @@
+/*
+ * nghttp2 - HTTP/2 C Library
+ *
+ * Copyright (c) 2015 Tatsuhiro Tsujikawa
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef ASIO_WRITE_BUFFER_H
+#define ASIO_WRITE_BUFFER_H
+
+#include "nghttp2_config.h"
+
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <boost/asio/buffer.hpp>
+
+#include <nghttp2/nghttp2.h>
+
+#include "template.h"
+
+namespace nghttp2 {
+namespace asio_http2 {
+
+// Output of one write to the socket, as a sequence of segments.
+// Small pieces, such as frame headers and the serialized frames
+// returned by nghttp2_session_mem_send, are copied into a staging
+// area, while larger ones are referenced in place.  Referenced memory
+// is kept alive by an optional owner until clear() is called, which
+// must not happen before the write completes.
+//
+// If the transport supports it, a write may also carry ranges of
+// files, each sent with sendfile(2) between the memory segments added
+// before and after it.
+class write_buffer {
+public:
+  // A range of a file, sent after the first |index| memory segments.
+  struct file_segment {
+    int fd;
+    int64_t offset;
+    std::size_t len;
+    std::size_t index;
+  };
+
+  // Upper bound of the memory bytes gathered for a single write.
+  static constexpr std::size_t limit = 64_k;
+  // Upper bound of the file bytes of a single write.  They are not
+  // copied, so that a write carries several DATA frames of a file
+  // instead of waking up the connection for each one.
+  static constexpr std::size_t file_limit = 256_k;
+
+  write_buffer();
+
+  write_buffer(const write_buffer &) = delete;
+  write_buffer &operator=(const write_buffer &) = delete;
+
+  // Copies |len| bytes at |data| into the staging area.  Returns
+  // false, and does nothing, if they do not fit.
+  bool copy(const uint8_t *data, std::size_t len);
+
+  // Appends |len| bytes at |data| without copying.  |owner|, if not
+  // null, is held until clear().
+  void reference(const uint8_t *data, std::size_t len,
+                 std::shared_ptr<const void> owner = nullptr);
+
+  // Returns a pointer to |len| bytes of the staging area, appended to
+  // the output, for the caller to fill in.  Returns nullptr if they
+  // do not fit.
+  uint8_t *stage(std::size_t len);
+
+  // Appends |len| bytes of file |fd| starting at |offset|.  |owner|,
+  // if not null, is held until clear().  This must only be used if
+  // sendfile_enabled().
+  void file(int fd, int64_t offset, std::size_t len,
+            std::shared_ptr<const void> owner = nullptr);
+
+  // Allows file segments, for transports which can send them with
+  // sendfile(2), i.e. cleartext TCP.
+  void enable_sendfile(bool f);
+  bool sendfile_enabled() const;
+
+  // Returns the file segments of this write, in order.
+  std::span<const file_segment> files() const;
+
+  // Returns the number of bytes left in the staging area.
+  std::size_t staging_left() const;
+
+  // Returns true if no more data should be added to this write.
+  bool full() const;
+
+  // Returns the memory segments, to be passed to a gathering write.
+  // If there are file segments, they are split around each of them at
+  // its index.
+  std::span<const boost::asio::const_buffer> buffers() const;
+
+  // Returns the output as a single contiguous buffer, copying the
+  // segments into a linear area if there is more than one.  This is
+  // used by the transports which cannot write a buffer sequence in one
+  // go, such as TLS.  It must not be used with file segments.
+  boost::asio::const_buffer linearize();
+
+  std::size_t size() const;
+  bool empty() const;
+
+  // Releases the segments and their owners.
+  void clear();
+
+private:
+  std::vector<boost::asio::const_buffer> segments_;
+  std::vector<std::shared_ptr<const void>> owners_;
+  std::vector<uint8_t> linear_;
+  std::vector<file_segment> files_;
+  std::size_t size_;
+  // Bytes of files_, included in size_.
+  std::size_t file_size_;
+  std::size_t staging_len_;
+  bool sendfile_enabled_;
+  std::array<uint8_t, limit> staging_;
+};
+
+// Fills |wb| with the pending output of |session|.  Serialized frames
+// are copied while they fit into the staging area.  The first one
+// which does not fit is referenced in place and ends the write, since
+// the memory returned by nghttp2_session_mem_send is only valid until
+// it is called again.  Returns 0, or a negative nghttp2 error code.
+int fill_write_buffer(write_buffer &wb, nghttp2_session *session);
+
+// Implements nghttp2_send_data_callback for a payload of |length|
+// bytes at |data|, which are referenced from |wb| and kept alive by
+// |owner|.  Returns NGHTTP2_ERR_WOULDBLOCK if |wb| is full.
+int send_data_frame(write_buffer &wb, nghttp2_frame *frame,
+                    const uint8_t *framehd, const uint8_t *data,
+                    std::size_t length, std::shared_ptr<const void> owner);
+
+// Returns an owner, for buffer_body::push_back_file(), which closes
+// |fd| when released.
+std::shared_ptr<const void> close_on_release(int fd);
+
+// A request or response body sent with NGHTTP2_DATA_FLAG_NO_COPY.
+// The body is a list of chunks, each kept alive by its owner; DATA
+// frame payloads are referenced from the write_buffer instead of being
+// copied into nghttp2's frame buffer and then into the socket buffer.
+// A chunk may also be a range of a file, which goes out with
+// sendfile(2) if the write_buffer allows it, and is otherwise read
+// straight into the staging area.
+class buffer_body {
+public:
+  buffer_body();
+
+  // Makes a body of |data|.
+  explicit buffer_body(std::string data);
+
+  // Appends |len| bytes at |data|, kept alive by |owner|.
+  void push_back(const uint8_t *data, std::size_t len,
+                 std::shared_ptr<const void> owner);
+
+  // Appends |len| bytes of file |fd| starting at |offset|.  |owner|
+  // must keep |fd| open.
+  void push_back_file(int fd, int64_t offset, std::size_t len,
+                      std::shared_ptr<const void> owner);
+
+  // Moves the chunks of |other| to the end of this body.
+  void splice(buffer_body &other);
+
+  // While open, more chunks may be appended after the ones sent, and
+  // read() returns NGHTTP2_ERR_DEFERRED instead of setting
+  // NGHTTP2_DATA_FLAG_EOF when there are none left.
+  void open(bool f);
+  bool is_open() const;
+
+  // Implements nghttp2_data_source_read_callback: returns the length
+  // of the next DATA frame payload, at most |len|, and sets
+  // NGHTTP2_DATA_FLAG_NO_COPY and NGHTTP2_DATA_FLAG_EOF as
+  // appropriate.  A payload never spans memory and file chunks.
+  ssize_t read(std::size_t len, uint32_t *data_flags);
+
+  // Implements nghttp2_send_data_callback: appends the frame header
+  // |framehd|, |length| bytes of payload and the padding of |frame| to
+  // |wb|.  Returns NGHTTP2_ERR_WOULDBLOCK if |wb| is full, in which
+  // case the frame is sent with the next write.
+  int send(write_buffer &wb, nghttp2_frame *frame, const uint8_t *framehd,
+           std::size_t length);
+
+  // Returns the number of bytes not yet passed to send().
+  std::size_t left() const;
+
+private:
+  struct chunk {
+    // nullptr for a file chunk.
+    const uint8_t *data;
+    std::size_t len;
+    std::shared_ptr<const void> owner;
+    // File and offset of a file chunk.
+    int fd;
+    int64_t file_offset;
+  };
+
+  // Sends |length| bytes of the file chunk at the front.
+  int send_file(write_buffer &wb, std::size_t length);
+
+  std::deque<chunk> chunks_;
+  // Offset into the first chunk.
+  std::size_t offset_;
+  // Bytes not yet passed to send().
+  std::size_t left_;
+  bool open_;
+};
+
+} // namespace asio_http2
+} // namespace nghttp2
+
+#endif // ASIO_WRITE_BUFFER_H
@@ -25,9 +25,11 @@
 #ifndef ASIO_HTTP2_H
 #define ASIO_HTTP2_H
 
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <functional>
 #include <map>
@@ -68,6 +70,46 @@ struct NGHTTP2_ASIO_EXPORT header_value {
 // header fields.  The header field name must be lower-cased.
 using header_map = std::multimap<std::string, header_value>;
 
+// A received header field.  |name| and |value| point into storage
+// owned by the request or response they were received with, and stay
+// valid until its stream is closed.
+struct NGHTTP2_ASIO_EXPORT header_field {
+  std::string_view name;
+  std::string_view value;
+  // true if the peer asked for this field not to be indexed.
+  bool sensitive;
+};
+
+// Read-only view of received header fields, in the order they were
+// received.  Lookup of well known header field names (e.g.,
+// content-type, user-agent) does not scan the fields.
+class NGHTTP2_ASIO_EXPORT header_view {
+public:
+  using const_iterator = const header_field *;
+
+  // Application must not call this directly.
+  header_view(const header_field *fields, size_t size, const int16_t *index)
+      : fields_(fields), size_(size), index_(index) {}
+
+  const_iterator begin() const { return fields_; }
+  const_iterator end() const { return fields_ + size_; }
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  // Returns the first header field named |name|, or nullptr if there
+  // is none.  |name| must be lower-cased.
+  const header_field *find(std::string_view name) const;
+
+  // Returns the value of the first header field named |name|, or an
+  // empty string if there is none.
+  std::string_view value(std::string_view name) const;
+
+private:
+  const header_field *fields_;
+  size_t size_;
+  const int16_t *index_;
+};
+
 const boost::system::error_category &nghttp2_category() noexcept;
 
 struct NGHTTP2_ASIO_EXPORT uri_ref {
@@ -90,6 +132,14 @@ using error_cb = std::function<void(const boost::system::error_code& ec)>;
 // Callback function when request and response are finished.  The
 // parameter indicates the cause of closure.
 using close_cb = std::function<void(uint32_t)>;
+// Callback function invoked with body read by an asynchronous read
+// operation, such as server::request::async_read_some().  An empty
+// |data| without error marks the end of the body.
+using read_cb =
+    std::function<void(const boost::system::error_code &ec, std::string data)>;
+// Callback function invoked when an asynchronous write operation, such
+// as server::response::async_write(), completes.
+using write_cb = std::function<void(const boost::system::error_code &ec)>;
 
 // Callback function to generate response body.  This function has the
 // same semantics with nghttp2_data_source_read_callback.  Just source
@@ -113,6 +163,51 @@ NGHTTP2_ASIO_EXPORT generator_cb file_generator(const std::string &path);
 // function object is destroyed.
 NGHTTP2_ASIO_EXPORT generator_cb file_generator_from_fd(int fd);
 
+class buffer_body;
+
+// A request or response body made of a chain of buffers, which is sent
+// without being copied: the payload of each DATA frame is written to
+// the socket straight from the appended memory.  Each buffer is kept
+// alive until the bytes in it have been written, and is then
+// released.
+class NGHTTP2_ASIO_EXPORT buffer_chain {
+public:
+  buffer_chain();
+  ~buffer_chain();
+
+  buffer_chain(buffer_chain &&other) noexcept;
+  buffer_chain &operator=(buffer_chain &&other) noexcept;
+
+  // Appends |data|, taking ownership of it.
+  void append(std::string data);
+
+  // Appends each string of |data| in order, taking ownership of them.
+  void append(std::vector<std::string> data);
+
+  // Appends |len| bytes of |data| starting at |offset|.  |data| is
+  // shared, and may be appended several times.
+  void append(std::shared_ptr<const std::byte[]> data, std::size_t offset,
+              std::size_t len);
+
+  // Appends |buf|, which must stay valid until |release| is called.
+  // |release| is called once, from the thread running the stream, or
+  // when this object is destroyed unsent.
+  void append(boost::asio::const_buffer buf, std::function<void()> release);
+
+  // Returns the total number of bytes appended.
+  std::size_t size() const;
+  bool empty() const;
+
+  // Application must not call this directly.
+  std::unique_ptr<buffer_body> release();
+
+private:
+  // Returns the body, creating it if this chain was moved from.
+  buffer_body &body();
+
+  std::unique_ptr<buffer_body> body_;
+};
+
 // Validates path so that it does not contain directory traversal
 // vector.  Returns true if path is safe.  The |path| must start with
 // "/" otherwise returns false.  This function should be called after
@@ -125,6 +220,12 @@ NGHTTP2_ASIO_EXPORT std::string percent_decode(const std::string &s);
 // Returns HTTP date representation of current posix time |t|.
 NGHTTP2_ASIO_EXPORT std::string http_date(int64_t t);
 
+// Sets the bound of the sum of the auto tuned windows of all the
+// connections of the process, servers and clients alike (see
+// server::server_settings::max_auto_window_size).  Past it, windows
+// stop growing and shrink.  Defaults to 1 GiB.
+NGHTTP2_ASIO_EXPORT void auto_window_budget(std::size_t n);
+
 // Parses |uri| and extract scheme, host and service.  The service is
 // port component of URI (e.g., "8443") if available, otherwise it is
 // scheme (e.g., "https").
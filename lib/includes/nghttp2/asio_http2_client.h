@@ -26,8 +26,15 @@
 #define ASIO_HTTP2_CLIENT_H
 
 #include <nghttp2/asio_http2.h>
+#include <boost/asio/associated_cancellation_slot.hpp>
+#include <boost/asio/async_result.hpp>
+#include <boost/asio/bind_cancellation_slot.hpp>
 #include <boost/asio/io_context.hpp>
 #include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/post.hpp>
+#ifdef BOOST_ASIO_HAS_CO_AWAIT
+#  include <boost/asio/use_awaitable.hpp>
+#endif // BOOST_ASIO_HAS_CO_AWAIT
 
 namespace nghttp2 {
 
@@ -40,9 +47,12 @@ class response_impl;
 class NGHTTP2_ASIO_EXPORT response {
 public:
   // Application must not call this directly.
-  response();
+  explicit response(response_impl &impl);
   ~response();
 
+  response(const response &) = delete;
+  response &operator=(const response &) = delete;
+
   // Sets callback which is invoked when chunk of response body is
   // received.
   void on_data(data_cb cb) const;
@@ -57,11 +67,122 @@ public:
   // which start with colon (:), are excluded from this list.
   const header_map &header() const;
 
+  // Same as header(), without copying the fields into a map.
+  header_view fields() const;
+
   // Application must not call this directly.
   response_impl &impl() const;
 
 private:
-  std::unique_ptr<response_impl> impl_;
+  // Lives next to this object, in the same stream.
+  response_impl *impl_;
+};
+
+class response_reader_impl;
+
+// Response to a request, read with asynchronous operations instead of
+// callbacks, see session::async_submit() and request::reader().  Its
+// header fields and body are kept, so that unlike response, it stays
+// valid after the stream is closed.  Copies share the same state.  It
+// must only be used from the thread running the io_context of the
+// session, which is where its callbacks are invoked.
+class NGHTTP2_ASIO_EXPORT response_reader {
+public:
+  response_reader() = default;
+  // Application must not call this directly.
+  explicit response_reader(std::shared_ptr<response_reader_impl> impl);
+
+  // Returns status code, or 0 until the response header fields are
+  // received.
+  int status_code() const;
+
+  // Returns content-length.  -1 if it is unknown.
+  int64_t content_length() const;
+
+  // Returns the response header fields.
+  const header_map &header() const;
+
+  // Invokes |cb| once the response header fields are received.  If the
+  // stream is closed first, |cb| gets the same error as
+  // async_read_some().
+  void async_read_header(write_cb cb) const;
+
+  // Passes the response body received since the previous read to |cb|,
+  // waiting for some if there is none, or an empty string at the end
+  // of the body.  If the stream is reset before that, |cb| gets the
+  // error code of RST_STREAM, or boost::asio::error::operation_aborted
+  // if it was cancelled.  Only one read may be pending at a time.
+  void async_read_some(read_cb cb) const;
+
+  // Passes the rest of the response body to |cb| as a whole, once it
+  // is received.  If it is longer than |limit| bytes, |cb| gets
+  // boost::asio::error::message_size instead, and the part received
+  // so far is discarded.
+  void async_read_all(std::size_t limit, read_cb cb) const;
+
+  // Cancels the request with |error_code|.  Pending reads of the body
+  // not received yet get boost::asio::error::operation_aborted.
+  void cancel(uint32_t error_code = NGHTTP2_CANCEL) const;
+
+  // Returns true unless this is a default constructed reader.
+  explicit operator bool() const { return impl_ != nullptr; }
+
+#ifdef BOOST_ASIO_HAS_CO_AWAIT
+  // The functions below are the same as the ones above, as
+  // asynchronous operations which are awaitable by default, e.g.,
+  // co_await reader.read_some() returns the data, and throws
+  // boost::system::system_error on error.  A cancellation emitted on
+  // the slot associated with the completion handler cancels the
+  // request.
+  template <typename CompletionToken = boost::asio::use_awaitable_t<>>
+  auto read_header(CompletionToken &&token = CompletionToken{}) const {
+    return boost::asio::async_initiate<CompletionToken,
+                                       void(boost::system::error_code)>(
+        [this](auto handler) {
+          async_read_header(wrap(std::move(handler)));
+        },
+        token);
+  }
+
+  template <typename CompletionToken = boost::asio::use_awaitable_t<>>
+  auto read_some(CompletionToken &&token = CompletionToken{}) const {
+    return boost::asio::async_initiate<
+        CompletionToken, void(boost::system::error_code, std::string)>(
+        [this](auto handler) { async_read_some(wrap(std::move(handler))); },
+        token);
+  }
+
+  template <typename CompletionToken = boost::asio::use_awaitable_t<>>
+  auto read_all(std::size_t limit,
+                CompletionToken &&token = CompletionToken{}) const {
+    return boost::asio::async_initiate<
+        CompletionToken, void(boost::system::error_code, std::string)>(
+        [this, limit](auto handler) {
+          async_read_all(limit, wrap(std::move(handler)));
+        },
+        token);
+  }
+#endif // BOOST_ASIO_HAS_CO_AWAIT
+
+private:
+  // Returns a callback invoking |handler|, which may be move-only.
+  // While it is pending, a cancellation emitted on the slot associated
+  // with |handler| cancels the request.
+  template <typename Handler> auto wrap(Handler handler) const {
+    auto h = std::make_shared<Handler>(std::move(handler));
+    auto slot = boost::asio::get_associated_cancellation_slot(*h);
+    if (slot.is_connected()) {
+      slot.assign([impl = impl_](boost::asio::cancellation_type_t) {
+        response_reader(impl).cancel();
+      });
+    }
+    return [h](const boost::system::error_code &ec, auto &&...data) {
+      boost::asio::get_associated_cancellation_slot(*h).clear();
+      std::move(*h)(ec, std::forward<decltype(data)>(data)...);
+    };
+  }
+
+  std::shared_ptr<response_reader_impl> impl_;
 };
 
 class request;
@@ -76,9 +197,12 @@ class request_impl;
 class NGHTTP2_ASIO_EXPORT request {
 public:
   // Application must not call this directly.
-  request();
+  explicit request(request_impl &impl);
   ~request();
 
+  request(const request &) = delete;
+  request &operator=(const request &) = delete;
+
   // Sets callback which is invoked when response header is received.
   void on_response(response_cb cb) const;
 
@@ -103,6 +227,65 @@ public:
   // Resumes deferred uploading.
   void resume() const;
 
+  // Returns the reader of the response to this request.  The response
+  // is passed to it from the time of the first call, as well as to the
+  // callbacks, so it must be called before returning to the
+  // io_context after the request is submitted.
+  response_reader reader() const;
+
+  // Appends |data| to the body of a request submitted with
+  // session::submit_streaming(), and invokes |cb| once nghttp2 took
+  // all of it, which waits for the server to give flow control
+  // credit.  Only one of this and async_finish() may be pending at a
+  // time.  If the stream is closed first, |cb| gets
+  // boost::asio::error::operation_aborted, and the request must not be
+  // accessed any more.
+  void async_write(std::string data, write_cb cb) const;
+
+  // Same as above, but the buffers of |data| are sent without copying.
+  void async_write(buffer_chain data, write_cb cb) const;
+
+  // Ends the body of a request submitted with
+  // session::submit_streaming(), and invokes |cb| once nghttp2 took
+  // the end of it.
+  void async_finish(write_cb cb) const;
+
+#ifdef BOOST_ASIO_HAS_CO_AWAIT
+  // Same as async_write(), as an asynchronous operation.  By default,
+  // it is awaitable: co_await req.write(data) suspends until the data
+  // is taken, and throws boost::system::system_error on error.
+  template <typename CompletionToken = boost::asio::use_awaitable_t<>>
+  auto write(std::string data,
+             CompletionToken &&token = CompletionToken{}) const {
+    return boost::asio::async_initiate<CompletionToken,
+                                       void(boost::system::error_code)>(
+        [this](auto handler, std::string data) {
+          async_write(std::move(data), wrap(std::move(handler)));
+        },
+        token, std::move(data));
+  }
+
+  template <typename CompletionToken = boost::asio::use_awaitable_t<>>
+  auto write(buffer_chain data,
+             CompletionToken &&token = CompletionToken{}) const {
+    return boost::asio::async_initiate<CompletionToken,
+                                       void(boost::system::error_code)>(
+        [this](auto handler, buffer_chain data) {
+          async_write(std::move(data), wrap(std::move(handler)));
+        },
+        token, std::move(data));
+  }
+
+  // Same as async_finish(), as an asynchronous operation.
+  template <typename CompletionToken = boost::asio::use_awaitable_t<>>
+  auto finish(CompletionToken &&token = CompletionToken{}) const {
+    return boost::asio::async_initiate<CompletionToken,
+                                       void(boost::system::error_code)>(
+        [this](auto handler) { async_finish(wrap(std::move(handler))); },
+        token);
+  }
+#endif // BOOST_ASIO_HAS_CO_AWAIT
+
   // Returns method (e.g., GET).
   const std::string &method() const;
 
@@ -113,11 +296,21 @@ public:
   // start with colon (:), are excluded from this list.
   const header_map &header() const;
 
+  // Same as header(), without copying the fields into a map.
+  header_view fields() const;
+
   // Application must not call this directly.
   request_impl &impl() const;
 
 private:
-  std::unique_ptr<request_impl> impl_;
+  // Returns write_cb invoking |handler|, which may be move-only.
+  template <typename Handler> static write_cb wrap(Handler handler) {
+    auto h = std::make_shared<Handler>(std::move(handler));
+    return [h](const boost::system::error_code &ec) { std::move(*h)(ec); };
+  }
+
+  // Lives next to this object, in the same stream.
+  request_impl *impl_;
 };
 
 // Wrapper around an nghttp2_priority_spec.
@@ -203,6 +396,13 @@ public:
   // Sets read timeout, which defaults to 60 seconds.
   void read_timeout(std::chrono::microseconds t);
 
+  // Instead of fixed 256 MiB windows, starts with 64 KiB stream and
+  // connection windows and tunes them to the bandwidth-delay product
+  // of the connection, measured with PINGs, up to |n| bytes.  See
+  // server::server_settings::max_auto_window_size.  Must be called
+  // before the connection is established.
+  void max_auto_window_size(uint32_t n);
+
   // Shutdowns connection.
   void shutdown() const;
 
@@ -230,6 +430,16 @@ public:
                         std::string data, header_map h = header_map{},
                         priority_spec prio = priority_spec()) const;
 
+  // Submits request to server using |method| (e.g., "GET"), |uri|
+  // (e.g., "http://localhost/") and optionally additional header
+  // fields.  The buffers of |body| are sent as request body, without
+  // being copied.  This function returns pointer to request object if
+  // it succeeds, or nullptr and |ec| contains error message.
+  const request *submit(boost::system::error_code &ec,
+                        const std::string &method, const std::string &uri,
+                        buffer_chain body, header_map h = header_map{},
+                        priority_spec prio = priority_spec()) const;
+
   // Submits request to server using |method| (e.g., "GET"), |uri|
   // (e.g., "http://localhost/") and optionally additional header
   // fields.  The |cb| is used to generate request body.  This
@@ -240,7 +450,120 @@ public:
                         generator_cb cb, header_map h = header_map{},
                         priority_spec prio = priority_spec()) const;
 
+  // Submits request to server using |method| (e.g., "POST"), |uri|
+  // (e.g., "http://localhost/") and optionally additional header
+  // fields.  The request body is written afterwards with
+  // request::async_write(), and ended with request::async_finish().
+  // This function returns pointer to request object if it succeeds,
+  // or nullptr and |ec| contains error message.
+  const request *submit_streaming(boost::system::error_code &ec,
+                                  const std::string &method,
+                                  const std::string &uri,
+                                  header_map h = header_map{},
+                                  priority_spec prio = priority_spec()) const;
+
+  // Invokes |cb| from the io_context once the connection is
+  // established, or with the error which terminated the session.
+  // Unlike on_connect(), any number of callbacks may wait.
+  void async_wait_connected(error_cb cb) const;
+
+#ifdef BOOST_ASIO_HAS_CO_AWAIT
+  // Same as async_wait_connected(), as an asynchronous operation,
+  // which is awaitable by default.
+  template <typename CompletionToken = boost::asio::use_awaitable_t<>>
+  auto wait_connected(CompletionToken &&token = CompletionToken{}) const {
+    return boost::asio::async_initiate<CompletionToken,
+                                       void(boost::system::error_code)>(
+        [this](auto handler) {
+          auto h = std::make_shared<decltype(handler)>(std::move(handler));
+          async_wait_connected(
+              [h](const boost::system::error_code &ec) { std::move(*h)(ec); });
+        },
+        token);
+  }
+
+  // Submits request like submit(), as an asynchronous operation which
+  // completes with the reader of the response once its header fields
+  // are received, or with an error.  By default, it is awaitable:
+  // co_await sess.async_submit("GET", uri) returns the
+  // response_reader, and throws boost::system::system_error on error.
+  // A cancellation emitted on the slot associated with the completion
+  // handler cancels the request.
+  template <typename CompletionToken = boost::asio::use_awaitable_t<>>
+  auto async_submit(std::string method, std::string uri,
+                    header_map h = header_map{},
+                    CompletionToken &&token = CompletionToken{}) const {
+    return boost::asio::async_initiate<
+        CompletionToken, void(boost::system::error_code, response_reader)>(
+        [this](auto handler, std::string method, std::string uri,
+               header_map h) {
+          boost::system::error_code ec;
+          auto req = submit(ec, method, uri, std::move(h));
+          initiate_submit(std::move(handler), ec, req);
+        },
+        token, std::move(method), std::move(uri), std::move(h));
+  }
+
+  // Same as above, with |data| as request body.
+  template <typename CompletionToken = boost::asio::use_awaitable_t<>>
+  auto async_submit(std::string method, std::string uri, std::string data,
+                    header_map h = header_map{},
+                    CompletionToken &&token = CompletionToken{}) const {
+    return boost::asio::async_initiate<
+        CompletionToken, void(boost::system::error_code, response_reader)>(
+        [this](auto handler, std::string method, std::string uri,
+               std::string data, header_map h) {
+          boost::system::error_code ec;
+          auto req = submit(ec, method, uri, std::move(data), std::move(h));
+          initiate_submit(std::move(handler), ec, req);
+        },
+        token, std::move(method), std::move(uri), std::move(data),
+        std::move(h));
+  }
+
+  // Same as above, with the buffers of |data| sent as request body
+  // without being copied.
+  template <typename CompletionToken = boost::asio::use_awaitable_t<>>
+  auto async_submit(std::string method, std::string uri, buffer_chain data,
+                    header_map h = header_map{},
+                    CompletionToken &&token = CompletionToken{}) const {
+    return boost::asio::async_initiate<
+        CompletionToken, void(boost::system::error_code, response_reader)>(
+        [this](auto handler, std::string method, std::string uri,
+               buffer_chain data, header_map h) {
+          boost::system::error_code ec;
+          auto req = submit(ec, method, uri, std::move(data), std::move(h));
+          initiate_submit(std::move(handler), ec, req);
+        },
+        token, std::move(method), std::move(uri), std::move(data),
+        std::move(h));
+  }
+#endif // BOOST_ASIO_HAS_CO_AWAIT
+
 private:
+#ifdef BOOST_ASIO_HAS_CO_AWAIT
+  // Completes async_submit() with |handler|: with |ec| if |req| is
+  // nullptr, and otherwise with the reader of its response once the
+  // header fields are received.
+  template <typename Handler>
+  void initiate_submit(Handler handler, const boost::system::error_code &ec,
+                       const request *req) const {
+    auto h = std::make_shared<Handler>(std::move(handler));
+    if (!req) {
+      boost::asio::post(executor(),
+                        [h, ec]() { std::move(*h)(ec, response_reader{}); });
+      return;
+    }
+
+    auto reader = req->reader();
+    auto done = [h, reader](const boost::system::error_code &ec) {
+      std::move(*h)(ec, reader);
+    };
+    reader.read_header(boost::asio::bind_cancellation_slot(
+        boost::asio::get_associated_cancellation_slot(*h), std::move(done)));
+  }
+#endif // BOOST_ASIO_HAS_CO_AWAIT
+
   std::shared_ptr<session_impl> impl_;
 };
 
@@ -27,8 +27,17 @@
 
 #include <nghttp2/asio_http2.h>
 
+#include <exception>
+#include <optional>
+
+#include <boost/asio/async_result.hpp>
 #include <boost/asio/strand.hpp>
 #include <boost/asio/ip/tcp.hpp>
+#ifdef BOOST_ASIO_HAS_CO_AWAIT
+#  include <boost/asio/awaitable.hpp>
+#  include <boost/asio/co_spawn.hpp>
+#  include <boost/asio/use_awaitable.hpp>
+#endif // BOOST_ASIO_HAS_CO_AWAIT
 
 namespace nghttp2 {
 
@@ -38,17 +47,24 @@ namespace server {
 
 class request_impl;
 class response_impl;
+class prebuilt_response_impl;
 
 class NGHTTP2_ASIO_EXPORT request {
 public:
   // Application must not call this directly.
-  request();
+  explicit request(request_impl &impl);
   ~request();
 
+  request(const request &) = delete;
+  request &operator=(const request &) = delete;
+
   // Returns request header fields.  The pseudo header fields, which
   // start with colon (:), are excluded from this list.
   const header_map &header() const;
 
+  // Same as header(), without copying the fields into a map.
+  header_view fields() const;
+
   // Returns method (e.g., GET).
   const std::string &method() const;
 
@@ -59,6 +75,68 @@ public:
   // received.
   void on_data(data_cb cb) const;
 
+  // With manual flow control (see server_settings), stops giving the
+  // client credit for the request body passed to on_data() callback
+  // from now on, so that it sends at most a stream window more.  Has
+  // no effect otherwise.  This and the functions below must be called
+  // from the executor of the response.
+  void pause() const;
+
+  // Gives the client credit for the request body held back since
+  // pause(), and resumes doing so for each chunk received.
+  void resume() const;
+
+  // Gives the client credit for |n| bytes of the request body held
+  // back since pause(), e.g., once they are written to disk.
+  void consume(std::size_t n) const;
+
+  // Keeps the request body received from now on for
+  // async_read_some() and async_read_all(), in place of passing it to
+  // on_data() callback.  The client gets credit for it as it is read,
+  // so that with manual flow control, at most a stream window of it
+  // is kept.  co_handler() calls this before starting its coroutine.
+  void keep_body() const;
+
+  // Passes the request body received since the previous read to |cb|,
+  // waiting for some if there is none, or an empty string at the end
+  // of the body.  This and the functions below must be called from
+  // the executor of the response, and |cb| is invoked from there.
+  // Only one read may be pending at a time.  If the stream is closed
+  // first, |cb| gets boost::asio::error::operation_aborted, and the
+  // request and response must not be accessed any more.
+  void async_read_some(read_cb cb) const;
+
+  // Passes the rest of the request body to |cb| as a whole, once it is
+  // received.  If it is longer than |limit| bytes, |cb| gets
+  // boost::asio::error::message_size instead, and the body is
+  // discarded, including what is received after that.
+  void async_read_all(std::size_t limit, read_cb cb) const;
+
+#ifdef BOOST_ASIO_HAS_CO_AWAIT
+  // Same as async_read_some(), as an asynchronous operation.  By
+  // default, it is awaitable: co_await req.read_some() returns the
+  // data, and throws boost::system::system_error on error.
+  template <typename CompletionToken = boost::asio::use_awaitable_t<>>
+  auto read_some(CompletionToken &&token = CompletionToken{}) const {
+    return boost::asio::async_initiate<
+        CompletionToken, void(boost::system::error_code, std::string)>(
+        [this](auto handler) { async_read_some(wrap(std::move(handler))); },
+        token);
+  }
+
+  // Same as async_read_all(), as an asynchronous operation.
+  template <typename CompletionToken = boost::asio::use_awaitable_t<>>
+  auto read_all(std::size_t limit,
+                CompletionToken &&token = CompletionToken{}) const {
+    return boost::asio::async_initiate<
+        CompletionToken, void(boost::system::error_code, std::string)>(
+        [this, limit](auto handler) {
+          async_read_all(limit, wrap(std::move(handler)));
+        },
+        token);
+  }
+#endif // BOOST_ASIO_HAS_CO_AWAIT
+
   // Application must not call this directly.
   request_impl &impl() const;
 
@@ -66,15 +144,56 @@ public:
   const boost::asio::ip::tcp::endpoint &remote_endpoint() const;
 
 private:
-  std::unique_ptr<request_impl> impl_;
+  // Returns read_cb invoking |handler|, which may be move-only.
+  template <typename Handler> static read_cb wrap(Handler handler) {
+    auto h = std::make_shared<Handler>(std::move(handler));
+    return [h](const boost::system::error_code &ec, std::string data) {
+      std::move(*h)(ec, std::move(data));
+    };
+  }
+
+  // Lives next to this object, in the same stream.
+  request_impl *impl_;
+};
+
+// A response built once, to be sent any number of times with
+// response::end(), from any thread.  Its header fields and body are
+// handed to nghttp2 by reference, so sending it neither copies nor
+// allocates them.  content-length is added unless |h| has it or
+// |status_code| has no body.  The date header field is still added
+// to each response.  Copies share the same data.
+class NGHTTP2_ASIO_EXPORT prebuilt_response {
+public:
+  explicit prebuilt_response(unsigned int status_code,
+                             header_map h = header_map{},
+                             std::string body = "");
+  ~prebuilt_response();
+
+  // Returns status code.
+  unsigned int status_code() const;
+
+  // Returns header fields, including content-length.
+  const header_map &header() const;
+
+  // Returns body.
+  const std::string &body() const;
+
+  // Application must not call this directly.
+  const std::shared_ptr<const prebuilt_response_impl> &impl() const;
+
+private:
+  std::shared_ptr<const prebuilt_response_impl> impl_;
 };
 
 class NGHTTP2_ASIO_EXPORT response {
 public:
   // Application must not call this directly.
-  response();
+  explicit response(response_impl &impl);
   ~response();
 
+  response(const response &) = delete;
+  response &operator=(const response &) = delete;
+
   // Write response header using |status_code| (e.g., 200) and
   // additional header fields in |h|.
   void write_head(unsigned int status_code, header_map h = header_map{}) const;
@@ -87,6 +206,23 @@ public:
   // call of end() is allowed.
   void end(generator_cb cb) const;
 
+  // Sends the buffers of |body| as response body, without copying
+  // them.  No further call of end() is allowed.
+  void end(buffer_chain body) const;
+
+  // Sends |length| bytes of the file |fd|, starting at |offset|, as
+  // response body; if |length| is -1, up to the end of the file.  On
+  // cleartext connections, the contents of a regular file are passed
+  // from the page cache to the socket with sendfile(2), without being
+  // copied in userspace.  Other files are read until EOF.  |fd| is
+  // closed when the response is finished.  No further call of end()
+  // is allowed.
+  void end_file(int fd, int64_t offset = 0, int64_t length = -1) const;
+
+  // Sends |r| as the whole response, in place of write_head() and
+  // end().  No further call of write_head() or end() is allowed.
+  void end(const prebuilt_response &r) const;
+
   // Write trailer part.  This must be called after setting both
   // NGHTTP2_DATA_FLAG_EOF and NGHTTP2_DATA_FLAG_NO_END_STREAM set in
   // *data_flag parameter in generator_cb passed to end() function.
@@ -103,6 +239,61 @@ public:
   // Resumes deferred response.
   void resume() const;
 
+  // Appends |data| to the response body, and invokes |cb| from the
+  // executor of the response once nghttp2 took all of it, which
+  // waits for the client to give flow control credit.  Unlike end(),
+  // the body is left open for more writes, until async_finish().  If
+  // write_head() was not called, the status code is 200.  This and
+  // async_finish() must be called from the executor of the response,
+  // and only one of them may be pending at a time.  If the stream is
+  // closed first, |cb| gets boost::asio::error::operation_aborted, and
+  // the request and response must not be accessed any more.
+  void async_write(std::string data, write_cb cb) const;
+
+  // Same as above, but the buffers of |data| are sent without copying.
+  void async_write(buffer_chain data, write_cb cb) const;
+
+  // Ends the response body, and invokes |cb| when the stream is
+  // closed.  The request and response must not be accessed after
+  // that.
+  void async_finish(write_cb cb) const;
+
+#ifdef BOOST_ASIO_HAS_CO_AWAIT
+  // Same as async_write(), as an asynchronous operation.  By default,
+  // it is awaitable: co_await res.write(data) suspends until the data
+  // is taken, and throws boost::system::system_error on error.
+  template <typename CompletionToken = boost::asio::use_awaitable_t<>>
+  auto write(std::string data,
+             CompletionToken &&token = CompletionToken{}) const {
+    return boost::asio::async_initiate<CompletionToken,
+                                       void(boost::system::error_code)>(
+        [this](auto handler, std::string data) {
+          async_write(std::move(data), wrap(std::move(handler)));
+        },
+        token, std::move(data));
+  }
+
+  template <typename CompletionToken = boost::asio::use_awaitable_t<>>
+  auto write(buffer_chain data,
+             CompletionToken &&token = CompletionToken{}) const {
+    return boost::asio::async_initiate<CompletionToken,
+                                       void(boost::system::error_code)>(
+        [this](auto handler, buffer_chain data) {
+          async_write(std::move(data), wrap(std::move(handler)));
+        },
+        token, std::move(data));
+  }
+
+  // Same as async_finish(), as an asynchronous operation.
+  template <typename CompletionToken = boost::asio::use_awaitable_t<>>
+  auto finish(CompletionToken &&token = CompletionToken{}) const {
+    return boost::asio::async_initiate<CompletionToken,
+                                       void(boost::system::error_code)>(
+        [this](auto handler) { async_finish(wrap(std::move(handler))); },
+        token);
+  }
+#endif // BOOST_ASIO_HAS_CO_AWAIT
+
   // Pushes resource denoted by |raw_path_query| using |method|.  The
   // additional header fields can be given in |h|.  This function
   // returns pointer to response object for promised stream, otherwise
@@ -121,8 +312,21 @@ public:
   // Application must not call this directly.
   response_impl &impl() const;
 
+  // Application must not call this directly.  Returns the completion
+  // handler of the coroutine of co_handler(), which resets the stream
+  // if it is still open, the coroutine threw, and the response is not
+  // complete.
+  std::function<void(std::exception_ptr)> on_exception() const;
+
 private:
-  std::unique_ptr<response_impl> impl_;
+  // Returns write_cb invoking |handler|, which may be move-only.
+  template <typename Handler> static write_cb wrap(Handler handler) {
+    auto h = std::make_shared<Handler>(std::move(handler));
+    return [h](const boost::system::error_code &ec) { std::move(*h)(ec); };
+  }
+
+  // Lives next to this object, in the same stream.
+  response_impl *impl_;
 };
 
 // This is so called request callback.  Called every time request is
@@ -131,6 +335,209 @@ private:
 // the application must not access to those objects.
 typedef std::function<void(const request &, const response &)> request_cb;
 
+#ifdef BOOST_ASIO_HAS_CO_AWAIT
+// Coroutine version of request_cb, see co_handler().
+using co_request_cb = std::function<boost::asio::awaitable<void>(
+    const request &, const response &)>;
+
+// Returns request_cb which runs |cb| as a coroutine on the executor of
+// the response, for it to use request::read_some(),
+// response::write() and the like.  The request body is kept for it
+// from the start.  Exceptions thrown by |cb| end the coroutine; unless
+// it has sent the whole response by then, the stream is reset with
+// NGHTTP2_INTERNAL_ERROR.
+inline request_cb co_handler(co_request_cb cb) {
+  return [cb = std::move(cb)](const request &req, const response &res) {
+    req.keep_body();
+    boost::asio::co_spawn(res.executor(), cb(req, res), res.on_exception());
+  };
+}
+#endif // BOOST_ASIO_HAS_CO_AWAIT
+
+// Counters of an offload_pool, see offload_pool::stats().
+struct offload_stats {
+  // Number of handlers waiting for a thread.
+  std::size_t queued;
+  // Highest number of handlers which waited for a thread at the same
+  // time.
+  std::size_t max_queued;
+  // Number of handlers running.
+  std::size_t running;
+  // Total number of handlers run.
+  uint64_t executed;
+  // Total number of handlers a thread took from the queue of another
+  // one.
+  uint64_t stolen;
+  // Total number of requests answered with 503 because the queue was
+  // full.
+  uint64_t rejected;
+};
+
+class offload_pool_impl;
+
+// Threads running the handlers returned by offload_handler(), away
+// from the threads serving the connections, so that a blocking
+// handler (disk, crypto, compression) does not stall the other
+// streams of its connection.  Each thread has its own queue, and
+// takes handlers from the queues of the others when its own is empty.
+class NGHTTP2_ASIO_EXPORT offload_pool {
+public:
+  // Starts |num_threads| threads.  At most |max_queued| handlers wait
+  // for a thread; the requests which find the queue full are answered
+  // with 503.
+  explicit offload_pool(std::size_t num_threads,
+                        std::size_t max_queued = 1024);
+  // Waits for the running handlers and drops the queued ones, whose
+  // streams are reset.  Requests arriving afterwards are answered with
+  // 503.  As handlers post their responses to the executors of the
+  // server, this must be called before the server is destroyed.
+  ~offload_pool();
+
+  offload_pool(const offload_pool &) = delete;
+  offload_pool &operator=(const offload_pool &) = delete;
+
+  // Returns the counters of this pool.
+  offload_stats stats() const;
+
+  // Application must not call this directly.
+  const std::shared_ptr<offload_pool_impl> &impl() const;
+
+private:
+  std::shared_ptr<offload_pool_impl> impl_;
+};
+
+// Request passed to a handler run by an offload_pool: a copy of the
+// request, with its whole body, which may be read from any thread.
+struct offload_request {
+  std::string method;
+  uri_ref uri;
+  header_map header;
+  std::string body;
+  boost::asio::ip::tcp::endpoint remote_endpoint;
+};
+
+class offload_response_impl;
+
+// Response of a handler run by an offload_pool.  It may be used from
+// any thread: each call is posted to the executor of the stream, and
+// made on the response there unless the stream is closed by then.
+// The calls are made in the order they were made on this object.  If
+// neither end() nor cancel() was called by the time the last copy is
+// destroyed, the stream is reset.  Copies share the same state.
+class NGHTTP2_ASIO_EXPORT offload_response {
+public:
+  // Application must not call this directly.
+  explicit offload_response(std::shared_ptr<offload_response_impl> impl);
+
+  // Same as response::write_head().
+  void write_head(unsigned int status_code, header_map h = header_map{}) const;
+
+  // Same as response::end().
+  void end(std::string data = "") const;
+
+  // Same as response::end(buffer_chain).
+  void end(buffer_chain body) const;
+
+  // Same as response::end(const prebuilt_response &).
+  void end(const prebuilt_response &r) const;
+
+  // Same as response::cancel().
+  void cancel(uint32_t error_code = NGHTTP2_INTERNAL_ERROR) const;
+
+private:
+  std::shared_ptr<offload_response_impl> impl_;
+};
+
+// Handler run by an offload_pool, see offload_handler().
+using offload_request_cb =
+    std::function<void(const offload_request &, const offload_response &)>;
+
+// Returns request_cb which receives the whole request body, up to
+// |max_body| bytes, on the executor of the response, and then runs
+// |cb| on a thread of |pool|.  Requests with a larger body are
+// answered with 413.  If |cb| throws before responding, the stream is
+// reset.
+NGHTTP2_ASIO_EXPORT request_cb offload_handler(offload_pool &pool,
+                                               offload_request_cb cb,
+                                               std::size_t max_body = 1 << 20);
+
+// Kind of the ids passed to http2::thread_affinity().
+enum class affinity_kind {
+  // CPU numbers, as used by sched_setaffinity(2).
+  cpu,
+  // NUMA node numbers, as listed under /sys/devices/system/node.
+  numa_node,
+};
+
+// Connection counters of a server, see http2::stats().
+struct server_stats {
+  // Number of connections currently open.
+  std::size_t active_connections;
+  // Number of accept operations currently paused because
+  // max_connections() is reached.
+  std::size_t paused_accepts;
+  // Total number of connections accepted.
+  uint64_t accepted_connections;
+  // Total number of connections closed right after being accepted
+  // because max_connections() was reached.
+  uint64_t rejected_connections;
+  // Total number of times an accept operation was paused.
+  uint64_t accept_pauses;
+  // Number of closed connection objects kept for reuse, see
+  // http2::connection_pool_size().
+  std::size_t pooled_connections;
+  // Total number of connections which reused a pooled object, and
+  // which needed a new one because the pool was empty.
+  uint64_t pool_hits;
+  uint64_t pool_misses;
+};
+
+// HTTP/2 settings the server sends to each client, and options of its
+// nghttp2 sessions, see http2::settings().  Fields left empty keep
+// nghttp2's defaults.
+struct server_settings {
+  // SETTINGS_MAX_CONCURRENT_STREAMS.  Defaults to 100, or to
+  // SERVER_MAX_CONCURRENT_STREAMS if the library was built with it.
+  std::optional<uint32_t> max_concurrent_streams;
+  // SETTINGS_INITIAL_WINDOW_SIZE: flow control window of each stream,
+  // which bounds the request body a client may send before the server
+  // reads it.  At most 2^31-1.
+  std::optional<uint32_t> initial_window_size;
+  // Flow control window of the connection as a whole, raised from the
+  // initial 65535 right after SETTINGS.  At most 2^31-1.
+  std::optional<uint32_t> connection_window_size;
+  // SETTINGS_MAX_FRAME_SIZE: largest frame payload the server
+  // accepts, between 2^14 and 2^24-1.
+  std::optional<uint32_t> max_frame_size;
+  // SETTINGS_HEADER_TABLE_SIZE: size of the HPACK table decoding
+  // request header fields.
+  std::optional<uint32_t> header_table_size;
+  // SETTINGS_MAX_HEADER_LIST_SIZE: advisory limit of the size of the
+  // request header fields.
+  std::optional<uint32_t> max_header_list_size;
+  // Upper bound of the HPACK table encoding response header fields,
+  // whatever size the client allows.  Smaller tables use less memory
+  // per connection but compress worse.
+  std::optional<std::size_t> max_deflate_dynamic_table_size;
+  // If false, streams are forgotten as soon as they close, instead of
+  // being kept around for the priority tree.  This saves memory on
+  // connections with many short streams.
+  std::optional<bool> keep_closed_streams;
+  // If true, the client gets credit for the request body it sent, in
+  // WINDOW_UPDATE frames, only after the request's on_data()
+  // callback has been called with it, and not while the request is
+  // paused (see request::pause()).  A slow consumer can then pause the
+  // request instead of buffering whatever the client sends.
+  std::optional<bool> manual_flow_control;
+  // If set, the stream and connection windows start at their initial
+  // sizes above and are then tuned to the bandwidth-delay product of
+  // each connection, measured with PINGs, up to this size.  This lets
+  // clients far away upload at full speed without giving every
+  // connection large windows.  At most 2^31-1.  Their sum over the
+  // process is bounded by auto_window_budget().
+  std::optional<uint32_t> max_auto_window_size;
+};
+
 class http2_impl;
 
 class NGHTTP2_ASIO_EXPORT http2 {
@@ -197,23 +604,124 @@ public:
   // It defaults to 1.
   void num_threads(size_t num_threads);
 
+  // Enables sharded mode if |sharded| is true.  Instead of sharing one
+  // io_context between all threads, each of the num_threads() threads
+  // runs its own io_context and listens on its own SO_REUSEPORT
+  // socket.  The kernel distributes incoming connections among the
+  // threads, and a connection is served by the thread which accepted
+  // it for its entire lifetime.  listen_and_serve() fails with
+  // operation_not_supported if the platform lacks SO_REUSEPORT.  It
+  // defaults to false.
+  void sharded(bool sharded);
+
+  // Pins the worker threads.  Thread i is bound to
+  // |ids|[i % |ids|.size()], which is a CPU number or a NUMA node
+  // number depending on |kind|.  A thread pinned to a NUMA node may
+  // run on any CPU of that node and prefers memory from it.  Combined
+  // with sharded(true), the connection objects, their buffers and
+  // nghttp2 sessions are all allocated by the thread serving them, and
+  // hence on its node.  listen_and_serve() fails with invalid_argument
+  // if an id is not valid, and with operation_not_supported if the
+  // platform cannot pin threads.  By default threads are not pinned.
+  void thread_affinity(std::vector<int> ids,
+                       affinity_kind kind = affinity_kind::cpu);
+
   // Sets the maximum length to which the queue of pending
   // connections.
   void backlog(int backlog);
 
+  // Sets the number of accept operations kept pending on each
+  // listening socket, so that several threads can set up new
+  // connections at the same time.  It defaults to 1.
+  void pending_accepts(std::size_t n);
+
+  // Sets the maximum number of connections accepted at once.  When an
+  // accept completes, the connections already waiting in the listen
+  // queue are accepted too, up to |n| in total, before going back to
+  // the event loop.  This empties the queue faster when many clients
+  // connect at once.  It defaults to 1.
+  void accept_batch(std::size_t n);
+
+  // Sets the maximum number of connections open at the same time.
+  // When it is reached, the server stops accepting, leaving new
+  // clients in the listen queue, and resumes as connections close.  A
+  // connection which slips past the limit, e.g. because several
+  // accepts were pending, is closed right away.  0 means no limit,
+  // which is the default.
+  void max_connections(std::size_t n);
+
+  // Sets the maximum number of closed connection objects kept per
+  // io_context, i.e. per thread in sharded mode, for reuse by the next
+  // connections, which then skip allocating their socket, buffers and
+  // HTTP/2 handler.  This helps with many short-lived connections.
+  // Only cleartext connections and kTLS connections (see ktls()) are
+  // pooled.  0 disables the pool, which is the default.
+  void connection_pool_size(std::size_t n);
+
+  // Sets the HTTP/2 settings and session options of the connections.
+  // Values out of the ranges documented in server_settings are
+  // clamped.  Must be called before listen_and_serve(); the server
+  // takes a copy of them when it starts.
+  void settings(const server_settings &s);
+
+  // Returns the connection counters of the running server.
+  server_stats stats() const;
+
   // Sets TLS handshake timeout, which defaults to 60 seconds.
   void tls_handshake_timeout(const std::chrono::microseconds&t);
 
   // Sets read timeout, which defaults to 60 seconds.
   void read_timeout(const std::chrono::microseconds &t);
 
+  // Sets the bounds of the per connection read buffer.  The buffer
+  // starts at |min| bytes and doubles, up to |max| bytes, whenever a
+  // read fills it; it halves again after a few reads which use less
+  // than a quarter of it.  Passing the same value twice gives a fixed
+  // size buffer.  They default to 8 KiB and 64 KiB.
+  void read_buffer_size(std::size_t min, std::size_t max);
+
+  // If |f| is true, after a read completes the connection keeps
+  // reading whatever the socket already has, without going back to
+  // the event loop, until the socket would block (at most 16 reads),
+  // and then writes the responses to all of it at once.  This saves
+  // event loop round trips for busy connections.  It defaults to
+  // false.
+  void drain_reads(bool f);
+
+  // If |f| is true, OpenSSL is asked to hand the TLS record layer over
+  // to the kernel (kTLS) once the handshake of a TLS connection is
+  // done.  Responses are then encrypted by the kernel, and file bodies
+  // sent with response::end_file() go out with sendfile(2) like on
+  // cleartext connections.  This needs OpenSSL 3 built with kTLS
+  // support, the Linux tls module and a cipher the kernel implements
+  // in both directions; otherwise the connection keeps encrypting in
+  // userspace.  It defaults to false.
+  void ktls(bool f);
+
+  // If |f| is true, request header fields are not copied out of the
+  // buffers nghttp2 decoded them into.  Those buffers are kept alive
+  // until the stream closes instead, and request::fields() points into
+  // them, so that fields the handler never reads cost no copy.
+  // request::header() still copies the fields, on first use.  It
+  // defaults to false.
+  void header_refs(bool f);
+
   // Gracefully stop http2 server
   void stop();
 
+  // Drains the server: stops accepting, sends GOAWAY on every
+  // connection and lets the requests already received complete.  Each
+  // connection closes once its streams are done, and connections still
+  // open after |deadline| are closed.  The worker threads stop when no
+  // connection is left; call join() to wait for that.  Unlike stop(),
+  // in-flight requests are not cut off.
+  void shutdown(const std::chrono::microseconds &deadline);
+
   // Join on http2 server and wait for it to fully stop
   void join();
 
-  // Get access to the io_context objects.
+  // Get access to the io_context objects.  In sharded mode, this
+  // returns the io_context of the first thread.
   boost::asio::io_context & executor() const;
 
   // Returns a vector with the ports in use
@@ -238,6 +746,9 @@ NGHTTP2_ASIO_EXPORT request_cb redirect_handler(int status_code, std::string uri
 // including message about status code.
 NGHTTP2_ASIO_EXPORT request_cb status_handler(int status_code);
 
+// Returns request handler to reply with |r|.
+NGHTTP2_ASIO_EXPORT request_cb prebuilt_handler(prebuilt_response r);
+
 } // namespace server
 
 } // namespace asio_http2
@@ -0,0 +1,95 @@
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <nghttp2/asio_http2_client.h>
+#include <nghttp2/asio_http2_server.h>
+
+namespace {
+namespace atest {
+
+struct Fixture {
+  Fixture() {
+    server.num_threads(2);
+    server.pending_accepts(2);
+    server.accept_batch(8);
+    server.handle("/", [](const nghttp2::asio_http2::server::request&, const nghttp2::asio_http2::server::response& res) {
+      res.write_head(200);
+      res.end("Ok");
+    });
+
+    std::cout << "Starting HTTP/2 server accepting in batches on localhost:3020\n";
+    boost::system::error_code ec;
+    if (server.listen_and_serve(ec, "localhost", "3020", true)) {
+      std::cerr << "error: " << ec.message() << std::endl;
+    }
+  }
+
+  ~Fixture() {
+    std::cout << "Stopping batch accepting server\n";
+    server.stop();
+    server.join();
+  }
+
+  mutable nghttp2::asio_http2::server::http2 server;
+};
+
+// Connects |n| clients at once, each on its own connection, and
+// returns the number of them which got a response.
+int burst(int n) {
+  boost::asio::io_context ioc;
+  auto sessions = std::vector<std::unique_ptr<nghttp2::asio_http2::client::session>>{};
+  auto served = 0;
+
+  for (auto i = 0; i < n; ++i) {
+    sessions.push_back(std::make_unique<nghttp2::asio_http2::client::session>(ioc, "localhost", "3020"));
+    auto& s = *sessions.back();
+    s.on_connect([&s, &served](const boost::asio::ip::tcp::endpoint&) {
+      boost::system::error_code ec;
+      auto req = s.submit(ec, "GET", "http://localhost:3020/");
+      if (ec) {
+        std::cerr << ec.message() << std::endl;
+        s.shutdown();
+        return;
+      }
+
+      auto body = std::make_shared<std::string>();
+      req->on_response([body](const nghttp2::asio_http2::client::response& res) {
+        res.on_data([body](const uint8_t* data, std::size_t length) { body->append(reinterpret_cast<const char*>(data), length); });
+      });
+      req->on_close([&s, &served, body](uint32_t) {
+        if (*body == "Ok") ++served;
+        s.shutdown();
+      });
+    });
+    s.on_error([](const boost::system::error_code& ec) { std::cerr << "error: " << ec.message() << std::endl; });
+  }
+
+  ioc.run();
+  return served;
+}
+
+}
+}
+
+TEST_CASE_PERSISTENT_FIXTURE(atest::Fixture, "Testing batched accepts", "[accept]") {
+  GIVEN("A server accepting up to 8 connections at once on localhost:3020") {
+    const auto baseline = server.stats();
+
+    WHEN("Many clients connect at the same time") {
+      CHECK(atest::burst(200) == 200);
+
+      const auto stats = server.stats();
+      CHECK(stats.accepted_connections == baseline.accepted_connections + 200);
+      CHECK(stats.rejected_connections == baseline.rejected_connections);
+
+      // The server closes its side once the clients are gone.
+      for (auto i = 0; i < 100 && server.stats().active_connections != 0; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds{20});
+      }
+      CHECK(server.stats().active_connections == 0);
+    }
+  }
+}
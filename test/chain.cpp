@@ -0,0 +1,199 @@
+#include <catch2/catch_test_macros.hpp>
+#include <atomic>
+#include <cstring>
+#include <format>
+#include <iostream>
+#include <nghttp2/asio_http2_client.h>
+#include <nghttp2/asio_http2_server.h>
+
+namespace {
+namespace ctest {
+
+std::atomic<int> released{0};
+
+std::string large(std::size_t n, char first) {
+  auto s = std::string(n, '\0');
+  for (std::size_t i = 0; i < s.size(); ++i) s[i] = static_cast<char>(first + i % 26);
+  return s;
+}
+
+// The response body as sent by /chain.
+std::string expected() {
+  auto s = std::string{"["};
+  for (auto i = 0; i < 100; ++i) s.append(large(1'000, 'a'));
+  s.append(large(50'000, 'A'), 100, 20'000);
+  s.append(large(30'000, 'a'));
+  s.append("]");
+  return s;
+}
+
+struct Fixture {
+  Fixture() : shared{std::make_shared<std::byte[]>(50'000)}, external{large(30'000, 'a')} {
+    const auto s = large(50'000, 'A');
+    std::memcpy(shared.get(), s.data(), s.size());
+
+    server.num_threads(2);
+    server.handle("/chain", [this](const nghttp2::asio_http2::server::request&, const nghttp2::asio_http2::server::response& res) {
+      auto body = nghttp2::asio_http2::buffer_chain{};
+      body.append(std::string{"["});
+      auto parts = std::vector<std::string>{};
+      for (auto i = 0; i < 100; ++i) parts.push_back(large(1'000, 'a'));
+      body.append(std::move(parts));
+      body.append(shared, 100, 20'000);
+      body.append(boost::asio::buffer(external), [] { ++released; });
+      body.append(std::string{"]"});
+
+      res.write_head(200, {{"content-length", {std::to_string(body.size()), false}}});
+      res.end(std::move(body));
+    });
+    // Overwrites the external buffer as soon as it is released, so
+    // that bytes sent after the release would show.
+    server.handle("/scribble", [](const nghttp2::asio_http2::server::request&, const nghttp2::asio_http2::server::response& res) {
+      auto data = std::make_shared<std::string>(large(500'000, 'a'));
+      auto body = nghttp2::asio_http2::buffer_chain{};
+      body.append(boost::asio::buffer(*data), [data] {
+        std::memset(data->data(), '#', data->size());
+        ++released;
+      });
+
+      res.write_head(200);
+      res.end(std::move(body));
+    });
+    server.handle("/echo", [](const nghttp2::asio_http2::server::request& req, const nghttp2::asio_http2::server::response& res) {
+      auto data = std::make_shared<std::string>();
+      req.on_data([data, &res](const uint8_t* d, std::size_t n) {
+        if (n) {
+          data->append(reinterpret_cast<const char*>(d), n);
+          return;
+        }
+        res.write_head(200);
+        res.end(std::move(*data));
+      });
+    });
+
+    std::cout << "Starting HTTP/2 server on localhost:3013\n";
+    boost::system::error_code ec;
+    if (server.listen_and_serve(ec, "localhost", "3013", true)) {
+      std::cerr << "error: " << ec.message() << std::endl;
+    }
+  }
+
+  ~Fixture() {
+    std::cout << "Stopping buffer chain server\n";
+    server.stop();
+    server.join();
+  }
+
+  std::shared_ptr<std::byte[]> shared;
+  std::string external;
+  mutable nghttp2::asio_http2::server::http2 server;
+};
+
+struct result {
+  int status = 0;
+  std::string body;
+  std::string content_length;
+};
+
+result response(std::string_view path, nghttp2::asio_http2::buffer_chain* data = nullptr) {
+  boost::asio::io_context ioc;
+  auto res = result{};
+
+  auto s = nghttp2::asio_http2::client::session{ioc, "localhost", "3013"};
+  s.on_connect([&s, &res, path, data](const boost::asio::ip::tcp::endpoint&) {
+    boost::system::error_code ec;
+    const auto uri = std::format("http://localhost:3013{}", path);
+    auto req = data ? s.submit(ec, "POST", uri, std::move(*data)) : s.submit(ec, "GET", uri);
+    if (ec) {
+      std::cerr << ec.message() << std::endl;
+      return;
+    }
+
+    req->on_response([&res](const nghttp2::asio_http2::client::response& r) {
+      res.status = r.status_code();
+      res.content_length = r.fields().value("content-length");
+      r.on_data([&res](const uint8_t* d, std::size_t length) {
+        res.body.append(reinterpret_cast<const char*>(d), length);
+      });
+    });
+
+    req->on_close([&s](uint32_t) { s.shutdown(); });
+  });
+
+  ioc.run();
+  return res;
+}
+
+}
+}
+
+TEST_CASE_PERSISTENT_FIXTURE(ctest::Fixture, "Testing buffer chain bodies", "[chain]") {
+  GIVEN("A server sending buffer chains on localhost:3013") {
+    WHEN("Requesting a response made of a buffer chain") {
+      const auto before = ctest::released.load();
+      const auto res = ctest::response("/chain");
+      const auto body = ctest::expected();
+      CHECK(res.status == 200);
+      CHECK(res.content_length == std::to_string(body.size()));
+      CHECK(res.body.size() == body.size());
+      CHECK(res.body == body);
+      CHECK(ctest::released.load() == before + 1);
+    }
+
+    AND_WHEN("Requesting a large external buffer released by the server") {
+      const auto before = ctest::released.load();
+      const auto res = ctest::response("/scribble");
+      CHECK(res.status == 200);
+      CHECK(res.body.size() == 500'000);
+      CHECK(res.body == ctest::large(500'000, 'a'));
+      CHECK(ctest::released.load() == before + 1);
+    }
+
+    AND_WHEN("Posting a request body made of a buffer chain") {
+      auto released = 0;
+      const auto external = ctest::large(70'000, 'A');
+      {
+        auto data = nghttp2::asio_http2::buffer_chain{};
+        data.append(std::vector<std::string>{"abc", "", "def"});
+        data.append(boost::asio::buffer(external), [&released] { ++released; });
+        CHECK(data.size() == 70'006);
+
+        const auto res = ctest::response("/echo", &data);
+        CHECK(res.status == 200);
+        CHECK(res.body == "abcdef" + external);
+        CHECK(data.empty());
+      }
+      CHECK(released == 1);
+    }
+
+    AND_WHEN("Dropping a buffer chain without sending it") {
+      auto released = 0;
+      {
+        auto data = nghttp2::asio_http2::buffer_chain{};
+        data.append(boost::asio::buffer("unsent", 6), [&released] { ++released; });
+        CHECK_FALSE(data.empty());
+      }
+      CHECK(released == 1);
+    }
+
+    AND_WHEN("Reusing a buffer chain after moving it") {
+      auto data = nghttp2::asio_http2::buffer_chain{};
+      data.append(std::string{"first"});
+      auto moved = std::move(data);
+      CHECK(moved.size() == 5);
+      CHECK(data.empty());
+      data.append(std::string{"second"});
+      CHECK(data.size() == 6);
+
+      auto assigned = nghttp2::asio_http2::buffer_chain{};
+      assigned = std::move(data);
+      CHECK(assigned.size() == 6);
+      data.append(std::string{"third"});
+      CHECK(data.size() == 5);
+
+      const auto res = ctest::response("/echo", &data);
+      CHECK(res.status == 200);
+      CHECK(res.body == "third");
+    }
+  }
+}
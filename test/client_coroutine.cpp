@@ -0,0 +1,228 @@
+#include <atomic>
+#include <boost/asio/bind_cancellation_slot.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <format>
+#include <iostream>
+#include <nghttp2/asio_http2_client.h>
+#include <nghttp2/asio_http2_server.h>
+#include <thread>
+
+namespace {
+namespace clientco {
+
+using nghttp2::asio_http2::client::session;
+
+std::string large(std::size_t n) {
+  auto s = std::string(n, '\0');
+  for (std::size_t i = 0; i < s.size(); ++i) s[i] = static_cast<char>('a' + i % 26);
+  return s;
+}
+
+struct Fixture {
+  Fixture() {
+    server.num_threads(2);
+    server.handle("/echo", [](const nghttp2::asio_http2::server::request& req, const nghttp2::asio_http2::server::response& res) {
+      auto data = std::make_shared<std::string>();
+      req.on_data([data, &res](const uint8_t* d, std::size_t n) {
+        if (n) {
+          data->append(reinterpret_cast<const char*>(d), n);
+          return;
+        }
+        res.write_head(200, {{"x-length", {std::to_string(data->size()), false}}});
+        res.end(std::move(*data));
+      });
+    });
+    server.handle("/large", [](const nghttp2::asio_http2::server::request&, const nghttp2::asio_http2::server::response& res) {
+      const auto data = large(200'000);
+      res.write_head(200, {{"content-length", {std::to_string(data.size()), false}}});
+      res.end(data);
+    });
+    // Never responds, until the request is cancelled.
+    server.handle("/hang", [this](const nghttp2::asio_http2::server::request&, const nghttp2::asio_http2::server::response& res) {
+      res.on_close([this](uint32_t error_code) { hang_closed = static_cast<int>(error_code); });
+    });
+
+    std::cout << "Starting HTTP/2 server on localhost:3015\n";
+    boost::system::error_code ec;
+    if (server.listen_and_serve(ec, "localhost", "3015", true)) {
+      std::cerr << "error: " << ec.message() << std::endl;
+    }
+  }
+
+  ~Fixture() {
+    std::cout << "Stopping client coroutine server\n";
+    server.stop();
+    server.join();
+  }
+
+  mutable nghttp2::asio_http2::server::http2 server;
+  // The error code with which the last /hang stream was closed.
+  std::atomic<int> hang_closed{-1};
+};
+
+std::string uri(std::string_view path) { return std::format("http://localhost:3015{}", path); }
+
+// Runs |f| as a coroutine with a session connected to the server, and
+// rethrows what it threw.
+template <typename F>
+void run(F f) {
+  boost::asio::io_context ioc;
+  auto s = session{ioc, "localhost", "3015"};
+  auto error = std::exception_ptr{};
+
+  boost::asio::co_spawn(
+      ioc,
+      [&s, f]() -> boost::asio::awaitable<void> {
+        co_await s.wait_connected();
+        co_await f(s);
+      },
+      [&s, &error](std::exception_ptr e) {
+        error = e;
+        s.shutdown();
+      });
+
+  ioc.run();
+  if (error) std::rethrow_exception(error);
+}
+
+}
+}
+
+TEST_CASE_PERSISTENT_FIXTURE(clientco::Fixture, "Testing client coroutines", "[client_coroutine]") {
+  GIVEN("A server on localhost:3015") {
+    WHEN("Awaiting a response and reading all of its body") {
+      auto status = 0;
+      auto length = int64_t{};
+      auto body = std::string{};
+      clientco::run([&](const clientco::session& s) -> boost::asio::awaitable<void> {
+        auto r = co_await s.async_submit("GET", clientco::uri("/large"));
+        status = r.status_code();
+        length = r.content_length();
+        body = co_await r.read_all(1'000'000);
+      });
+      CHECK(status == 200);
+      CHECK(length == 200'000);
+      CHECK(body == clientco::large(200'000));
+    }
+
+    AND_WHEN("Reading a response body piece by piece") {
+      auto body = std::string{};
+      auto reads = 0;
+      clientco::run([&](const clientco::session& s) -> boost::asio::awaitable<void> {
+        auto r = co_await s.async_submit("POST", clientco::uri("/echo"), clientco::large(100'000));
+        CHECK(r.header().find("x-length")->second.value == "100000");
+        for (;;) {
+          auto data = co_await r.read_some();
+          if (data.empty()) break;
+          body += data;
+          ++reads;
+        }
+      });
+      CHECK(body == clientco::large(100'000));
+      CHECK(reads >= 1);
+    }
+
+    AND_WHEN("Reading a response body over the limit") {
+      auto ec = boost::system::error_code{};
+      clientco::run([&](const clientco::session& s) -> boost::asio::awaitable<void> {
+        auto r = co_await s.async_submit("GET", clientco::uri("/large"));
+        try {
+          co_await r.read_all(1'000);
+        } catch (const boost::system::system_error& e) {
+          ec = e.code();
+        }
+      });
+      CHECK(ec == boost::asio::error::message_size);
+    }
+
+    AND_WHEN("Streaming a request body") {
+      auto status = 0;
+      auto body = std::string{};
+      auto expected = std::string{};
+      clientco::run([&](const clientco::session& s) -> boost::asio::awaitable<void> {
+        boost::system::error_code ec;
+        auto req = s.submit_streaming(ec, "POST", clientco::uri("/echo"));
+        REQUIRE_FALSE(ec);
+        auto r = req->reader();
+        for (auto i = 0; i < 10; ++i) {
+          auto data = clientco::large(30'000 + i);
+          expected += data;
+          co_await req->write(std::move(data));
+        }
+        auto chain = nghttp2::asio_http2::buffer_chain{};
+        chain.append(std::string{"end."});
+        expected += "end.";
+        co_await req->write(std::move(chain));
+        co_await req->finish();
+
+        co_await r.read_header();
+        status = r.status_code();
+        body = co_await r.read_all(1'000'000);
+      });
+      CHECK(status == 200);
+      CHECK(body.size() == expected.size());
+      CHECK(body == expected);
+    }
+
+    AND_WHEN("Cancelling a request while awaiting its response") {
+      auto ec = boost::system::error_code{};
+      clientco::run([&](const clientco::session& s) -> boost::asio::awaitable<void> {
+        boost::system::error_code sec;
+        auto req = s.submit(sec, "GET", clientco::uri("/hang"));
+        REQUIRE_FALSE(sec);
+        auto r = req->reader();
+        boost::asio::post(s.executor(), [r] { r.cancel(); });
+        try {
+          co_await r.read_header();
+        } catch (const boost::system::system_error& e) {
+          ec = e.code();
+        }
+      });
+      CHECK(ec == boost::asio::error::operation_aborted);
+    }
+
+    AND_WHEN("Cancelling a request through the slot of its completion handler") {
+      hang_closed = -1;
+      auto ec = boost::system::error_code{};
+      auto completed = false;
+      boost::asio::io_context ioc;
+      auto s = clientco::session{ioc, "localhost", "3015"};
+      auto signal = boost::asio::cancellation_signal{};
+      auto timer = boost::asio::steady_timer{ioc};
+      s.on_connect([&](const boost::asio::ip::tcp::endpoint&) {
+        s.async_submit("GET", clientco::uri("/hang"), nghttp2::asio_http2::header_map{},
+                       boost::asio::bind_cancellation_slot(
+                           signal.slot(), [&](const boost::system::error_code& e, nghttp2::asio_http2::client::response_reader) {
+                             completed = true;
+                             ec = e;
+                             s.shutdown();
+                           }));
+        timer.expires_after(std::chrono::milliseconds(100));
+        timer.async_wait([&](const boost::system::error_code&) { signal.emit(boost::asio::cancellation_type::terminal); });
+      });
+      ioc.run();
+      CHECK(completed);
+      CHECK(ec == boost::asio::error::operation_aborted);
+
+      // The server sees the stream reset.
+      for (auto i = 0; i < 200 && hang_closed == -1; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      }
+      CHECK(hang_closed == NGHTTP2_CANCEL);
+    }
+
+    AND_WHEN("Submitting a request with an invalid uri") {
+      auto ec = boost::system::error_code{};
+      clientco::run([&](const clientco::session& s) -> boost::asio::awaitable<void> {
+        try {
+          co_await s.async_submit("GET", "not a uri");
+        } catch (const boost::system::system_error& e) {
+          ec = e.code();
+        }
+      });
+      CHECK(ec == boost::system::errc::invalid_argument);
+    }
+  }
+}
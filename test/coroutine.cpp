@@ -0,0 +1,191 @@
+#include <catch2/catch_test_macros.hpp>
+#include <format>
+#include <iostream>
+#include <nghttp2/asio_http2_client.h>
+#include <nghttp2/asio_http2_server.h>
+
+namespace {
+namespace cotest {
+
+using nghttp2::asio_http2::server::request;
+using nghttp2::asio_http2::server::response;
+
+std::string large(std::size_t n) {
+  auto s = std::string(n, '\0');
+  for (std::size_t i = 0; i < s.size(); ++i) s[i] = static_cast<char>('a' + i % 26);
+  return s;
+}
+
+boost::asio::awaitable<void> echo(const request& req, const response& res) {
+  res.write_head(200);
+  for (;;) {
+    auto data = co_await req.read_some();
+    if (data.empty()) break;
+    co_await res.write(std::move(data));
+  }
+  co_await res.finish();
+}
+
+boost::asio::awaitable<void> all(const request& req, const response& res) {
+  try {
+    const auto data = co_await req.read_all(1'000);
+    res.write_head(200);
+    co_await res.write(std::format("read {} bytes", data.size()));
+  } catch (const boost::system::system_error& e) {
+    if (e.code() != boost::asio::error::message_size) throw;
+    res.write_head(413);
+  }
+  co_await res.finish();
+}
+
+boost::asio::awaitable<void> stream(const request&, const response& res) {
+  res.write_head(200, {{"content-type", {"text/plain", false}}});
+  for (auto i = 0; i < 50; ++i) {
+    co_await res.write(large(10'000));
+  }
+  auto chain = nghttp2::asio_http2::buffer_chain{};
+  chain.append(std::vector<std::string>{"end", "."});
+  co_await res.write(std::move(chain));
+  co_await res.finish();
+}
+
+// Starts a response, then throws.
+boost::asio::awaitable<void> fail(const request&, const response& res) {
+  res.write_head(200);
+  co_await res.write("partial");
+  throw std::runtime_error{"failed"};
+}
+
+// Lets the system_error of read_all() escape.
+boost::asio::awaitable<void> uncaught(const request& req, const response& res) {
+  const auto data = co_await req.read_all(1'000);
+  res.write_head(200);
+  co_await res.write(data);
+  co_await res.finish();
+}
+
+struct Fixture {
+  Fixture() {
+    server.num_threads(2);
+    server.settings({.initial_window_size = 16'384});
+    server.handle("/echo", nghttp2::asio_http2::server::co_handler(echo));
+    server.handle("/all", nghttp2::asio_http2::server::co_handler(all));
+    server.handle("/stream", nghttp2::asio_http2::server::co_handler(stream));
+    server.handle("/fail", nghttp2::asio_http2::server::co_handler(fail));
+    server.handle("/uncaught", nghttp2::asio_http2::server::co_handler(uncaught));
+
+    std::cout << "Starting HTTP/2 server on localhost:3014\n";
+    boost::system::error_code ec;
+    if (server.listen_and_serve(ec, "localhost", "3014", true)) {
+      std::cerr << "error: " << ec.message() << std::endl;
+    }
+  }
+
+  ~Fixture() {
+    std::cout << "Stopping coroutine server\n";
+    server.stop();
+    server.join();
+  }
+
+  mutable nghttp2::asio_http2::server::http2 server;
+};
+
+struct result {
+  int status = 0;
+  std::string body;
+  uint32_t error_code = 0;
+};
+
+result response(std::string_view method, std::string_view path, const std::string* data = nullptr) {
+  boost::asio::io_context ioc;
+  auto res = result{};
+
+  auto s = nghttp2::asio_http2::client::session{ioc, "localhost", "3014"};
+  s.on_connect([&s, &res, method, path, data](const boost::asio::ip::tcp::endpoint&) {
+    boost::system::error_code ec;
+    const auto uri = std::format("http://localhost:3014{}", path);
+    auto req = data ? s.submit(ec, std::string{method}, uri, *data) : s.submit(ec, std::string{method}, uri);
+    if (ec) {
+      std::cerr << ec.message() << std::endl;
+      return;
+    }
+
+    req->on_response([&res](const nghttp2::asio_http2::client::response& r) {
+      res.status = r.status_code();
+      r.on_data([&res](const uint8_t* d, std::size_t length) {
+        res.body.append(reinterpret_cast<const char*>(d), length);
+      });
+    });
+
+    req->on_close([&s, &res](uint32_t error_code) {
+      res.error_code = error_code;
+      s.shutdown();
+    });
+  });
+
+  ioc.run();
+  return res;
+}
+
+}
+}
+
+TEST_CASE_PERSISTENT_FIXTURE(cotest::Fixture, "Testing coroutine handlers", "[coroutine]") {
+  GIVEN("A server with coroutine handlers on localhost:3014") {
+    WHEN("Echoing a request body larger than the stream window") {
+      const auto data = cotest::large(300'000);
+      const auto res = cotest::response("POST", "/echo", &data);
+      CHECK(res.status == 200);
+      CHECK(res.error_code == 0);
+      CHECK(res.body.size() == data.size());
+      CHECK(res.body == data);
+    }
+
+    AND_WHEN("Echoing an empty request body") {
+      const auto res = cotest::response("GET", "/echo");
+      CHECK(res.status == 200);
+      CHECK(res.body.empty());
+    }
+
+    AND_WHEN("Reading a whole request body within the limit") {
+      const auto data = cotest::large(1'000);
+      const auto res = cotest::response("POST", "/all", &data);
+      CHECK(res.status == 200);
+      CHECK(res.body == "read 1000 bytes");
+    }
+
+    AND_WHEN("Reading a whole request body over the limit") {
+      const auto data = cotest::large(5'000);
+      const auto res = cotest::response("POST", "/all", &data);
+      CHECK(res.status == 413);
+      CHECK(res.body.empty());
+    }
+
+    AND_WHEN("The coroutine throws after starting the response") {
+      const auto res = cotest::response("GET", "/fail");
+      CHECK(res.status == 200);
+      CHECK(res.error_code == NGHTTP2_INTERNAL_ERROR);
+    }
+
+    AND_WHEN("The coroutine lets an error of read_all() escape") {
+      const auto data = cotest::large(50'000);
+      const auto res = cotest::response("POST", "/uncaught", &data);
+      CHECK(res.status == 0);
+      CHECK(res.error_code == NGHTTP2_INTERNAL_ERROR);
+    }
+
+    AND_WHEN("Streaming a response in many writes") {
+      const auto res = cotest::response("GET", "/stream");
+      CHECK(res.status == 200);
+      CHECK(res.error_code == 0);
+      CHECK(res.body.size() == 500'004);
+      CHECK(res.body.ends_with("end."));
+    }
+
+    AND_WHEN("Streaming a response to a HEAD request") {
+      const auto res = cotest::response("HEAD", "/stream");
+      CHECK(res.status == 200);
+      CHECK(res.body.empty());
+    }
+  }
+}
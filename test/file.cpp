@@ -0,0 +1,129 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cstdio>
+#include <fcntl.h>
+#include <format>
+#include <iostream>
+#include <nghttp2/asio_http2_client.h>
+#include <nghttp2/asio_http2_server.h>
+#include <unistd.h>
+
+namespace {
+namespace ftest {
+
+std::string contents() {
+  auto s = std::string(3 * 1024 * 1024 + 11, '\0');
+  for (std::size_t i = 0; i < s.size(); ++i) s[i] = static_cast<char>('a' + i % 26);
+  return s;
+}
+
+struct Fixture {
+  Fixture() : path{std::format("/tmp/nghttp2-asio-file-test-{}.bin", ::getpid())}, data{contents()} {
+    auto f = std::fopen(path.c_str(), "wb");
+    std::fwrite(data.data(), 1, data.size(), f);
+    std::fclose(f);
+
+    server.num_threads(2);
+    server.handle("/file", [this](const nghttp2::asio_http2::server::request&, const nghttp2::asio_http2::server::response& res) {
+      res.write_head(200, {{"content-type", {"application/octet-stream", false}}});
+      res.end_file(::open(path.c_str(), O_RDONLY));
+    });
+    server.handle("/range", [this](const nghttp2::asio_http2::server::request&, const nghttp2::asio_http2::server::response& res) {
+      res.write_head(200, {{"content-type", {"application/octet-stream", false}}});
+      res.end_file(::open(path.c_str(), O_RDONLY), 100'001, 1'000'000);
+    });
+
+    std::cout << "Starting HTTP/2 server on localhost:3002\n";
+    boost::system::error_code ec;
+    if (server.listen_and_serve(ec, "localhost", "3002", true)) {
+      std::cerr << "error: " << ec.message() << std::endl;
+    }
+  }
+
+  ~Fixture() {
+    std::cout << "Stopping file server\n";
+    server.stop();
+    server.join();
+    std::remove(path.c_str());
+  }
+
+  std::string path;
+  std::string data;
+  mutable nghttp2::asio_http2::server::http2 server;
+};
+
+std::string response(std::string_view path) {
+  boost::asio::io_context ioc;
+  auto response = std::string{};
+
+  auto s = nghttp2::asio_http2::client::session{ioc, "localhost", "3002"};
+  s.on_connect([&s, &response, path](const boost::asio::ip::tcp::endpoint&) {
+    boost::system::error_code ec;
+    auto req = s.submit(ec, "GET", std::format("http://localhost:3002{}", path));
+    if (ec) {
+      std::cerr << ec.message() << std::endl;
+      return;
+    }
+
+    req->on_response([&response](const nghttp2::asio_http2::client::response& res) {
+      res.on_data([&response](const uint8_t* data, std::size_t length) {
+        response.append(reinterpret_cast<const char*>(data), length);
+      });
+    });
+
+    req->on_close([&s](uint32_t) {s.shutdown();});
+  });
+
+  ioc.run();
+  return response;
+}
+
+// Requests |path|, and drops the connection without reading the rest
+// once the first bytes of the response body arrive.
+void abandon(std::string_view path) {
+  boost::asio::io_context ioc;
+
+  auto s = nghttp2::asio_http2::client::session{ioc, "localhost", "3002"};
+  s.on_connect([&s, &ioc, path](const boost::asio::ip::tcp::endpoint&) {
+    boost::system::error_code ec;
+    auto req = s.submit(ec, "GET", std::format("http://localhost:3002{}", path));
+    if (ec) {
+      std::cerr << ec.message() << std::endl;
+      return;
+    }
+
+    req->on_response([&ioc](const nghttp2::asio_http2::client::response& res) {
+      res.on_data([&ioc](const uint8_t*, std::size_t) { ioc.stop(); });
+    });
+  });
+
+  ioc.run();
+}
+
+}
+}
+
+TEST_CASE_PERSISTENT_FIXTURE(ftest::Fixture, "Testing file responses", "[file]") {
+  GIVEN("A server sending a file on localhost:3002") {
+    WHEN("Requesting the whole file") {
+      const auto body = ftest::response("/file");
+      CHECK(body.size() == data.size());
+      CHECK(body == data);
+    }
+
+    AND_WHEN("Requesting a range of the file") {
+      const auto body = ftest::response("/range");
+      CHECK(body.size() == 1'000'000);
+      CHECK(body == data.substr(100'001, 1'000'000));
+    }
+
+    AND_WHEN("The client drops connections in the middle of the file") {
+      // sendfile(2) to a closed connection raises SIGPIPE, unless it
+      // is blocked on the threads of the server.
+      for (auto i = 0; i < 20; ++i) {
+        ftest::abandon("/file");
+      }
+      const auto body = ftest::response("/file");
+      CHECK(body == data);
+    }
+  }
+}
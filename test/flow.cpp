@@ -0,0 +1,162 @@
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <format>
+#include <iostream>
+#include <memory>
+#include <boost/asio/steady_timer.hpp>
+#include <nghttp2/asio_http2_client.h>
+#include <nghttp2/asio_http2_server.h>
+
+namespace {
+namespace fctest {
+
+constexpr std::size_t window = 64 * 1024;
+
+struct Fixture {
+  Fixture() {
+    auto settings = nghttp2::asio_http2::server::server_settings{};
+    settings.manual_flow_control = true;
+    settings.initial_window_size = window;
+
+    server.num_threads(2);
+    server.settings(settings);
+    // Pauses the request on its first chunk, and resumes it after a
+    // while.  Replies with the bytes received while paused, and in
+    // total.
+    server.handle("/upload", [](const nghttp2::asio_http2::server::request& req, const nghttp2::asio_http2::server::response& res) {
+      struct state {
+        std::size_t total = 0;
+        std::size_t paused = 0;
+        bool resumed = false;
+        std::unique_ptr<boost::asio::steady_timer> timer;
+      };
+      auto st = std::make_shared<state>();
+      req.on_data([&req, &res, st](const uint8_t*, std::size_t length) {
+        if (length == 0) {
+          res.write_head(200);
+          res.end(std::format("{}|{}", st->paused, st->total));
+          return;
+        }
+
+        st->total += length;
+        if (st->resumed) return;
+        if (st->timer) {
+          st->paused += length;
+          return;
+        }
+
+        req.pause();
+        st->paused = length;
+        st->timer = std::make_unique<boost::asio::steady_timer>(res.executor(), std::chrono::milliseconds{300});
+        st->timer->async_wait([&req, st](const boost::system::error_code&) {
+          st->resumed = true;
+          req.resume();
+        });
+      });
+      res.on_close([st](uint32_t) { if (st->timer) st->timer->cancel(); });
+    });
+    // Holds the whole body back until it has been received.
+    server.handle("/all", nghttp2::asio_http2::server::co_handler(
+                              [](const nghttp2::asio_http2::server::request& req,
+                                 const nghttp2::asio_http2::server::response& res) -> boost::asio::awaitable<void> {
+                                const auto data = co_await req.read_all(2 * 1024 * 1024);
+                                res.write_head(200);
+                                co_await res.write(std::format("0|{}", data.size()));
+                                co_await res.finish();
+                              }));
+    // Answers 413 as soon as the body is over the limit.
+    server.handle("/limited", nghttp2::asio_http2::server::co_handler(
+                                  [](const nghttp2::asio_http2::server::request& req,
+                                     const nghttp2::asio_http2::server::response& res) -> boost::asio::awaitable<void> {
+                                    try {
+                                      co_await req.read_all(1'000);
+                                      res.write_head(200);
+                                    } catch (const boost::system::system_error&) {
+                                      res.write_head(413);
+                                    }
+                                    co_await res.write("413|0");
+                                    co_await res.finish();
+                                  }));
+
+    std::cout << "Starting HTTP/2 server with manual flow control on localhost:3011\n";
+    boost::system::error_code ec;
+    if (server.listen_and_serve(ec, "localhost", "3011", true)) {
+      std::cerr << "error: " << ec.message() << std::endl;
+    }
+  }
+
+  ~Fixture() {
+    std::cout << "Stopping flow control server\n";
+    server.stop();
+    server.join();
+  }
+
+  mutable nghttp2::asio_http2::server::http2 server;
+};
+
+std::string upload(const std::string& body, std::string_view path = "/upload") {
+  boost::asio::io_context ioc;
+  auto response = std::string{};
+
+  auto s = nghttp2::asio_http2::client::session{ioc, "localhost", "3011"};
+  s.on_connect([&](const boost::asio::ip::tcp::endpoint&) {
+    boost::system::error_code ec;
+    auto req = s.submit(ec, "POST", std::format("http://localhost:3011{}", path), body);
+    if (ec) {
+      std::cerr << ec.message() << std::endl;
+      return;
+    }
+
+    req->on_response([&response](const nghttp2::asio_http2::client::response& res) {
+      res.on_data([&response](const uint8_t* data, std::size_t length) {
+        response.append(reinterpret_cast<const char*>(data), length);
+      });
+    });
+    req->on_close([&s](uint32_t) { s.shutdown(); });
+  });
+
+  ioc.run();
+  return response;
+}
+
+}
+}
+
+TEST_CASE_PERSISTENT_FIXTURE(fctest::Fixture, "Testing manual flow control", "[flow]") {
+  GIVEN("A server pausing uploads on localhost:3011") {
+    WHEN("Uploading far more than the stream window") {
+      const auto body = std::string(1024 * 1024, 'x');
+      const auto res = fctest::upload(body);
+
+      const auto sep = res.find('|');
+      REQUIRE(sep != std::string::npos);
+      const auto paused = std::stoul(res.substr(0, sep));
+      const auto total = std::stoul(res.substr(sep + 1));
+
+      // The client cannot send more than a window while the request
+      // is paused.
+      CHECK(paused > 0);
+      CHECK(paused <= fctest::window);
+      CHECK(total == body.size());
+    }
+
+    AND_WHEN("Uploading again on a new connection") {
+      const auto body = std::string(300 * 1024, 'y');
+      const auto res = fctest::upload(body);
+      CHECK(res.ends_with(std::format("|{}", body.size())));
+    }
+
+    AND_WHEN("Reading a whole body far larger than the stream window") {
+      const auto body = std::string(1024 * 1024, 'z');
+      const auto res = fctest::upload(body, "/all");
+      CHECK(res == std::format("0|{}", body.size()));
+    }
+
+    AND_WHEN("Sending a body far over the limit of the reading coroutine") {
+      // The rest of the body is dropped, and credited so that the
+      // client can finish sending it.
+      const auto res = fctest::upload(std::string(1024 * 1024, 'z'), "/limited");
+      CHECK(res == "413|0");
+    }
+  }
+}
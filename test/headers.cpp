@@ -0,0 +1,114 @@
+#include <catch2/catch_test_macros.hpp>
+#include <format>
+#include <iostream>
+#include <nghttp2/asio_http2_client.h>
+#include <nghttp2/asio_http2_server.h>
+
+namespace {
+namespace htest {
+
+void echo(nghttp2::asio_http2::server::http2& server, const std::string& port) {
+  server.num_threads(2);
+  server.handle("/", [](const nghttp2::asio_http2::server::request& req, const nghttp2::asio_http2::server::response& res) {
+    const auto fields = req.fields();
+    const auto custom = fields.find("x-custom");
+    const auto map = req.header().find("x-custom");
+
+    auto body = std::format("{}|{}|{}|{}|{}",
+        fields.value("user-agent"),
+        custom ? custom->value : "",
+        custom && custom->sensitive ? "sensitive" : "",
+        map == req.header().end() ? "" : map->second.value,
+        fields.find("x-missing") == nullptr ? "missing" : "");
+    res.write_head(200, {{"content-type", {"text/plain", false}}, {"x-echo", {"echo", false}}});
+    res.end(std::move(body));
+  });
+
+  std::cout << "Starting HTTP/2 server on localhost:" << port << '\n';
+  boost::system::error_code ec;
+  if (server.listen_and_serve(ec, "localhost", port, true)) {
+    std::cerr << "error: " << ec.message() << std::endl;
+  }
+}
+
+struct Fixture {
+  Fixture() {
+    echo(server, "3007");
+    // Same, with header fields referencing nghttp2's buffers.
+    refs.header_refs(true);
+    echo(refs, "3008");
+  }
+
+  ~Fixture() {
+    std::cout << "Stopping headers servers\n";
+    server.stop();
+    server.join();
+    refs.stop();
+    refs.join();
+  }
+
+  mutable nghttp2::asio_http2::server::http2 server;
+  mutable nghttp2::asio_http2::server::http2 refs;
+};
+
+struct result {
+  std::string body;
+  std::string content_type;
+  std::string echo;
+  std::size_t fields = 0;
+};
+
+result response(const std::string& port, nghttp2::asio_http2::header_map headers) {
+  boost::asio::io_context ioc;
+  auto res = result{};
+
+  auto s = nghttp2::asio_http2::client::session{ioc, "localhost", port};
+  s.on_connect([&s, &res, &headers, &port](const boost::asio::ip::tcp::endpoint&) {
+    boost::system::error_code ec;
+    auto req = s.submit(ec, "GET", std::format("http://localhost:{}/", port), std::move(headers));
+    if (ec) {
+      std::cerr << ec.message() << std::endl;
+      return;
+    }
+
+    req->on_response([&res](const nghttp2::asio_http2::client::response& r) {
+      res.content_type = r.fields().value("content-type");
+      const auto echo = r.header().find("x-echo");
+      if (echo != r.header().end()) res.echo = echo->second.value;
+      res.fields = r.fields().size();
+      r.on_data([&res](const uint8_t* data, std::size_t length) {
+        res.body.append(reinterpret_cast<const char*>(data), length);
+      });
+    });
+
+    req->on_close([&s](uint32_t) { s.shutdown(); });
+  });
+
+  ioc.run();
+  return res;
+}
+
+}
+}
+
+TEST_CASE_PERSISTENT_FIXTURE(htest::Fixture, "Testing header fields", "[headers]") {
+  for (const auto& port : {std::string{"3007"}, std::string{"3008"}}) {
+    GIVEN(std::format("A server echoing request headers on localhost:{}", port)) {
+      WHEN("Sending known and unknown header fields") {
+        const auto res = htest::response(port, {
+            {"user-agent", {"headers-test", false}},
+            {"x-custom", {"secret", true}}});
+        CHECK(res.body == "headers-test|secret|sensitive|secret|missing");
+        CHECK(res.content_type == "text/plain");
+        CHECK(res.echo == "echo");
+        CHECK(res.fields >= 2);
+      }
+
+      AND_WHEN("Sending no extra header fields") {
+        const auto res = htest::response(port, {});
+        CHECK(res.body == "||||missing");
+        CHECK(res.content_type == "text/plain");
+      }
+    }
+  }
+}
@@ -0,0 +1,114 @@
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <nghttp2/asio_http2_client.h>
+#include <nghttp2/asio_http2_server.h>
+
+namespace {
+namespace ltest {
+
+struct Fixture {
+  Fixture() {
+    server.num_threads(2);
+    server.max_connections(2);
+    server.handle("/", [](const nghttp2::asio_http2::server::request&, const nghttp2::asio_http2::server::response& res) {
+      res.write_head(200, {{"content-type", {"text/plain", false}}});
+      res.end("Ok");
+    });
+
+    std::cout << "Starting HTTP/2 server limited to 2 connections on localhost:3003\n";
+    boost::system::error_code ec;
+    if (server.listen_and_serve(ec, "localhost", "3003", true)) {
+      std::cerr << "error: " << ec.message() << std::endl;
+    }
+  }
+
+  ~Fixture() {
+    std::cout << "Stopping limited server\n";
+    server.stop();
+    server.join();
+  }
+
+  mutable nghttp2::asio_http2::server::http2 server;
+};
+
+// A client session which keeps its connection open after its request
+// completed.
+struct client {
+  explicit client(boost::asio::io_context& ioc) : session{ioc, "localhost", "3003"} {
+    session.on_connect([this](const boost::asio::ip::tcp::endpoint&) {
+      boost::system::error_code ec;
+      auto req = session.submit(ec, "GET", "http://localhost:3003/");
+      if (ec) {
+        std::cerr << ec.message() << std::endl;
+        return;
+      }
+
+      req->on_response([this](const nghttp2::asio_http2::client::response& res) {
+        res.on_data([this](const uint8_t* data, std::size_t length) {
+          body.append(reinterpret_cast<const char*>(data), length);
+        });
+      });
+    });
+  }
+
+  nghttp2::asio_http2::client::session session;
+  std::string body;
+};
+
+void run_for(boost::asio::io_context& ioc, std::chrono::milliseconds duration) {
+  ioc.restart();
+  ioc.run_for(duration);
+}
+
+}
+}
+
+TEST_CASE_PERSISTENT_FIXTURE(ltest::Fixture, "Testing connection limit", "[limits]") {
+  GIVEN("A server limited to 2 connections on localhost:3003") {
+    // Connections of a previous run may still be closing.
+    for (auto i = 0; i < 50 && server.stats().active_connections != 0; ++i) {
+      std::this_thread::sleep_for(std::chrono::milliseconds{20});
+    }
+    const auto baseline = server.stats();
+
+    boost::asio::io_context ioc;
+
+    auto first = std::make_unique<ltest::client>(ioc);
+    auto second = std::make_unique<ltest::client>(ioc);
+    ltest::run_for(ioc, std::chrono::milliseconds{500});
+
+    WHEN("Two clients are connected") {
+      CHECK(first->body == "Ok");
+      CHECK(second->body == "Ok");
+
+      const auto stats = server.stats();
+      CHECK(stats.active_connections == 2);
+      CHECK(stats.accepted_connections == baseline.accepted_connections + 2);
+    }
+
+    AND_WHEN("A third client connects") {
+      auto third = std::make_unique<ltest::client>(ioc);
+      ltest::run_for(ioc, std::chrono::milliseconds{500});
+
+      CHECK(third->body.empty());
+      CHECK(server.stats().paused_accepts > 0);
+      CHECK(server.stats().accept_pauses > 0);
+
+      first->session.shutdown();
+      ltest::run_for(ioc, std::chrono::milliseconds{500});
+
+      CHECK(third->body == "Ok");
+      CHECK(server.stats().active_connections == 2);
+      CHECK(server.stats().accepted_connections == baseline.accepted_connections + 3);
+
+      third->session.shutdown();
+    }
+
+    first->session.shutdown();
+    second->session.shutdown();
+    ltest::run_for(ioc, std::chrono::milliseconds{200});
+  }
+}
@@ -0,0 +1,203 @@
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <format>
+#include <iostream>
+#include <thread>
+#include <nghttp2/asio_http2_client.h>
+#include <nghttp2/asio_http2_server.h>
+
+namespace {
+namespace offtest {
+
+using nghttp2::asio_http2::server::offload_request;
+using nghttp2::asio_http2::server::offload_response;
+
+struct Fixture {
+  Fixture() : pool{2}, busy{1, 1} {
+    // A single thread serves the connections, so that a handler
+    // blocking it would stall every other stream.
+    server.num_threads(1);
+    auto settings = nghttp2::asio_http2::server::server_settings{};
+    settings.manual_flow_control = true;
+    server.settings(settings);
+    server.handle("/slow", nghttp2::asio_http2::server::offload_handler(pool, [](const offload_request&, const offload_response& res) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(300));
+      res.write_head(200);
+      res.end("slow");
+    }));
+    server.handle("/fast", [](const nghttp2::asio_http2::server::request&, const nghttp2::asio_http2::server::response& res) {
+      res.write_head(200);
+      res.end("fast");
+    });
+    server.handle("/echo", nghttp2::asio_http2::server::offload_handler(pool, [](const offload_request& req, const offload_response& res) {
+      res.write_head(200, {{"x-method", {req.method, false}}, {"x-path", {req.uri.path, false}}});
+      res.end(req.body);
+    }, 10'000));
+    server.handle("/length", nghttp2::asio_http2::server::offload_handler(pool, [](const offload_request& req, const offload_response& res) {
+      res.write_head(200);
+      res.end(std::to_string(req.body.size()));
+    }));
+    server.handle("/throw", nghttp2::asio_http2::server::offload_handler(pool, [](const offload_request&, const offload_response&) {
+      throw std::runtime_error{"failed"};
+    }));
+    server.handle("/busy", nghttp2::asio_http2::server::offload_handler(busy, [](const offload_request&, const offload_response& res) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(300));
+      res.write_head(200);
+      res.end();
+    }));
+
+    std::cout << "Starting HTTP/2 server with offloaded handlers on localhost:3016\n";
+    boost::system::error_code ec;
+    if (server.listen_and_serve(ec, "localhost", "3016", true)) {
+      std::cerr << "error: " << ec.message() << std::endl;
+    }
+  }
+
+  ~Fixture() {
+    std::cout << "Stopping offload server\n";
+    server.stop();
+    server.join();
+  }
+
+  mutable nghttp2::asio_http2::server::http2 server;
+  // Destroyed before the server.
+  nghttp2::asio_http2::server::offload_pool pool;
+  nghttp2::asio_http2::server::offload_pool busy;
+};
+
+struct result {
+  int status = 0;
+  std::string body;
+  std::string method;
+  std::string path;
+  uint32_t error_code = 0;
+  // Rank in which the response ended, from 1.
+  int rank = 0;
+};
+
+struct call {
+  std::string method;
+  std::string path;
+  std::string data;
+};
+
+// Sends |calls| at once on a single connection.
+std::vector<result> responses(const std::vector<call>& calls) {
+  boost::asio::io_context ioc;
+  auto res = std::vector<result>(calls.size());
+  auto closed = std::size_t{0};
+
+  auto s = nghttp2::asio_http2::client::session{ioc, "localhost", "3016"};
+  s.on_connect([&](const boost::asio::ip::tcp::endpoint&) {
+    for (std::size_t i = 0; i < calls.size(); ++i) {
+      boost::system::error_code ec;
+      const auto uri = std::format("http://localhost:3016{}", calls[i].path);
+      auto req = s.submit(ec, calls[i].method, uri, calls[i].data);
+      if (ec) {
+        std::cerr << ec.message() << std::endl;
+        return;
+      }
+
+      auto& r = res[i];
+      req->on_response([&r](const nghttp2::asio_http2::client::response& rsp) {
+        r.status = rsp.status_code();
+        r.method = rsp.fields().value("x-method");
+        r.path = rsp.fields().value("x-path");
+        rsp.on_data([&r](const uint8_t* d, std::size_t length) {
+          r.body.append(reinterpret_cast<const char*>(d), length);
+        });
+      });
+
+      req->on_close([&s, &r, &closed, n = calls.size()](uint32_t error_code) {
+        r.error_code = error_code;
+        r.rank = static_cast<int>(++closed);
+        if (closed == n) s.shutdown();
+      });
+    }
+  });
+
+  ioc.run();
+  return res;
+}
+
+}
+}
+
+TEST_CASE_PERSISTENT_FIXTURE(offtest::Fixture, "Testing offloaded handlers", "[offload]") {
+  GIVEN("A server with a single thread, manual flow control and offloaded handlers on localhost:3016") {
+    WHEN("A slow offloaded handler runs next to a fast one on the same connection") {
+      const auto res = offtest::responses({{"GET", "/slow", ""}, {"GET", "/fast", ""}});
+      CHECK(res[0].status == 200);
+      CHECK(res[0].body == "slow");
+      CHECK(res[1].status == 200);
+      CHECK(res[1].body == "fast");
+      CHECK(res[1].rank == 1);
+      CHECK(res[0].rank == 2);
+    }
+
+    AND_WHEN("An offloaded handler reads the request and its body") {
+      const auto data = std::string(5'000, 'x');
+      const auto res = offtest::responses({{"POST", "/echo", data}});
+      CHECK(res[0].status == 200);
+      CHECK(res[0].method == "POST");
+      CHECK(res[0].path == "/echo");
+      CHECK(res[0].body == data);
+    }
+
+    AND_WHEN("An offloaded handler reads a body far larger than the stream window") {
+      // The server gives credit for the request body only as it is
+      // read, with manual flow control.
+      const auto data = std::string(512 * 1024, 'x');
+      const auto res = offtest::responses({{"POST", "/length", data}});
+      CHECK(res[0].status == 200);
+      CHECK(res[0].body == std::to_string(data.size()));
+    }
+
+    AND_WHEN("The request body is larger than the handler takes") {
+      const auto res = offtest::responses({{"POST", "/echo", std::string(20'000, 'x')}});
+      CHECK(res[0].status == 413);
+    }
+
+    AND_WHEN("An offloaded handler throws") {
+      const auto res = offtest::responses({{"GET", "/throw", ""}});
+      CHECK(res[0].status == 0);
+      CHECK(res[0].error_code == NGHTTP2_INTERNAL_ERROR);
+    }
+
+    AND_WHEN("The queue of the pool is full") {
+      const auto before = busy.stats();
+      const auto res = offtest::responses({{"GET", "/busy", ""}, {"GET", "/busy", ""}, {"GET", "/busy", ""}});
+      auto ok = 0;
+      auto unavailable = 0;
+      for (auto& r : res) {
+        if (r.status == 200) ++ok;
+        if (r.status == 503) ++unavailable;
+      }
+      CHECK(ok >= 1);
+      CHECK(ok + unavailable == 3);
+      CHECK(unavailable >= 1);
+
+      // A handler may still be returning after its response is sent.
+      for (auto i = 0; i < 50 && busy.stats().running != 0; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds{20});
+      }
+      const auto stats = busy.stats();
+      CHECK(stats.rejected - before.rejected == static_cast<uint64_t>(unavailable));
+      CHECK(stats.executed - before.executed == static_cast<uint64_t>(ok));
+      CHECK(stats.max_queued == 1);
+      CHECK(stats.queued == 0);
+    }
+
+    AND_WHEN("Reading the counters of the pool") {
+      offtest::responses({{"POST", "/echo", "a"}, {"POST", "/echo", "b"}, {"POST", "/echo", "c"}});
+      for (auto i = 0; i < 50 && pool.stats().running != 0; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds{20});
+      }
+      const auto stats = pool.stats();
+      CHECK(stats.executed >= 3);
+      CHECK(stats.queued == 0);
+      CHECK(stats.running == 0);
+      CHECK(stats.rejected == 0);
+    }
+  }
+}
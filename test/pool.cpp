@@ -0,0 +1,90 @@
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <nghttp2/asio_http2_client.h>
+#include <nghttp2/asio_http2_server.h>
+
+namespace {
+namespace ptest {
+
+struct Fixture {
+  Fixture() {
+    server.num_threads(1);
+    server.connection_pool_size(4);
+    server.handle("/", [](const nghttp2::asio_http2::server::request&, const nghttp2::asio_http2::server::response& res) {
+      res.write_head(200, {{"content-type", {"text/plain", false}}});
+      res.end("Ok");
+    });
+
+    std::cout << "Starting HTTP/2 server with a connection pool on localhost:3006\n";
+    boost::system::error_code ec;
+    if (server.listen_and_serve(ec, "localhost", "3006", true)) {
+      std::cerr << "error: " << ec.message() << std::endl;
+    }
+  }
+
+  ~Fixture() {
+    std::cout << "Stopping pool server\n";
+    server.stop();
+    server.join();
+  }
+
+  mutable nghttp2::asio_http2::server::http2 server;
+};
+
+std::string response() {
+  boost::asio::io_context ioc;
+  auto response = std::string{};
+
+  auto s = nghttp2::asio_http2::client::session{ioc, "localhost", "3006"};
+  s.on_connect([&s, &response](const boost::asio::ip::tcp::endpoint&) {
+    boost::system::error_code ec;
+    auto req = s.submit(ec, "GET", "http://localhost:3006/");
+    if (ec) {
+      std::cerr << ec.message() << std::endl;
+      return;
+    }
+
+    req->on_response([&response](const nghttp2::asio_http2::client::response& res) {
+      res.on_data([&response](const uint8_t* data, std::size_t length) {
+        response.append(reinterpret_cast<const char*>(data), length);
+      });
+    });
+
+    req->on_close([&s](uint32_t) {s.shutdown();});
+  });
+
+  ioc.run();
+  return response;
+}
+
+void wait_closed(nghttp2::asio_http2::server::http2& server) {
+  for (auto i = 0; i < 50 && server.stats().active_connections != 0; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds{20});
+  }
+}
+
+}
+}
+
+TEST_CASE_PERSISTENT_FIXTURE(ptest::Fixture, "Testing connection pool", "[pool]") {
+  GIVEN("A server keeping up to 4 closed connections on localhost:3006") {
+    ptest::wait_closed(server);
+    const auto baseline = server.stats();
+
+    WHEN("Clients connect one after the other") {
+      for (auto i = 0; i < 10; ++i) {
+        CHECK(ptest::response() == "Ok");
+        ptest::wait_closed(server);
+      }
+
+      const auto stats = server.stats();
+      CHECK(stats.accepted_connections == baseline.accepted_connections + 10);
+      // Each accept after the first one reuses the previous connection.
+      CHECK(stats.pool_hits >= baseline.pool_hits + 9);
+      CHECK(stats.pooled_connections >= 1);
+      CHECK(stats.pooled_connections <= 4);
+    }
+  }
+}
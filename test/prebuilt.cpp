@@ -0,0 +1,131 @@
+#include <catch2/catch_test_macros.hpp>
+#include <format>
+#include <iostream>
+#include <nghttp2/asio_http2_client.h>
+#include <nghttp2/asio_http2_server.h>
+
+namespace {
+namespace ptest {
+
+std::string large() {
+  auto s = std::string(100'000, '\0');
+  for (std::size_t i = 0; i < s.size(); ++i) s[i] = static_cast<char>('a' + i % 26);
+  return s;
+}
+
+struct Fixture {
+  Fixture() : health{200, {{"content-type", {"application/json", false}}}, R"({"status":"ok"})"},
+      big{200, {}, large()} {
+    server.num_threads(2);
+    server.handle("/health", nghttp2::asio_http2::server::prebuilt_handler(health));
+    server.handle("/big", [this](const nghttp2::asio_http2::server::request&, const nghttp2::asio_http2::server::response& res) {
+      res.end(big);
+    });
+    server.handle("/status/", nghttp2::asio_http2::server::status_handler(503));
+
+    std::cout << "Starting HTTP/2 server on localhost:3009\n";
+    boost::system::error_code ec;
+    if (server.listen_and_serve(ec, "localhost", "3009", true)) {
+      std::cerr << "error: " << ec.message() << std::endl;
+    }
+  }
+
+  ~Fixture() {
+    std::cout << "Stopping prebuilt server\n";
+    server.stop();
+    server.join();
+  }
+
+  nghttp2::asio_http2::server::prebuilt_response health;
+  nghttp2::asio_http2::server::prebuilt_response big;
+  mutable nghttp2::asio_http2::server::http2 server;
+};
+
+struct result {
+  int status = 0;
+  std::string body;
+  std::string content_type;
+  std::string content_length;
+  bool date = false;
+};
+
+result response(std::string_view method, std::string_view path) {
+  boost::asio::io_context ioc;
+  auto res = result{};
+
+  auto s = nghttp2::asio_http2::client::session{ioc, "localhost", "3009"};
+  s.on_connect([&s, &res, method, path](const boost::asio::ip::tcp::endpoint&) {
+    boost::system::error_code ec;
+    auto req = s.submit(ec, std::string{method}, std::format("http://localhost:3009{}", path));
+    if (ec) {
+      std::cerr << ec.message() << std::endl;
+      return;
+    }
+
+    req->on_response([&res](const nghttp2::asio_http2::client::response& r) {
+      res.status = r.status_code();
+      res.content_type = r.fields().value("content-type");
+      res.content_length = r.fields().value("content-length");
+      res.date = r.fields().find("date") != nullptr;
+      r.on_data([&res](const uint8_t* data, std::size_t length) {
+        res.body.append(reinterpret_cast<const char*>(data), length);
+      });
+    });
+
+    req->on_close([&s](uint32_t) { s.shutdown(); });
+  });
+
+  ioc.run();
+  return res;
+}
+
+}
+}
+
+TEST_CASE_PERSISTENT_FIXTURE(ptest::Fixture, "Testing prebuilt responses", "[prebuilt]") {
+  GIVEN("A server with prebuilt responses on localhost:3009") {
+    WHEN("Requesting a small prebuilt response") {
+      for (auto i = 0; i < 3; ++i) {
+        const auto res = ptest::response("GET", "/health");
+        CHECK(res.status == 200);
+        CHECK(res.body == R"({"status":"ok"})");
+        CHECK(res.content_type == "application/json");
+        CHECK(res.content_length == "15");
+        CHECK(res.date);
+      }
+    }
+
+    AND_WHEN("Requesting a prebuilt response spanning several DATA frames") {
+      const auto res = ptest::response("GET", "/big");
+      CHECK(res.status == 200);
+      CHECK(res.body.size() == big.body().size());
+      CHECK(res.body == big.body());
+      CHECK(res.content_length == "100000");
+    }
+
+    AND_WHEN("Requesting a prebuilt response with HEAD") {
+      const auto res = ptest::response("HEAD", "/health");
+      CHECK(res.status == 200);
+      CHECK(res.body.empty());
+      CHECK(res.content_length == "15");
+    }
+
+    AND_WHEN("Requesting a status handler and an unknown path") {
+      const auto status = ptest::response("GET", "/status/");
+      CHECK(status.status == 503);
+      CHECK(status.content_type == "text/html; charset=utf-8");
+      CHECK(status.body.find("503 Service Unavailable") != std::string::npos);
+
+      const auto missing = ptest::response("GET", "/missing");
+      CHECK(missing.status == 404);
+      CHECK(missing.body.find("404 Not Found") != std::string::npos);
+      CHECK(missing.content_length == std::to_string(missing.body.size()));
+    }
+
+    AND_WHEN("Requesting a path redirected to its directory") {
+      const auto res = ptest::response("GET", "/status");
+      CHECK(res.status == 301);
+      CHECK(res.body.find("301 Moved Permanently") != std::string::npos);
+    }
+  }
+}
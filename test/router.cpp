@@ -0,0 +1,156 @@
+#include <catch2/catch_test_macros.hpp>
+#include <format>
+#include <iostream>
+#include <nghttp2/asio_http2_client.h>
+#include <nghttp2/asio_http2_server.h>
+
+namespace {
+namespace rtest {
+
+using nghttp2::asio_http2::server::request;
+using nghttp2::asio_http2::server::response;
+
+nghttp2::asio_http2::server::request_cb reply(std::string body) {
+  return [body = std::move(body)](const request&, const response& res) {
+    res.write_head(200);
+    res.end(body);
+  };
+}
+
+struct Fixture {
+  Fixture() {
+    server.num_threads(2);
+    // Enough routes for a linear scan to show.
+    for (auto i = 0; i < 3'000; ++i) {
+      server.handle(std::format("/api/v{}/item{}", i % 5, i), reply(std::format("item {}", i)));
+    }
+    server.handle("/api/", reply("api"));
+    server.handle("/api/v1/", reply("v1"));
+    server.handle("/images/", reply("images"));
+    server.handle("/images/thumbnails/", reply("thumbnails"));
+    server.handle("/exact", reply("exact"));
+    // Registered after the implicit redirect of "/docs/" to it.
+    server.handle("/docs/", reply("docs"));
+    server.handle("/docs", reply("docs index"));
+    server.handle("localhost:3017/images/", reply("host images"));
+
+    std::cout << "Starting HTTP/2 server with many routes on localhost:3017\n";
+    boost::system::error_code ec;
+    if (server.listen_and_serve(ec, "localhost", "3017", true)) {
+      std::cerr << "error: " << ec.message() << std::endl;
+    }
+  }
+
+  ~Fixture() {
+    std::cout << "Stopping router server\n";
+    server.stop();
+    server.join();
+  }
+
+  mutable nghttp2::asio_http2::server::http2 server;
+};
+
+struct result {
+  int status = 0;
+  std::string body;
+  std::string location;
+};
+
+// Requests each of |paths| from |host|, which is localhost or
+// 127.0.0.1.
+std::vector<result> responses(std::string_view host, const std::vector<std::string>& paths) {
+  boost::asio::io_context ioc;
+  auto res = std::vector<result>(paths.size());
+  auto closed = std::size_t{0};
+
+  auto s = nghttp2::asio_http2::client::session{ioc, std::string{host}, "3017"};
+  s.on_connect([&](const boost::asio::ip::tcp::endpoint&) {
+    for (std::size_t i = 0; i < paths.size(); ++i) {
+      boost::system::error_code ec;
+      auto req = s.submit(ec, "GET", std::format("http://{}:3017{}", host, paths[i]));
+      if (ec) {
+        std::cerr << ec.message() << std::endl;
+        return;
+      }
+
+      auto& r = res[i];
+      req->on_response([&r](const nghttp2::asio_http2::client::response& rsp) {
+        r.status = rsp.status_code();
+        r.location = rsp.fields().value("location");
+        rsp.on_data([&r](const uint8_t* d, std::size_t length) {
+          r.body.append(reinterpret_cast<const char*>(d), length);
+        });
+      });
+
+      req->on_close([&s, &closed, n = paths.size()](uint32_t) {
+        if (++closed == n) s.shutdown();
+      });
+    }
+  });
+
+  ioc.run();
+  return res;
+}
+
+}
+}
+
+TEST_CASE_PERSISTENT_FIXTURE(rtest::Fixture, "Testing request routing", "[router]") {
+  GIVEN("A server with 3000 routes on localhost:3017") {
+    WHEN("Requesting fixed paths") {
+      const auto res = rtest::responses("127.0.0.1", {"/api/v0/item0", "/api/v4/item2999", "/api/v2/item1502", "/exact"});
+      CHECK(res[0].body == "item 0");
+      CHECK(res[1].body == "item 2999");
+      CHECK(res[2].body == "item 1502");
+      CHECK(res[3].body == "exact");
+    }
+
+    AND_WHEN("Requesting paths under subtrees") {
+      const auto res = rtest::responses("127.0.0.1", {"/api/v1/item3", "/api/v1/other", "/api/v2/other", "/api/v0/item1",
+                                                      "/images/a.png", "/images/thumbnails/a.png", "/images/thumbnails"});
+      // item3 is registered under /api/v3/.
+      CHECK(res[0].body == "v1");
+      CHECK(res[1].body == "v1");
+      CHECK(res[2].body == "api");
+      CHECK(res[3].body == "api");
+      CHECK(res[4].body == "images");
+      CHECK(res[5].body == "thumbnails");
+      CHECK(res[6].status == 301);
+      CHECK(res[6].location == "/images/thumbnails/");
+    }
+
+    AND_WHEN("Requesting paths matching no pattern") {
+      const auto res = rtest::responses("127.0.0.1", {"/", "/exact/", "/exac", "/api"});
+      CHECK(res[0].status == 404);
+      CHECK(res[1].status == 404);
+      CHECK(res[2].status == 404);
+      CHECK(res[3].status == 301);
+      CHECK(res[3].location == "/api/");
+    }
+
+    AND_WHEN("Registering a pattern after its implicit redirect") {
+      const auto res = rtest::responses("127.0.0.1", {"/docs", "/docs/intro"});
+      CHECK(res[0].status == 200);
+      CHECK(res[0].body == "docs index");
+      CHECK(res[1].body == "docs");
+    }
+
+    AND_WHEN("Requesting paths with a host specific pattern") {
+      const auto res = rtest::responses("localhost", {"/images/a.png", "/images/thumbnails/a.png", "/exact"});
+      // Host specific patterns take precedence, even over longer ones.
+      CHECK(res[0].body == "host images");
+      CHECK(res[1].body == "host images");
+      CHECK(res[2].body == "exact");
+    }
+
+    AND_WHEN("Requesting paths which are not clean") {
+      const auto res = rtest::responses("127.0.0.1", {"/images/../exact", "/api/./v1/x", "/api//v1/x"});
+      CHECK(res[0].status == 301);
+      CHECK(res[0].location == "/exact");
+      CHECK(res[1].status == 301);
+      CHECK(res[1].location == "/api/v1/x");
+      CHECK(res[2].status == 301);
+      CHECK(res[2].location == "/api/v1/x");
+    }
+  }
+}
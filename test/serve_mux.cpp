@@ -0,0 +1,104 @@
+#include <catch2/catch_test_macros.hpp>
+#include <map>
+#include <random>
+#include <string>
+#include "asio_server_serve_mux.h"
+
+namespace {
+namespace mtest {
+
+// The linear scan serve_mux used before the radix tree, over a map
+// from pattern to whether it was registered by the user, or is the
+// implicit redirect of a pattern ending with '/'.
+struct linear_mux {
+  bool handle(const std::string& pattern) {
+    auto it = patterns.find(pattern);
+    if (pattern.empty() || (it != std::end(patterns) && it->second)) return false;
+    if (pattern.size() >= 2 && pattern.back() == '/') {
+      // Does not replace a pattern registered by the user.
+      patterns.emplace(pattern.substr(0, pattern.size() - 1), false);
+    }
+    patterns[pattern] = true;
+    return true;
+  }
+
+  static bool path_match(const std::string& pattern, const std::string& path) {
+    if (pattern.back() != '/') return pattern == path;
+    return path.starts_with(pattern);
+  }
+
+  // Returns the longest pattern matching |path|, or nullptr.
+  const std::pair<const std::string, bool>* match(const std::string& path) const {
+    const std::pair<const std::string, bool>* ent = nullptr;
+    for (auto& kv : patterns) {
+      if (path_match(kv.first, path) && (!ent || ent->first.size() < kv.first.size())) ent = &kv;
+    }
+    return ent;
+  }
+
+  std::map<std::string, bool> patterns;
+};
+
+struct generator {
+  std::string path(int max_segments) {
+    static constexpr const char* segments[] = {"a", "ab", "abc", "b", "api", "v1", "v2", "x", ""};
+    auto p = std::string{};
+    for (auto n = rng() % max_segments; n > 0; --n) {
+      p += '/';
+      p += segments[rng() % std::size(segments)];
+    }
+    if (p.empty() || rng() % 2) p += '/';
+    return p;
+  }
+
+  std::string host() {
+    static constexpr const char* hosts[] = {"", "a.com", "b.com", "a.co"};
+    return hosts[rng() % std::size(hosts)];
+  }
+
+  std::mt19937 rng{42};
+};
+
+}
+}
+
+TEST_CASE("Testing serve_mux against a linear scan", "[serve_mux]") {
+  auto gen = mtest::generator{};
+  auto mismatches = 0;
+
+  GIVEN("Muxes with the same random patterns") {
+    for (auto round = 0; round < 200; ++round) {
+      auto mux = nghttp2::asio_http2::server::serve_mux{};
+      auto linear = mtest::linear_mux{};
+
+      for (auto n = gen.rng() % 60; n > 0; --n) {
+        auto pattern = gen.host() + gen.path(4);
+        // Some patterns lose their trailing '/', or are empty.
+        if (gen.rng() % 10 == 0) pattern.pop_back();
+        const auto handled = mux.handle(pattern, [](const nghttp2::asio_http2::server::request&, const nghttp2::asio_http2::server::response&) {});
+        if (handled != linear.handle(pattern)) ++mismatches;
+      }
+
+      for (auto q = 0; q < 300; ++q) {
+        const auto host = gen.host();
+        auto path = gen.path(5);
+        if (gen.rng() % 7 == 0) path.resize(gen.rng() % (path.size() + 1));
+
+        const auto entry = mux.match(host, path);
+        const auto expected = linear.match(host + path);
+        if (!entry || !expected) {
+          if (entry || expected) ++mismatches;
+          continue;
+        }
+        // The entry of an implicit redirect carries the pattern it
+        // redirects to.
+        if (entry->user_defined != expected->second ||
+            entry->pattern != (expected->second ? expected->first : expected->first + '/')) {
+          ++mismatches;
+        }
+      }
+    }
+
+    CHECK(mismatches == 0);
+  }
+}
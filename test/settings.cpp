@@ -0,0 +1,137 @@
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <boost/asio/steady_timer.hpp>
+#include <nghttp2/asio_http2_client.h>
+#include <nghttp2/asio_http2_server.h>
+
+namespace {
+namespace stest {
+
+struct Fixture {
+  Fixture() {
+    auto settings = nghttp2::asio_http2::server::server_settings{};
+    settings.max_concurrent_streams = 1;
+    settings.initial_window_size = 1024;
+    settings.connection_window_size = 1024 * 1024;
+    // Clamped to the minimum of 16 KiB.
+    settings.max_frame_size = 1;
+    settings.header_table_size = 0;
+    settings.max_deflate_dynamic_table_size = 0;
+    settings.keep_closed_streams = false;
+
+    server.num_threads(2);
+    server.settings(settings);
+    server.handle("/slow", [](const nghttp2::asio_http2::server::request&, const nghttp2::asio_http2::server::response& res) {
+      auto timer = std::make_shared<boost::asio::steady_timer>(res.executor(), std::chrono::milliseconds{200});
+      timer->async_wait([&res, timer](const boost::system::error_code&) {
+        res.write_head(200);
+        res.end("done");
+      });
+    });
+    server.handle("/upload", [](const nghttp2::asio_http2::server::request& req, const nghttp2::asio_http2::server::response& res) {
+      auto size = std::make_shared<std::size_t>(0);
+      req.on_data([&res, size](const uint8_t*, std::size_t length) {
+        if (length == 0) {
+          res.write_head(200);
+          res.end(std::to_string(*size));
+          return;
+        }
+        *size += length;
+      });
+    });
+
+    std::cout << "Starting HTTP/2 server with custom settings on localhost:3010\n";
+    boost::system::error_code ec;
+    if (server.listen_and_serve(ec, "localhost", "3010", true)) {
+      std::cerr << "error: " << ec.message() << std::endl;
+    }
+  }
+
+  ~Fixture() {
+    std::cout << "Stopping settings server\n";
+    server.stop();
+    server.join();
+  }
+
+  mutable nghttp2::asio_http2::server::http2 server;
+};
+
+struct result {
+  std::vector<std::string> bodies;
+  // Time taken by the requests submitted at once.
+  std::chrono::steady_clock::duration elapsed;
+};
+
+// Submits |count| requests at once on one connection, with |body| if
+// not empty.  A first request makes sure the client has the settings
+// of the server by then; otherwise the streams beyond the limit would
+// be refused.
+result responses(std::string_view path, std::size_t count, const std::string& body = {}) {
+  boost::asio::io_context ioc;
+  auto res = result{std::vector<std::string>(count), {}};
+  auto left = count;
+  auto start = std::chrono::steady_clock::now();
+  const auto uri = "http://localhost:3010" + std::string{path};
+
+  auto s = nghttp2::asio_http2::client::session{ioc, "localhost", "3010"};
+  auto batch = [&] {
+    start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < count; ++i) {
+      boost::system::error_code ec;
+      auto req = body.empty() ? s.submit(ec, "GET", uri) : s.submit(ec, "POST", uri, body);
+      if (ec) {
+        std::cerr << ec.message() << std::endl;
+        return;
+      }
+
+      req->on_response([&res, i](const nghttp2::asio_http2::client::response& r) {
+        r.on_data([&res, i](const uint8_t* data, std::size_t length) {
+          res.bodies[i].append(reinterpret_cast<const char*>(data), length);
+        });
+      });
+      req->on_close([&](uint32_t) {
+        if (--left == 0) {
+          res.elapsed = std::chrono::steady_clock::now() - start;
+          s.shutdown();
+        }
+      });
+    }
+  };
+
+  s.on_connect([&](const boost::asio::ip::tcp::endpoint&) {
+    boost::system::error_code ec;
+    auto req = s.submit(ec, "GET", uri);
+    if (ec) {
+      std::cerr << ec.message() << std::endl;
+      return;
+    }
+    req->on_close([&](uint32_t) { batch(); });
+  });
+
+  ioc.run();
+  return res;
+}
+
+}
+}
+
+TEST_CASE_PERSISTENT_FIXTURE(stest::Fixture, "Testing server settings", "[settings]") {
+  GIVEN("A server allowing one stream at a time on localhost:3010") {
+    WHEN("Submitting three slow requests at once") {
+      const auto res = stest::responses("/slow", 3);
+      CHECK(res.bodies == std::vector<std::string>(3, "done"));
+      // The client waits for each stream to close before opening the
+      // next one.
+      CHECK(res.elapsed >= std::chrono::milliseconds{600});
+    }
+
+    AND_WHEN("Uploading through a small stream window") {
+      const auto body = std::string(256 * 1024, 'x');
+      const auto res = stest::responses("/upload", 1, body);
+      REQUIRE(res.bodies.size() == 1);
+      CHECK(res.bodies[0] == std::to_string(body.size()));
+    }
+  }
+}
@@ -0,0 +1,124 @@
+#include <catch2/catch_test_macros.hpp>
+#include <format>
+#include <future>
+#include <iostream>
+#include <vector>
+#include <nghttp2/asio_http2_client.h>
+#include <nghttp2/asio_http2_server.h>
+
+namespace {
+namespace stest {
+
+struct Fixture {
+  Fixture() {
+    server.num_threads(4);
+    server.sharded(true);
+    server.handle("/", [](const nghttp2::asio_http2::server::request&, const nghttp2::asio_http2::server::response& res) {
+      res.write_head(200, {{"content-type", {"text/plain", false}}});
+      res.end("Ok");
+    });
+
+    std::cout << "Starting sharded HTTP/2 server on localhost:3001\n";
+    boost::system::error_code ec;
+    if (server.listen_and_serve(ec, "localhost", "3001", true)) {
+      std::cerr << "error: " << ec.message() << std::endl;
+    }
+  }
+
+  ~Fixture() {
+    std::cout << "Stopping sharded server\n";
+    server.stop();
+    server.join();
+  }
+
+  mutable nghttp2::asio_http2::server::http2 server;
+};
+
+std::string response(std::string_view path) {
+  boost::asio::io_context ioc;
+  auto response = std::string{};
+
+  auto s = nghttp2::asio_http2::client::session{ioc, "localhost", "3001"};
+  s.on_connect([&s, &response, path](const boost::asio::ip::tcp::endpoint&) {
+    boost::system::error_code ec;
+    auto req = s.submit(ec, "GET", std::format("http://localhost:3001{}", path));
+    if (ec) {
+      std::cerr << ec.message() << std::endl;
+      return;
+    }
+
+    req->on_response([&response](const nghttp2::asio_http2::client::response& res) {
+      res.on_data([&response](const uint8_t* data, std::size_t length) {
+        response.append(reinterpret_cast<const char*>(data), length);
+      });
+    });
+
+    req->on_close([&s](uint32_t) {s.shutdown();});
+  });
+
+  ioc.run();
+  return response;
+}
+
+}
+}
+
+TEST_CASE_PERSISTENT_FIXTURE(stest::Fixture, "Testing sharded server", "[sharded]") {
+  GIVEN("A sharded server running on localhost:3001") {
+    WHEN("Checking the ports in use") {
+      const auto ports = server.ports();
+      REQUIRE_FALSE(ports.empty());
+      for (const auto port : ports) CHECK(port == 3001);
+    }
+
+    AND_WHEN("Making requests in parallel") {
+      constexpr auto total = 256;
+      auto vec = std::vector<std::future<std::string>>{};
+      vec.reserve(total);
+
+      for (auto i = 0; i < total; i++) {
+        vec.push_back(std::async(std::launch::async, []() { return stest::response("/"); }));
+      }
+
+      for (auto& fut : vec) CHECK(fut.get() == "Ok");
+    }
+  }
+}
+
+TEST_CASE("Testing thread affinity", "[sharded]") {
+  auto listen = [](std::vector<int> ids, nghttp2::asio_http2::server::affinity_kind kind) {
+    auto server = nghttp2::asio_http2::server::http2{};
+    server.num_threads(2);
+    server.sharded(true);
+    server.thread_affinity(std::move(ids), kind);
+    boost::system::error_code ec;
+    if (!server.listen_and_serve(ec, "localhost", "3021", true)) {
+      server.stop();
+      server.join();
+    }
+    return ec;
+  };
+  const auto invalid = make_error_code(boost::system::errc::invalid_argument);
+
+  GIVEN("A server pinned to CPUs") {
+    WHEN("The CPU ids are valid") {
+      CHECK_FALSE(listen({0}, nghttp2::asio_http2::server::affinity_kind::cpu));
+    }
+
+    AND_WHEN("A CPU id is out of range") {
+      CHECK(listen({0, -1}, nghttp2::asio_http2::server::affinity_kind::cpu) == invalid);
+      CHECK(listen({1 << 20}, nghttp2::asio_http2::server::affinity_kind::cpu) == invalid);
+    }
+  }
+
+  GIVEN("A server pinned to NUMA nodes") {
+    WHEN("The node id is valid") {
+      CHECK_FALSE(listen({0}, nghttp2::asio_http2::server::affinity_kind::numa_node));
+    }
+
+    AND_WHEN("A node does not exist") {
+      CHECK(listen({-1}, nghttp2::asio_http2::server::affinity_kind::numa_node) == invalid);
+      CHECK(listen({0, 1'000'000}, nghttp2::asio_http2::server::affinity_kind::numa_node) == invalid);
+    }
+  }
+}
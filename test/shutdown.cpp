@@ -0,0 +1,101 @@
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <format>
+#include <future>
+#include <iostream>
+#include <thread>
+#include <boost/asio/steady_timer.hpp>
+#include <nghttp2/asio_http2_client.h>
+#include <nghttp2/asio_http2_server.h>
+
+namespace {
+namespace dtest {
+
+struct result {
+  std::string body;
+  uint32_t error_code = 0;
+};
+
+result response(std::string_view path) {
+  boost::asio::io_context ioc;
+  auto res = result{};
+
+  auto s = nghttp2::asio_http2::client::session{ioc, "localhost", "3004"};
+  s.on_connect([&s, &res, path](const boost::asio::ip::tcp::endpoint&) {
+    boost::system::error_code ec;
+    auto req = s.submit(ec, "GET", std::format("http://localhost:3004{}", path));
+    if (ec) {
+      std::cerr << ec.message() << std::endl;
+      return;
+    }
+
+    req->on_response([&res](const nghttp2::asio_http2::client::response& r) {
+      r.on_data([&res](const uint8_t* data, std::size_t length) {
+        res.body.append(reinterpret_cast<const char*>(data), length);
+      });
+    });
+
+    req->on_close([&s, &res](uint32_t error_code) {
+      res.error_code = error_code;
+      s.shutdown();
+    });
+  });
+  s.on_error([](const boost::system::error_code&) {});
+
+  ioc.run();
+  return res;
+}
+
+// Replies after |delay|, or never if it is zero.
+void delayed(const nghttp2::asio_http2::server::response& res, std::chrono::milliseconds delay) {
+  res.write_head(200, {{"content-type", {"text/plain", false}}});
+  if (delay.count() == 0) {
+    res.end(nghttp2::asio_http2::generator_cb{[](uint8_t*, std::size_t, uint32_t*) -> ssize_t {
+      return NGHTTP2_ERR_DEFERRED;
+    }});
+    return;
+  }
+
+  auto timer = std::make_shared<boost::asio::steady_timer>(res.executor(), delay);
+  timer->async_wait([&res, timer](const boost::system::error_code&) { res.end("done"); });
+}
+
+}
+}
+
+TEST_CASE("Testing graceful shutdown", "[shutdown]") {
+  GIVEN("A server with slow handlers on localhost:3004") {
+    nghttp2::asio_http2::server::http2 server;
+    server.num_threads(2);
+    server.handle("/slow", [](const nghttp2::asio_http2::server::request&, const nghttp2::asio_http2::server::response& res) {
+      dtest::delayed(res, std::chrono::milliseconds{500});
+    });
+    server.handle("/hang", [](const nghttp2::asio_http2::server::request&, const nghttp2::asio_http2::server::response& res) {
+      dtest::delayed(res, std::chrono::milliseconds{0});
+    });
+
+    boost::system::error_code ec;
+    REQUIRE_FALSE(server.listen_and_serve(ec, "localhost", "3004", true));
+
+    WHEN("Shutting down while requests are in flight") {
+      auto slow = std::async(std::launch::async, [] { return dtest::response("/slow"); });
+      auto hang = std::async(std::launch::async, [] { return dtest::response("/hang"); });
+      std::this_thread::sleep_for(std::chrono::milliseconds{200});
+
+      const auto start = std::chrono::steady_clock::now();
+      server.shutdown(std::chrono::seconds{2});
+      server.join();
+      const auto elapsed = std::chrono::steady_clock::now() - start;
+
+      const auto s = slow.get();
+      CHECK(s.body == "done");
+      CHECK(s.error_code == 0);
+
+      // The request which never completes is cut off at the deadline.
+      const auto h = hang.get();
+      CHECK(h.body.empty());
+      CHECK(elapsed >= std::chrono::seconds{2});
+      CHECK(elapsed < std::chrono::seconds{4});
+    }
+  }
+}
@@ -0,0 +1,76 @@
+#include <catch2/catch_test_macros.hpp>
+#include <set>
+#include <stdexcept>
+#include <vector>
+#include "asio_slab.h"
+
+namespace {
+namespace sltest {
+
+int live = 0;
+
+struct object {
+  explicit object(int v, bool fail = false) : value{v} {
+    if (fail) throw std::runtime_error{"fail"};
+    ++live;
+  }
+  ~object() { --live; }
+
+  int value;
+  char padding[40];
+};
+
+}
+}
+
+TEST_CASE("Testing the slab allocator", "[slab]") {
+  auto s = nghttp2::asio_http2::slab<sltest::object, 4>{};
+
+  GIVEN("Objects spanning several chunks") {
+    auto objects = std::vector<sltest::object*>{};
+    for (auto i = 0; i < 10; ++i) objects.push_back(s.create(i));
+    CHECK(sltest::live == 10);
+    for (auto i = 0; i < 10; ++i) CHECK(objects[i]->value == i);
+    CHECK(std::set<sltest::object*>(objects.begin(), objects.end()).size() == 10);
+
+    WHEN("Destroying them and creating as many again") {
+      auto freed = std::set<sltest::object*>(objects.begin(), objects.end());
+      for (auto p : objects) s.destroy(p);
+      CHECK(sltest::live == 0);
+
+      // The memory is reused, most recently freed first.
+      auto reused = s.create(100);
+      CHECK(reused == objects.back());
+      auto again = std::set<sltest::object*>{reused};
+      for (auto i = 1; i < 10; ++i) again.insert(s.create(100 + i));
+      CHECK(again == freed);
+      for (auto p : again) s.destroy(p);
+      CHECK(sltest::live == 0);
+    }
+
+    AND_WHEN("A constructor throws") {
+      for (auto p : objects) s.destroy(p);
+      CHECK_THROWS(s.create(0, true));
+      CHECK(sltest::live == 0);
+      // The slot stays free.
+      auto p = s.create(1);
+      CHECK(p == objects.back());
+      s.destroy(p);
+    }
+  }
+
+  GIVEN("An owning pointer") {
+    WHEN("It goes out of scope") {
+      sltest::object* first;
+      {
+        auto p = s.make(7);
+        first = p.get();
+        CHECK(p->value == 7);
+        CHECK(sltest::live == 1);
+      }
+      CHECK(sltest::live == 0);
+      auto p = s.make(8);
+      CHECK(p.get() == first);
+    }
+  }
+}
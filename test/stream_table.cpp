@@ -0,0 +1,130 @@
+#include <catch2/catch_test_macros.hpp>
+#include <map>
+#include <vector>
+#include "asio_stream_table.h"
+
+namespace {
+namespace sttest {
+
+using table = nghttp2::asio_http2::stream_table<int>;
+
+// Stream ids whose home slot is |home| in a table of 16 slots.
+std::vector<int32_t> colliding(std::size_t home, std::size_t n) {
+  auto ids = std::vector<int32_t>{};
+  for (int32_t id = 1; ids.size() < n; ++id) {
+    if ((static_cast<uint32_t>(id) * 2654435769u) >> 28 == home) ids.push_back(id);
+  }
+  return ids;
+}
+
+// Checks that |t| holds exactly |expected|.
+void check(const table& t, const std::map<int32_t, int*>& expected) {
+  CHECK(t.size() == expected.size());
+  for (auto& [id, value] : expected) CHECK(t.find(id) == value);
+  auto n = std::size_t{};
+  t.for_each([&n](int*) { ++n; });
+  CHECK(n == expected.size());
+}
+
+}
+}
+
+TEST_CASE("Testing the stream table", "[stream_table]") {
+  auto values = std::vector<int>(10'000);
+  auto t = sttest::table{};
+  auto expected = std::map<int32_t, int*>{};
+
+  GIVEN("An empty table") {
+    CHECK(t.empty());
+    CHECK(t.find(1) == nullptr);
+    CHECK(t.erase(1) == nullptr);
+  }
+
+  GIVEN("A table of client stream ids, as a server sees them") {
+    for (int32_t id = 1; id < 2'000; id += 2) {
+      t.insert(id, &values[id]);
+      expected[id] = &values[id];
+    }
+    sttest::check(t, expected);
+
+    WHEN("Erasing every other stream") {
+      for (int32_t id = 1; id < 2'000; id += 4) {
+        CHECK(t.erase(id) == &values[id]);
+        expected.erase(id);
+      }
+      sttest::check(t, expected);
+      CHECK(t.find(1) == nullptr);
+      CHECK(t.erase(1) == nullptr);
+    }
+
+    AND_WHEN("Streams come and go past the size the table grew to") {
+      // Every lookup still finds its entry, with no tombstones left.
+      for (int32_t id = 2'001; id < 20'000; id += 2) {
+        t.insert(id, &values[id % values.size()]);
+        expected[id] = &values[id % values.size()];
+        auto old = id - 1'000;
+        CHECK(t.erase(old) == expected[old]);
+        expected.erase(old);
+      }
+      sttest::check(t, expected);
+    }
+  }
+
+  GIVEN("A run of colliding stream ids which wraps around the end of the table") {
+    // Home slot 14 of 16; the run spills over slots 15, 0, 1 and 2.
+    const auto ids = sttest::colliding(14, 5);
+    const auto other = sttest::colliding(0, 1).front();
+    for (auto id : ids) {
+      t.insert(id, &values[id]);
+      expected[id] = &values[id];
+    }
+    t.insert(other, &values[other]);
+    expected[other] = &values[other];
+    sttest::check(t, expected);
+
+    WHEN("Erasing the head of the run") {
+      CHECK(t.erase(ids[0]) == &values[ids[0]]);
+      expected.erase(ids[0]);
+      sttest::check(t, expected);
+    }
+
+    AND_WHEN("Erasing the middle of the run") {
+      CHECK(t.erase(ids[2]) == &values[ids[2]]);
+      expected.erase(ids[2]);
+      sttest::check(t, expected);
+    }
+
+    AND_WHEN("Erasing the whole run") {
+      for (auto id : ids) {
+        CHECK(t.erase(id) == &values[id]);
+        expected.erase(id);
+        sttest::check(t, expected);
+      }
+      CHECK(t.find(other) == &values[other]);
+    }
+
+    AND_WHEN("Growing the table") {
+      for (int32_t id = 1'001; id < 1'101; ++id) {
+        t.insert(id, &values[id]);
+        expected[id] = &values[id];
+      }
+      sttest::check(t, expected);
+    }
+  }
+
+  GIVEN("A table cleared while it is used") {
+    for (int32_t id = 1; id < 100; ++id) t.insert(id, &values[id]);
+
+    WHEN("Clearing it") {
+      auto n = 0;
+      t.clear([&](int*) {
+        // The table is already empty, and may be used again.
+        CHECK(t.empty());
+        ++n;
+      });
+      CHECK(n == 99);
+      t.insert(1, &values[1]);
+      CHECK(t.find(1) == &values[1]);
+    }
+  }
+}
@@ -0,0 +1,100 @@
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <format>
+#include <iostream>
+#include <nghttp2/asio_http2_client.h>
+#include <nghttp2/asio_http2_server.h>
+
+namespace {
+namespace ttest {
+
+struct Fixture {
+  Fixture() {
+    server.num_threads(2);
+    server.read_timeout(std::chrono::milliseconds{500});
+    server.handle("/", [](const nghttp2::asio_http2::server::request&, const nghttp2::asio_http2::server::response& res) {
+      res.write_head(200, {{"content-type", {"text/plain", false}}});
+      res.end("Ok");
+    });
+    server.handle("/hang", [](const nghttp2::asio_http2::server::request&, const nghttp2::asio_http2::server::response& res) {
+      res.write_head(200, {{"content-type", {"text/plain", false}}});
+      res.end(nghttp2::asio_http2::generator_cb{[](uint8_t*, std::size_t, uint32_t*) -> ssize_t {
+        return NGHTTP2_ERR_DEFERRED;
+      }});
+    });
+
+    std::cout << "Starting HTTP/2 server with a 500ms read timeout on localhost:3005\n";
+    boost::system::error_code ec;
+    if (server.listen_and_serve(ec, "localhost", "3005", true)) {
+      std::cerr << "error: " << ec.message() << std::endl;
+    }
+  }
+
+  ~Fixture() {
+    std::cout << "Stopping timeout server\n";
+    server.stop();
+    server.join();
+  }
+
+  mutable nghttp2::asio_http2::server::http2 server;
+};
+
+struct result {
+  std::string body;
+  boost::system::error_code error;
+  std::chrono::steady_clock::duration elapsed;
+};
+
+// Requests |path| and keeps the connection open until either side
+// gives up on it.
+result idle(std::string_view path, std::chrono::milliseconds read_timeout) {
+  boost::asio::io_context ioc;
+  auto res = result{};
+
+  auto s = nghttp2::asio_http2::client::session{ioc, "localhost", "3005"};
+  s.read_timeout(read_timeout);
+  s.on_connect([&s, &res, path](const boost::asio::ip::tcp::endpoint&) {
+    boost::system::error_code ec;
+    auto req = s.submit(ec, "GET", std::format("http://localhost:3005{}", path));
+    if (ec) {
+      std::cerr << ec.message() << std::endl;
+      return;
+    }
+
+    req->on_response([&res](const nghttp2::asio_http2::client::response& r) {
+      r.on_data([&res](const uint8_t* data, std::size_t length) {
+        res.body.append(reinterpret_cast<const char*>(data), length);
+      });
+    });
+  });
+  s.on_error([&res](const boost::system::error_code& ec) { res.error = ec; });
+
+  const auto start = std::chrono::steady_clock::now();
+  ioc.run_for(std::chrono::seconds{5});
+  res.elapsed = std::chrono::steady_clock::now() - start;
+  return res;
+}
+
+}
+}
+
+TEST_CASE_PERSISTENT_FIXTURE(ttest::Fixture, "Testing read timeouts", "[timeout]") {
+  GIVEN("A server with a 500ms read timeout on localhost:3005") {
+    WHEN("A client stays idle after its request") {
+      const auto res = ttest::idle("/", std::chrono::seconds{10});
+      CHECK(res.body == "Ok");
+      // The server closes the connection, which ends the client's
+      // io_context.
+      CHECK(res.elapsed >= std::chrono::milliseconds{500});
+      CHECK(res.elapsed < std::chrono::seconds{2});
+    }
+
+    AND_WHEN("The client times out first") {
+      const auto res = ttest::idle("/hang", std::chrono::milliseconds{200});
+      CHECK(res.body.empty());
+      CHECK(res.error == boost::asio::error::timed_out);
+      CHECK(res.elapsed >= std::chrono::milliseconds{200});
+      CHECK(res.elapsed < std::chrono::milliseconds{500});
+    }
+  }
+}
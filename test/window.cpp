@@ -0,0 +1,108 @@
+#include <catch2/catch_test_macros.hpp>
+#include <iostream>
+#include <memory>
+#include <nghttp2/asio_http2_client.h>
+#include <nghttp2/asio_http2_server.h>
+
+namespace {
+namespace wtest {
+
+std::string payload() {
+  auto s = std::string(8 * 1024 * 1024 + 5, '\0');
+  for (std::size_t i = 0; i < s.size(); ++i) s[i] = static_cast<char>('a' + i % 26);
+  return s;
+}
+
+struct Fixture {
+  Fixture() : data{payload()} {
+    auto settings = nghttp2::asio_http2::server::server_settings{};
+    settings.max_auto_window_size = 4 * 1024 * 1024;
+
+    server.num_threads(2);
+    server.settings(settings);
+    server.handle("/download", [this](const nghttp2::asio_http2::server::request&, const nghttp2::asio_http2::server::response& res) {
+      res.write_head(200);
+      res.end(data);
+    });
+    server.handle("/upload", [this](const nghttp2::asio_http2::server::request& req, const nghttp2::asio_http2::server::response& res) {
+      auto body = std::make_shared<std::string>();
+      req.on_data([this, &res, body](const uint8_t* d, std::size_t length) {
+        if (length == 0) {
+          res.write_head(200);
+          res.end(*body == data ? "match" : "mismatch");
+          return;
+        }
+        body->append(reinterpret_cast<const char*>(d), length);
+      });
+    });
+
+    std::cout << "Starting HTTP/2 server with auto tuned windows on localhost:3012\n";
+    boost::system::error_code ec;
+    if (server.listen_and_serve(ec, "localhost", "3012", true)) {
+      std::cerr << "error: " << ec.message() << std::endl;
+    }
+  }
+
+  ~Fixture() {
+    std::cout << "Stopping window server\n";
+    server.stop();
+    server.join();
+  }
+
+  std::string data;
+  mutable nghttp2::asio_http2::server::http2 server;
+};
+
+std::string response(std::string_view method, std::string_view path, const std::string& body = {}) {
+  boost::asio::io_context ioc;
+  auto response = std::string{};
+
+  auto s = nghttp2::asio_http2::client::session{ioc, "localhost", "3012"};
+  s.max_auto_window_size(4 * 1024 * 1024);
+  s.on_connect([&](const boost::asio::ip::tcp::endpoint&) {
+    boost::system::error_code ec;
+    auto uri = "http://localhost:3012" + std::string{path};
+    auto req = body.empty() ? s.submit(ec, std::string{method}, uri) : s.submit(ec, std::string{method}, uri, body);
+    if (ec) {
+      std::cerr << ec.message() << std::endl;
+      return;
+    }
+
+    req->on_response([&response](const nghttp2::asio_http2::client::response& res) {
+      res.on_data([&response](const uint8_t* data, std::size_t length) {
+        response.append(reinterpret_cast<const char*>(data), length);
+      });
+    });
+    req->on_close([&s](uint32_t) { s.shutdown(); });
+  });
+
+  ioc.run();
+  return response;
+}
+
+}
+}
+
+TEST_CASE_PERSISTENT_FIXTURE(wtest::Fixture, "Testing auto tuned flow control windows", "[window]") {
+  GIVEN("A server and a client tuning their windows on localhost:3012") {
+    WHEN("Downloading a large body") {
+      const auto body = wtest::response("GET", "/download");
+      CHECK(body.size() == data.size());
+      CHECK(body == data);
+    }
+
+    AND_WHEN("Uploading a large body") {
+      CHECK(wtest::response("POST", "/upload", data) == "match");
+    }
+
+    AND_WHEN("Transferring large bodies with windows over the budget") {
+      // The windows of both ends shrink back to their initial sizes.
+      nghttp2::asio_http2::auto_window_budget(64 * 1024);
+      const auto body = wtest::response("GET", "/download");
+      const auto upload = wtest::response("POST", "/upload", data);
+      nghttp2::asio_http2::auto_window_budget(1024 * 1024 * 1024);
+      CHECK(body == data);
+      CHECK(upload == "match");
+    }
+  }
+}